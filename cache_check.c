@@ -0,0 +1,14 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+uint32_t
+libsha2_cache_check(const struct libsha2_cache_record *record)
+{
+	struct libsha2_cache_record copy = *record;
+	unsigned char h[32];
+
+	copy.check = 0;
+	libsha2_hash(LIBSHA2_256, &copy, sizeof(copy) * 8, h);
+	return (uint32_t)h[0] << 24 | (uint32_t)h[1] << 16 | (uint32_t)h[2] << 8 | (uint32_t)h[3];
+}
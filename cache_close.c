@@ -0,0 +1,13 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_cache_close(struct libsha2_cache *restrict cache)
+{
+	libsha2_cache_reset(cache);
+	close(cache->fd);
+	free(cache->path);
+	cache->fd = -1;
+	cache->path = NULL;
+}
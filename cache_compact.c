@@ -0,0 +1,202 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+
+/**
+ * Write a buffer in full
+ * 
+ * @param   fd   The file descriptor to write to
+ * @param   buf  The buffer
+ * @param   len  The number of bytes to write
+ * @return       Zero on success, -1 on error
+ */
+static int
+write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t r;
+
+	while (len) {
+		r = write(fd, p, len);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += r;
+		len -= (size_t)r;
+	}
+	return 0;
+}
+
+
+/**
+ * Read the valid records in a digest cache file
+ * 
+ * Records that are not on a record boundary, because a write
+ * was cut short, or that have been damaged are skipped, and
+ * the file is scanned byte by byte until the next valid record
+ * 
+ * @param   fd        The file descriptor of the digest cache file
+ * @param   size      The size of the file
+ * @param   recordsp  Output parameter for the records, `NULL` if there are none
+ * @param   np        Output parameter for the number of records
+ * @return            Zero on success, -1 on error
+ */
+static int
+read_records(int fd, size_t size, struct libsha2_cache_record **recordsp, size_t *np)
+{
+	struct libsha2_cache_record *records, r;
+	const unsigned char *data;
+	size_t off, n = 0;
+	void *map;
+
+	*recordsp = NULL;
+	*np = 0;
+	if (size - sizeof(struct libsha2_cache_header) < sizeof(r))
+		return 0;
+
+	records = malloc((size - sizeof(struct libsha2_cache_header)) / sizeof(r) * sizeof(r));
+	if (!records)
+		return -1;
+	map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		free(records);
+		return -1;
+	}
+	data = &((const unsigned char *)map)[sizeof(struct libsha2_cache_header)];
+	size -= sizeof(struct libsha2_cache_header);
+
+	for (off = 0; off + sizeof(r) <= size;) {
+		memcpy(&r, &data[off], sizeof(r));
+		if (r.check == libsha2_cache_check(&r) && r.algorithm <= LIBSHA2_512_256) {
+			records[n++] = r;
+			off += sizeof(r);
+		} else {
+			off += 1;
+		}
+	}
+
+	munmap(map, size + sizeof(struct libsha2_cache_header));
+	*recordsp = records;
+	*np = n;
+	return 0;
+}
+
+
+/**
+ * Remove all but the latest record for each file and algorithm,
+ * keeping the remaining records in their original order
+ * 
+ * @param   records  The records
+ * @param   n        The number of records
+ * @return           The number of remaining records, 0 on error
+ *                   (there is always at least one record)
+ */
+static size_t
+remove_outdated(struct libsha2_cache_record *records, size_t n)
+{
+	size_t i, j, slot, tablesize, *table;
+	const struct libsha2_cache_record *r, *old;
+	char *keep;
+
+	for (tablesize = 1024; tablesize < n * 2; tablesize <<= 1);
+	table = calloc(tablesize, sizeof(*table));
+	keep = calloc(n, 1);
+	if (!table || !keep) {
+		free(table);
+		free(keep);
+		return 0;
+	}
+
+	for (i = n; i--;) {
+		r = &records[i];
+		for (slot = LIBSHA2_CACHE_SLOT(r, tablesize); table[slot]; slot = (slot + 1) & (tablesize - 1)) {
+			old = &records[table[slot] - 1];
+			if (old->dev == r->dev && old->ino == r->ino && old->algorithm == r->algorithm)
+				break;
+		}
+		if (!table[slot]) {
+			table[slot] = i + 1;
+			keep[i] = 1;
+		}
+	}
+
+	for (i = j = 0; i < n; i++)
+		if (keep[i])
+			records[j++] = records[i];
+
+	free(table);
+	free(keep);
+	return j;
+}
+
+
+int
+libsha2_cache_compact(const char *path)
+{
+	struct libsha2_cache_record *records = NULL;
+	struct libsha2_cache_header header;
+	struct stat attr, named;
+	size_t n, len;
+	char *tmppath = NULL;
+	int fd, tmpfd = -1, ret = -1, saved_errno;
+
+	/* Appending processes hold a shared lock, and will
+	 * reopen the file once they see it has been replaced;
+	 * so must we, as another compaction may have replaced
+	 * it while we were waiting for the lock */
+	for (;;) {
+		fd = libsha2_cache_open_file(path);
+		if (fd < 0)
+			return -1;
+		if (flock(fd, LOCK_EX) || fstat(fd, &attr) || stat(path, &named))
+			goto out;
+		if (attr.st_dev == named.st_dev && attr.st_ino == named.st_ino)
+			break;
+		close(fd);
+	}
+	if (read_records(fd, (size_t)attr.st_size, &records, &n))
+		goto out;
+	if (n) {
+		n = remove_outdated(records, n);
+		if (!n)
+			goto out;
+	}
+
+	len = strlen(path);
+	tmppath = malloc(len + sizeof(".XXXXXX"));
+	if (!tmppath)
+		goto out;
+	stpcpy(stpcpy(tmppath, path), ".XXXXXX");
+	tmpfd = mkstemp(tmppath);
+	if (tmpfd < 0)
+		goto out;
+
+	if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+	    fchmod(tmpfd, attr.st_mode & 07777) ||
+	    write_all(tmpfd, &header, sizeof(header)) ||
+	    write_all(tmpfd, records, n * sizeof(*records)) ||
+	    fsync(tmpfd) ||
+	    rename(tmppath, path)) {
+		saved_errno = errno;
+		unlink(tmppath);
+		errno = saved_errno;
+		goto out;
+	}
+	ret = 0;
+
+out:
+	saved_errno = errno;
+	if (tmpfd >= 0)
+		close(tmpfd);
+	close(fd);
+	free(tmppath);
+	free(records);
+	errno = saved_errno;
+	return ret;
+}
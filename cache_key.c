@@ -0,0 +1,17 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_cache_key(struct libsha2_cache_record *record, const struct stat *attr, enum libsha2_algorithm algorithm)
+{
+	memset(record, 0, sizeof(*record));
+	record->dev = (uint64_t)attr->st_dev;
+	record->ino = (uint64_t)attr->st_ino;
+	record->size = (uint64_t)attr->st_size;
+	record->mtime_sec = (int64_t)attr->st_mtim.tv_sec;
+	record->mtime_nsec = (uint32_t)attr->st_mtim.tv_nsec;
+	record->ctime_sec = (int64_t)attr->st_ctim.tv_sec;
+	record->ctime_nsec = (uint32_t)attr->st_ctim.tv_nsec;
+	record->algorithm = (uint32_t)algorithm;
+}
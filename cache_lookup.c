@@ -0,0 +1,28 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+const struct libsha2_cache_record *
+libsha2_cache_lookup(const struct libsha2_cache *cache, const struct libsha2_cache_record *key)
+{
+	const struct libsha2_cache_record *records, *r;
+	size_t i;
+
+	if (!cache->tablesize)
+		return NULL;
+	records = (const void *)&cache->map[sizeof(struct libsha2_cache_header)];
+
+	for (i = LIBSHA2_CACHE_SLOT(key, cache->tablesize); cache->table[i]; i = (i + 1) & (cache->tablesize - 1)) {
+		r = &records[cache->table[i] - 1];
+		if (r->dev != key->dev || r->ino != key->ino || r->algorithm != key->algorithm)
+			continue;
+		/* Only the latest record for a file is indexed */
+		if (r->size != key->size ||
+		    r->mtime_sec != key->mtime_sec || r->mtime_nsec != key->mtime_nsec ||
+		    r->ctime_sec != key->ctime_sec || r->ctime_nsec != key->ctime_nsec)
+			return NULL;
+		return r->check == libsha2_cache_check(r) ? r : NULL;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,29 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_cache_open(struct libsha2_cache *restrict cache, const char *path)
+{
+	int saved_errno;
+
+	memset(cache, 0, sizeof(*cache));
+	cache->path = strdup(path);
+	if (!cache->path)
+		return -1;
+	cache->fd = libsha2_cache_open_file(path);
+	if (cache->fd < 0)
+		goto fail;
+	if (libsha2_cache_refresh(cache)) {
+		saved_errno = errno;
+		close(cache->fd);
+		errno = saved_errno;
+		goto fail;
+	}
+	return 0;
+
+fail:
+	free(cache->path);
+	cache->path = NULL;
+	return -1;
+}
@@ -0,0 +1,58 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/file.h>
+#include <fcntl.h>
+
+
+int
+libsha2_cache_open_file(const char *path)
+{
+	struct libsha2_cache_header header, expected;
+	struct stat attr;
+	ssize_t r;
+	int fd, saved_errno;
+
+	memset(&expected, 0, sizeof(expected));
+	memcpy(expected.magic, LIBSHA2_CACHE_MAGIC, sizeof(LIBSHA2_CACHE_MAGIC));
+	expected.byteorder = 0x01020304UL;
+	expected.record_size = (uint32_t)sizeof(struct libsha2_cache_record);
+
+	/* The cache decides which files are read, so it
+	 * must not be writable by anyone else */
+	fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+	if (fd < 0)
+		return -1;
+	if (flock(fd, LOCK_EX) || fstat(fd, &attr))
+		goto fail;
+
+	if (!attr.st_size) {
+		r = write(fd, &expected, sizeof(expected));
+		if (r != (ssize_t)sizeof(expected)) {
+			if (r >= 0)
+				errno = ENOSPC;
+			saved_errno = errno;
+			if (ftruncate(fd, 0))
+				errno = saved_errno;
+			goto fail;
+		}
+	} else {
+		do
+			r = pread(fd, &header, sizeof(header), 0);
+		while (r < 0 && errno == EINTR);
+		if (r < 0)
+			goto fail;
+		if (r != (ssize_t)sizeof(header) || memcmp(&header, &expected, sizeof(header))) {
+			errno = EINVAL;
+			goto fail;
+		}
+	}
+
+	flock(fd, LOCK_UN);
+	return fd;
+
+fail:
+	saved_errno = errno;
+	close(fd);
+	errno = saved_errno;
+	return -1;
+}
@@ -0,0 +1,86 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/mman.h>
+
+
+/**
+ * Add a record to the hash table, replacing any
+ * record for the same file and algorithm
+ * 
+ * @param  cache  The digest cache, with room in the table
+ * @param  i      The index of the record
+ */
+static void
+insert(struct libsha2_cache *cache, size_t i)
+{
+	const struct libsha2_cache_record *records, *r, *old;
+	size_t slot;
+
+	records = (const void *)&cache->map[sizeof(struct libsha2_cache_header)];
+	r = &records[i];
+	for (slot = LIBSHA2_CACHE_SLOT(r, cache->tablesize); cache->table[slot];
+	     slot = (slot + 1) & (cache->tablesize - 1)) {
+		old = &records[cache->table[slot] - 1];
+		if (old->dev == r->dev && old->ino == r->ino && old->algorithm == r->algorithm) {
+			cache->table[slot] = i + 1;
+			return;
+		}
+	}
+	cache->table[slot] = i + 1;
+	cache->used += 1;
+}
+
+
+int
+libsha2_cache_refresh(struct libsha2_cache *cache)
+{
+	struct stat attr;
+	size_t n, i, size, tablesize, *table, *old_table, old_tablesize;
+	void *map;
+
+	if (fstat(cache->fd, &attr))
+		return -1;
+	if ((uintmax_t)attr.st_size < sizeof(struct libsha2_cache_header) + cache->nrecords * sizeof(struct libsha2_cache_record)) {
+		/* The file has been truncated */
+		libsha2_cache_reset(cache);
+		if ((size_t)attr.st_size < sizeof(struct libsha2_cache_header))
+			return 0;
+	}
+	n = ((size_t)attr.st_size - sizeof(struct libsha2_cache_header)) / sizeof(struct libsha2_cache_record);
+	if (n == cache->nrecords)
+		return 0;
+
+	/* The file is mapped with room to grow, so that it
+	 * does not have to be remapped for every record */
+	if ((size_t)attr.st_size > cache->mapsize) {
+		for (size = (size_t)1 << 16; size < (size_t)attr.st_size; size <<= 1);
+		map = mmap(NULL, size, PROT_READ, MAP_SHARED, cache->fd, 0);
+		if (map == MAP_FAILED)
+			return -1;
+		if (cache->map)
+			munmap((void *)cache->map, cache->mapsize);
+		cache->map = map;
+		cache->mapsize = size;
+	}
+
+	if ((n - cache->nrecords + cache->used) * 2 > cache->tablesize) {
+		for (tablesize = 1024; tablesize < (n + cache->used) * 2; tablesize <<= 1);
+		table = calloc(tablesize, sizeof(*table));
+		if (!table)
+			return -1;
+		old_table = cache->table;
+		old_tablesize = cache->tablesize;
+		cache->table = table;
+		cache->tablesize = tablesize;
+		cache->used = 0;
+		for (i = 0; i < old_tablesize; i++)
+			if (old_table[i])
+				insert(cache, old_table[i] - 1);
+		free(old_table);
+	}
+
+	for (i = cache->nrecords; i < n; i++)
+		insert(cache, i);
+	cache->nrecords = n;
+	return 0;
+}
@@ -0,0 +1,18 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/mman.h>
+
+
+void
+libsha2_cache_reset(struct libsha2_cache *cache)
+{
+	if (cache->map)
+		munmap((void *)cache->map, cache->mapsize);
+	free(cache->table);
+	cache->map = NULL;
+	cache->mapsize = 0;
+	cache->nrecords = 0;
+	cache->table = NULL;
+	cache->tablesize = 0;
+	cache->used = 0;
+}
@@ -0,0 +1,151 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/file.h>
+#include <time.h>
+
+
+/**
+ * The number of seconds a file must have been left
+ * unmodified for its hash to be stored
+ */
+#ifndef SETTLE_TIME
+# define SETTLE_TIME 2
+#endif
+
+
+/**
+ * Check whether a file may have been modified after its hash
+ * was calculated without its timestamps having changed
+ * 
+ * @param   before  The file's attributes before it was hashed
+ * @param   after   The file's attributes after it was hashed
+ * @return          1 if the hash must not be stored, 0 otherwise
+ */
+static int
+is_racy(const struct stat *before, const struct stat *after)
+{
+	struct timespec now;
+
+	if (before->st_size != after->st_size || before->st_ino != after->st_ino ||
+	    before->st_mtim.tv_sec != after->st_mtim.tv_sec || before->st_mtim.tv_nsec != after->st_mtim.tv_nsec ||
+	    before->st_ctim.tv_sec != after->st_ctim.tv_sec || before->st_ctim.tv_nsec != after->st_ctim.tv_nsec)
+		return 1;
+
+	/* A modification within the granularity of the file system's
+	 * timestamps is not visible, so a file that was modified
+	 * just now could be modified again without it showing; the
+	 * status change time is used, as the modification time can
+	 * be set to anything, and every modification updates both */
+	if (clock_gettime(CLOCK_REALTIME, &now))
+		return 1;
+	return now.tv_sec - after->st_ctim.tv_sec < SETTLE_TIME;
+}
+
+
+/**
+ * Reopen a digest cache file if it has been
+ * replaced, which compaction does
+ * 
+ * @param   cache  The digest cache
+ * @return         1 if the file has not been replaced,
+ *                 0 if it has been reopened, -1 on error
+ */
+static int
+reopen_if_replaced(struct libsha2_cache *restrict cache)
+{
+	struct stat a, b;
+	int fd;
+
+	if (stat(cache->path, &a) || fstat(cache->fd, &b))
+		return -1;
+	if (a.st_dev == b.st_dev && a.st_ino == b.st_ino)
+		return 1;
+	fd = libsha2_cache_open_file(cache->path);
+	if (fd < 0)
+		return -1;
+	close(cache->fd);
+	cache->fd = fd;
+	libsha2_cache_reset(cache);
+	return 0;
+}
+
+
+/**
+ * Append a record to a digest cache file
+ * 
+ * Failures are ignored, as they only cause the file
+ * to be hashed again next time
+ * 
+ * @param  cache   The digest cache
+ * @param  record  The record
+ */
+static void
+append(struct libsha2_cache *restrict cache, const struct libsha2_cache_record *record)
+{
+	static const struct libsha2_cache_record zero;
+	ssize_t r;
+
+	/* The shared lock keeps out compaction, which could otherwise
+	 * replace the file between the check and the write */
+	for (;;) {
+		if (flock(cache->fd, LOCK_SH))
+			return;
+		r = reopen_if_replaced(cache);
+		if (r > 0)
+			break;
+		flock(cache->fd, LOCK_UN);
+		if (r < 0)
+			return;
+	}
+
+	/* With O_APPEND, each record is written whole at the end of
+	 * the file even when other processes are appending at the same
+	 * time. A short write is padded so that the records that
+	 * follow stay aligned; the padding fails the check, and
+	 * should that fail too, compaction finds the records again. */
+	do
+		r = write(cache->fd, record, sizeof(*record));
+	while (r < 0 && errno == EINTR);
+	if (r > 0 && (size_t)r < sizeof(*record))
+		r = write(cache->fd, &zero, sizeof(*record) - (size_t)r);
+
+	flock(cache->fd, LOCK_UN);
+}
+
+
+int
+libsha2_cache_sum_fd(struct libsha2_cache *restrict cache, int fd, enum libsha2_algorithm algorithm, void *restrict hashsum)
+{
+	struct libsha2_cache_record key;
+	const struct libsha2_cache_record *record;
+	struct stat before, after;
+	size_t outsize;
+
+	if (fstat(fd, &before))
+		return -1;
+	if (!S_ISREG(before.st_mode))
+		return libsha2_sum_fd(fd, algorithm, hashsum);
+	outsize = libsha2_algorithm_output_size(algorithm);
+	if (!outsize)
+		return -1;
+
+	libsha2_cache_key(&key, &before, algorithm);
+	record = libsha2_cache_lookup(cache, &key);
+	if (!record && reopen_if_replaced(cache) >= 0 && !libsha2_cache_refresh(cache))
+		record = libsha2_cache_lookup(cache, &key);
+	if (record) {
+		memcpy(hashsum, record->digest, outsize);
+		return 0;
+	}
+
+	if (lseek(fd, 0, SEEK_SET) < 0 || libsha2_sum_fd(fd, algorithm, hashsum))
+		return -1;
+
+	if (fstat(fd, &after) || is_racy(&before, &after))
+		return 0;
+	memcpy(key.digest, hashsum, outsize);
+	key.check = libsha2_cache_check(&key);
+	append(cache, &key);
+	libsha2_cache_refresh(cache);
+	return 0;
+}
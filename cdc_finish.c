@@ -0,0 +1,22 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+size_t
+libsha2_cdc_finish(struct libsha2_cdc *restrict cdc, struct libsha2_cdc_chunk *restrict chunk)
+{
+	size_t ret = 0;
+
+	if (cdc->length) {
+		chunk->offset = cdc->offset;
+		chunk->length = cdc->length;
+		libsha2_digest(&cdc->state, NULL, 0, chunk->digest);
+		libsha2_init(&cdc->state, cdc->state.algorithm);
+		ret = 1;
+	}
+
+	cdc->offset = 0;
+	cdc->fingerprint = 0;
+	cdc->length = 0;
+	return ret;
+}
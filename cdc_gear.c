@@ -0,0 +1,70 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+const uint_least64_t libsha2_cdc_gear[256] = {
+	0x6E340B9CFFB37A98ULL, 0x4BF5122F344554C5ULL, 0xDBC1B4C900FFE48DULL, 0x084FED08B978AF4DULL,
+	0xE52D9C508C502347ULL, 0xE77B9A9AE9E30B0DULL, 0x67586E98FAD27DA0ULL, 0xCA358758F6D27E6CULL,
+	0xBEEAD77994CF5733ULL, 0x2B4C342F5433EBE5ULL, 0x01BA4719C80B6FE9ULL, 0xE7CF46A078FED4FAULL,
+	0xEF6CBD2161EAEA79ULL, 0x9D1E0E2D9459D065ULL, 0x4D7B3EF7300ACF70ULL, 0xDC0E9C3658A1A3EDULL,
+	0xC555EAB45D08845AULL, 0x4A64A107F0CB3253ULL, 0xF299791CDDD3D666ULL, 0xAB897FBDEDFA502BULL,
+	0x83891D7FE85C33E5ULL, 0x2F0FD1E89B8DE1D5ULL, 0x7CB7C4547CF26535ULL, 0x8F11B05DA785E43EULL,
+	0x452BA1DDEF80246CULL, 0x68AA2E2EE5DFF96EULL, 0x58F7B0780592032EULL, 0x77ADFC95029E73B1ULL,
+	0xBD4FC42A21F1F860ULL, 0x1F18D650D205D71DULL, 0x9652595F37EDD08CULL, 0xFFE679BB831C95B6ULL,
+	0x36A9E7F1C95B82FFULL, 0xBB7208BC9B5D7C04ULL, 0x8A331FDDE7032F33ULL, 0x334359B90EFED75DULL,
+	0x09FC96082D34C2DFULL, 0xBBF3F11CB5B43E70ULL, 0x951DCEE3A7A4F3AAULL, 0x265FDA17A34611B1ULL,
+	0x32EBB1ABCC1C601CULL, 0xBA5EC51D07A4AC0EULL, 0x684888C0EBB17F37ULL, 0xA318C24216DEFE20ULL,
+	0xD03502C43D74A30BULL, 0x3973E022E93220F9ULL, 0xCDB4EE2AEA69CC6AULL, 0x8A5EDAB282632443ULL,
+	0x5FECEB66FFC86F38ULL, 0x6B86B273FF34FCE1ULL, 0xD4735E3A265E16EEULL, 0x4E07408562BEDB8BULL,
+	0x4B227777D4DD1FC6ULL, 0xEF2D127DE37B942BULL, 0xE7F6C011776E8DB7ULL, 0x7902699BE42C8A8EULL,
+	0x2C624232CDD22177ULL, 0x19581E27DE7CED00ULL, 0xE7AC0786668E0FF0ULL, 0x41B805EA7AC014E2ULL,
+	0xDABD3AFF769F07EBULL, 0x380918B946A52664ULL, 0x62B67E1F685B7FEFULL, 0x8A8DE823D5ED3E12ULL,
+	0xC3641F8544D7C02FULL, 0x559AEAD08264D579ULL, 0xDF7E70E5021544F4ULL, 0x6B23C0D5F35D1B11ULL,
+	0x3F39D5C348E5B79DULL, 0xA9F51566BD6705F7ULL, 0xF67AB10AD4E4C531ULL, 0x333E0A1E27815D0CULL,
+	0x44BD7AE60F478FAEULL, 0xA83DD0CCBFFE39D0ULL, 0x6DA43B944E494E88ULL, 0x86BE9A55762D316AULL,
+	0x72DFCFB0C470AC25ULL, 0x08F271887CE94707ULL, 0x8CE86A6AE65D3692ULL, 0xC4694F2E93D5C4E7ULL,
+	0x5C62E091B8C0565FULL, 0x4AE81572F06E1B88ULL, 0x8C2574892063F995ULL, 0x8DE0B3C47F112C59ULL,
+	0xE632B7095B0BF32CULL, 0xA25513C7E0F6EAA8ULL, 0xDE5A6F78116ECA62ULL, 0xFCB5F40DF9BE6BAEULL,
+	0x4B68AB3847FEDA7DULL, 0x18F5384D58BCB1BBULL, 0xBBEEBD879E1DFF69ULL, 0x245843ABEF9E72E7ULL,
+	0xA9253DC8529DD214ULL, 0xCFAE0D4248F7142FULL, 0x74CD9EF9C7E15F57ULL, 0xD2E2ADF7177B7A8AULL,
+	0x8D33F520A3C4CEF8ULL, 0xCA978112CA1BBDCAULL, 0x3E23E8160039594AULL, 0x2E7D2C03A9507AE2ULL,
+	0x18AC3E7343F01689ULL, 0x3F79BB7B435B0532ULL, 0x252F10C83610EBCAULL, 0xCD0AA9856147B6C5ULL,
+	0xAAA9402664F1A41FULL, 0xDE7D1B721A1E0632ULL, 0x189F40034BE7A199ULL, 0x8254C329A92850F6ULL,
+	0xACAC86C0E609CA90ULL, 0x62C66A7A5DD70C31ULL, 0x1B16B1DF538BA12DULL, 0x65C74C15A686187BULL,
+	0x148DE9C5A7A44D19ULL, 0x8E35C2CD3BF6641BULL, 0x454349E422F05297ULL, 0x043A718774C572BDULL,
+	0xE3B98A4DA31A127DULL, 0x0BFE935E70C321C7ULL, 0x4C94485E0C21AE6CULL, 0x50E721E49C013F00ULL,
+	0x2D711642B726B044ULL, 0xA1FCE4363854FF88ULL, 0x594E519AE499312BULL, 0x021FB596DB81E6D0ULL,
+	0xCBE5CFDF7C2118A9ULL, 0xD10B36AA74A59BCFULL, 0x7ACE431CB61584CBULL, 0x620BFDAA346B088FULL,
+	0x76BE8B528D0075F7ULL, 0x591B7CC95037822DULL, 0xA5AB782C805E8BFBULL, 0x5EE0DD4D4840229FULL,
+	0xAAA8E61E7FAF37DDULL, 0xC00E7F889CFC9216ULL, 0x3CBDAF66B3DD2B17ULL, 0x4BFA260A661D6811ULL,
+	0x4F362F9093BB8E70ULL, 0xE9B0C031F0493D3FULL, 0x2D31936919341244ULL, 0x3EBE1B59762A1C80ULL,
+	0x9DEFB0A9E163278BULL, 0x075198BFE61765D3ULL, 0x949F94D858EF6AD1ULL, 0x5E37305C587CAF07ULL,
+	0x9E076CEAF246B600ULL, 0x7DA59D0DFBE21F43ULL, 0x956062137518B270ULL, 0xD16BD22F7196C0A7ULL,
+	0x67C872D4912C71F1ULL, 0x5BAD0D1132AC152CULL, 0x84873854DBA02CF6ULL, 0x2A0AB732B4E9D85EULL,
+	0x79BEC7FF3E69D1B4ULL, 0xFD9528B920D6D395ULL, 0x0605D1534EB8995FULL, 0x8D36BBB3D6FBF24FULL,
+	0x6E3FAF1E27D45FCAULL, 0x9D277175737FB500ULL, 0x35AF2D15EBDE4D67ULL, 0x1F184F101C67D585ULL,
+	0xC19A797FA1FD590CULL, 0x8A8950F762366322ULL, 0x0A43B22D89FA2499ULL, 0x6D90FBACC073EE0BULL,
+	0x88AA3E3B1F22C616ULL, 0x6922E93E3827642CULL, 0xFE1DCD3ABFCD6B16ULL, 0x2DBF9365A0B09D85ULL,
+	0x74E1ADE320C66075ULL, 0x9E8E8C37A53BAC77ULL, 0xBCEEF655B5A03491ULL, 0x087D80F7F182DD44ULL,
+	0xEE6BB86B44339392ULL, 0x22ADAF058A2CB668ULL, 0x19753A9B7681B361ULL, 0x5A6E7A4754AF8E7FULL,
+	0xF4F97C88C409DCF3ULL, 0x149488D869CBEF08ULL, 0x9BE3799F24592E94ULL, 0x65F15821061635E6ULL,
+	0x27952171C7FCDF0DULL, 0x892F60B39450A0E7ULL, 0xCA41841C5C98E34FULL, 0x4D6A8E90039FC978ULL,
+	0xD3BB0D59E354EA84ULL, 0x04D6C0C946716AACULL, 0x281C93990BAC2C69ULL, 0xCBECDA1C7D37D4C0ULL,
+	0x26E5BFE4B0686167ULL, 0x68325720AABD7C82ULL, 0x478508483CBB05DEULL, 0xB12DC850A3B0A3B7ULL,
+	0xE4FF5E7D7A7F08E9ULL, 0xD1BBD73BB09190BFULL, 0xC557E71380112B98ULL, 0xAE3F4619B0413D70ULL,
+	0xD1211001882D2CE1ULL, 0x5A0EC31DAA84FA27ULL, 0x49994461D6B46390ULL, 0x3340883AAD3038DDULL,
+	0x7C5BD2D144FDDE49ULL, 0x4FB733BEDB74FEC8ULL, 0x13598656F10FA962ULL, 0x383E5D7D58CAA41CULL,
+	0x1DD8312636F6A0BFULL, 0x9A7B7B3A5D50781BULL, 0xC337DED6F56C0720ULL, 0x7A4A4B50F5121ED5ULL,
+	0xD4B0C0A4A8CC6C25ULL, 0xB5C9A5F48292E3FBULL, 0x85F97E04D754C81DULL, 0x28969CDFA74A12C8ULL,
+	0x528A84CE6B18EB7DULL, 0xCDCE9374E0FECEE1ULL, 0x0A2C6EA0370D1D49ULL, 0x414A21E525A759E3ULL,
+	0xAF193A8CDCD0E3FBULL, 0x19152DDFBA193B5BULL, 0x5D5C7D20A3AAB9C1ULL, 0xB7D25296E7BC6A6BULL,
+	0xFB95AA98D6E6C582ULL, 0x2795044CE0F83F71ULL, 0x7941CB07924FDC7BULL, 0x2EA970FF63AEC5D7ULL,
+	0x7D8C5DA7FD418379ULL, 0xF031EFA58744E97AULL, 0x30A5BFA58E128AF9ULL, 0x457E4854863E7EFAULL,
+	0x5E1EFFE9B7BAB73DULL, 0xAB61BA11A38B007FULL, 0x0A3AAEE7CCFB1A64ULL, 0xD0752B60ADB148CAULL,
+	0xE6F207509AFA3908ULL, 0xDE2E331D891AE267ULL, 0x3AD4E44A4306FB62ULL, 0xF8D20E598DF20877ULL,
+	0x45F83D17E10B34FCULL, 0xF3DF1F9C358AE8ECULL, 0x94455E3ED9F716BEULL, 0x4D4D75D742863AB9ULL,
+	0xFDE502858306C235ULL, 0xD4F09E5C5AF99A24ULL, 0x966C7C47125C7457ULL, 0x782E02029374527BULL,
+	0x2017FF3461395672ULL, 0x27ABDEDDFE850349ULL, 0xB0B2988B6BBE724BULL, 0x50868F20258BBC9CULL,
+	0xE596A8E5C49DD20AULL, 0xD52022534FA2DBA3ULL, 0xAA7225E7D5B0A255ULL, 0x04B8D34E20E604CAULL,
+	0x98722E2EBED8ED3DULL, 0x3E151409ACE91CB3ULL, 0xAA687B58B0E73E2EULL, 0xA8100AE6AA1940D0ULL
+};
@@ -0,0 +1,62 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Create a mask with a number of set bits, spread out
+ * over the high bits, and none in the low 16 bits, as
+ * only the high bits of the rolling hash depend on
+ * enough bytes
+ * 
+ * @param   bits  The number of set bits, at most 48
+ * @return        The mask
+ */
+static uint_least64_t
+make_mask(unsigned bits)
+{
+	uint_least64_t mask = 0;
+	unsigned i;
+
+	for (i = 0; i < bits; i++)
+		mask |= (uint_least64_t)1 << (63 - i * 48 / bits);
+	return mask;
+}
+
+
+int
+libsha2_cdc_init(struct libsha2_cdc *restrict cdc, enum libsha2_algorithm algorithm,
+                 size_t min_size, size_t avg_size, size_t max_size)
+{
+	unsigned bits = 0;
+
+	if (!min_size)
+		min_size = 2048;
+	if (!avg_size)
+		avg_size = 8192;
+	if (!max_size)
+		max_size = 65536;
+
+	if (avg_size < 64 || avg_size > ((size_t)1 << 30) || (avg_size & (avg_size - 1)) ||
+	    min_size > avg_size || avg_size > max_size || max_size > SIZE_MAX / 8) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (libsha2_init(&cdc->state, algorithm))
+		return -1;
+
+	while ((size_t)1 << bits < avg_size)
+		bits++;
+
+	/* Normalised chunking, level 2: cuts are made harder to find
+	 * before the normal size, and easier after, which narrows
+	 * the distribution of chunk sizes around the normal size */
+	cdc->mask_small = make_mask(bits + 2);
+	cdc->mask_large = make_mask(bits - 2);
+	cdc->offset = 0;
+	cdc->fingerprint = 0;
+	cdc->length = 0;
+	cdc->min_size = min_size;
+	cdc->avg_size = avg_size;
+	cdc->max_size = max_size;
+	return 0;
+}
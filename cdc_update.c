@@ -0,0 +1,168 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * The number of chunks hashed together, few enough that
+ * the chunks are still in the cache from the scan
+ */
+#define BATCH 16
+
+
+/**
+ * Chunks that are wholly within the data, and not yet hashed
+ */
+struct batch {
+	/**
+	 * The number of chunks in the batch
+	 */
+	size_t n;
+
+	/**
+	 * The output record of each chunk
+	 */
+	struct libsha2_cdc_chunk *chunks[BATCH];
+
+	/**
+	 * The content of each chunk
+	 */
+	const void *messages[BATCH];
+
+	/**
+	 * The length of each chunk, in bits
+	 */
+	size_t msglens[BATCH];
+
+	/**
+	 * The hashes of the chunks
+	 */
+	unsigned char outputs[BATCH * 64];
+};
+
+
+/**
+ * Hash the chunks in a batch and empty the batch
+ * 
+ * @param  algorithm  The hashing algorithm
+ * @param  batch      The batch
+ */
+static void
+flush(enum libsha2_algorithm algorithm, struct batch *batch)
+{
+	size_t i, outsize;
+
+	if (!batch->n)
+		return;
+	outsize = libsha2_algorithm_output_size(algorithm);
+	libsha2_digest_many(algorithm, batch->messages, batch->msglens, batch->n, batch->outputs);
+	for (i = 0; i < batch->n; i++)
+		memcpy(batch->chunks[i]->digest, &batch->outputs[i * outsize], outsize);
+	batch->n = 0;
+}
+
+
+/**
+ * Scan data for the end of the current chunk
+ * 
+ * @param   cdc   The state, the chunk's length and the
+ *                rolling hash are updated
+ * @param   data  The data
+ * @param   len   The length of the data
+ * @param   cut   Output parameter for whether the chunk ends
+ * @return        The number of bytes that belong to the chunk
+ */
+static size_t
+find_cut(struct libsha2_cdc *restrict cdc, const unsigned char *data, size_t len, int *cut)
+{
+	uint_least64_t fp = cdc->fingerprint;
+	size_t i = 0, n = cdc->length, end, skip;
+
+	*cut = 0;
+
+	/* No cut is made before the minimum size,
+	 * so those bytes are not even looked at */
+	if (n < cdc->min_size) {
+		skip = cdc->min_size - n < len ? cdc->min_size - n : len;
+		i += skip;
+		n += skip;
+	}
+
+	if (n < cdc->avg_size) {
+		end = i + (cdc->avg_size - n < len - i ? cdc->avg_size - n : len - i);
+		for (; i < end; i++) {
+			fp = (fp << 1) + libsha2_cdc_gear[data[i]];
+			if (!(fp & cdc->mask_small)) {
+				*cut = 1;
+				i++;
+				goto out;
+			}
+		}
+		n = cdc->length + i;
+	}
+
+	end = i + (cdc->max_size - n < len - i ? cdc->max_size - n : len - i);
+	for (; i < end; i++) {
+		fp = (fp << 1) + libsha2_cdc_gear[data[i]];
+		if (!(fp & cdc->mask_large)) {
+			*cut = 1;
+			i++;
+			goto out;
+		}
+	}
+	if (cdc->length + i == cdc->max_size)
+		*cut = 1;
+
+out:
+	cdc->fingerprint = fp & UINT64_C(0xFFFFFFFFFFFFFFFF);
+	cdc->length += i;
+	return i;
+}
+
+
+size_t
+libsha2_cdc_update(struct libsha2_cdc *restrict cdc, const void *data_, size_t len,
+                   struct libsha2_cdc_chunk *restrict chunks, size_t *nchunks)
+{
+	const unsigned char *data = data_;
+	struct batch batch;
+	struct libsha2_cdc_chunk *chunk;
+	size_t i = 0, start = 0, max = *nchunks, n = 0;
+	int cut;
+
+	batch.n = 0;
+	while (i < len && n < max) {
+		i += find_cut(cdc, &data[i], len - i, &cut);
+		if (!cut)
+			break;
+
+		chunk = &chunks[n++];
+		chunk->offset = cdc->offset;
+		chunk->length = cdc->length;
+		if (cdc->length > i - start) {
+			/* The chunk began in an earlier call */
+			libsha2_update(&cdc->state, &data[start], (i - start) * 8);
+			libsha2_digest(&cdc->state, NULL, 0, chunk->digest);
+			libsha2_init(&cdc->state, cdc->state.algorithm);
+		} else {
+			batch.chunks[batch.n] = chunk;
+			batch.messages[batch.n] = &data[start];
+			batch.msglens[batch.n] = (i - start) * 8;
+			if (++batch.n == BATCH)
+				flush(cdc->state.algorithm, &batch);
+		}
+
+		cdc->offset += cdc->length;
+		cdc->length = 0;
+		cdc->fingerprint = 0;
+		start = i;
+	}
+	flush(cdc->state.algorithm, &batch);
+
+	/* The rest of the data begins a chunk that
+	 * will end in a later call, or at the end */
+	if (start < i)
+		libsha2_update(&cdc->state, &data[start], (i - start) * 8);
+
+	*nchunks = n;
+	return i;
+}
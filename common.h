@@ -14,6 +14,23 @@
 # define ALLOCA_LIMIT 0
 #endif
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define HAVE_X86_AVX2_INTRINSICS
+# define HAVE_X86_AVX512_INTRINSICS
+# define HAVE_X86_SHA_NI_INTRINSICS
+#endif
+
+#if defined(__linux__) && defined(__GNUC__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  define HAVE_LINUX_IO_URING
+# endif
+#endif
+
+#define X86_FEATURE_AVX2   1
+#define X86_FEATURE_AVX512 2
+#define X86_FEATURE_BMI2   4
+#define X86_FEATURE_SHA_NI 8
+
 
 /**
  * Truncate an unsigned integer to an unsigned 32-bit integer
@@ -44,3 +61,978 @@
 __attribute__((__nonnull__, __nothrow__))
 #endif
 size_t libsha2_process(struct libsha2_state *restrict, const unsigned char *restrict, size_t);
+
+/**
+ * Process chunks using SHA-224 or SHA-256, without
+ * any instruction set extensions
+ * 
+ * @param  h       The hash values, updated in place
+ * @param  data    The data to process
+ * @param  chunks  The number of 64-byte chunks in `data`
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_process_portable_sha256(uint_least32_t *restrict, const unsigned char *restrict, size_t);
+
+/**
+ * Process chunks using SHA-384, SHA-512, SHA-512/224,
+ * or SHA-512/256, without any instruction set extensions
+ * 
+ * @param  h       The hash values, updated in place
+ * @param  data    The data to process
+ * @param  chunks  The number of 128-byte chunks in `data`
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_process_portable_sha512(uint_least64_t *restrict, const unsigned char *restrict, size_t);
+
+/**
+ * Calculate the SHA-256 hashes of 64-byte messages, or the
+ * SHA-256 hashes of their SHA-256 hashes, with the message
+ * schedule of the padding chunk precomputed
+ * 
+ * @param  out    Output buffer for the hashes, 32 bytes per message
+ * @param  data   The messages, 64 bytes each, one after another
+ * @param  n      The number of messages
+ * @param  twice  Whether the hashes shall be hashed again
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_fixed_portable_sha256(unsigned char *restrict, const unsigned char *restrict, size_t, int);
+
+/**
+ * The functions selected for the machine, see `libsha2_resolve_dispatch`
+ */
+struct libsha2_dispatch {
+	/**
+	 * Function for processing chunks of one
+	 * message using SHA-224 or SHA-256
+	 */
+	void (*process32)(uint_least32_t *restrict, const unsigned char *restrict, size_t);
+
+	/**
+	 * Function for processing chunks of one message using
+	 * SHA-384, SHA-512, SHA-512/224, or SHA-512/256
+	 */
+	void (*process64)(uint_least64_t *restrict, const unsigned char *restrict, size_t);
+
+	/**
+	 * Function for processing chunks of multiple messages
+	 * in parallel using SHA-224 or SHA-256, `NULL` if none
+	 */
+	void (*multi32)(void *const *, const unsigned char *const *, size_t);
+
+	/**
+	 * Function for processing chunks of multiple messages in parallel
+	 * using SHA-384, SHA-512, SHA-512/224, or SHA-512/256, `NULL` if none
+	 */
+	void (*multi64)(void *const *, const unsigned char *const *, size_t);
+
+	/**
+	 * The number of messages `multi32` processes, 0 if none
+	 */
+	size_t lanes32;
+
+	/**
+	 * The number of messages `multi64` processes, 0 if none
+	 */
+	size_t lanes64;
+
+	/**
+	 * Function for calculating the SHA-256 hashes, or
+	 * double SHA-256 hashes, of 64-byte messages
+	 */
+	void (*fixed32)(unsigned char *restrict, const unsigned char *restrict, size_t, int);
+
+	/**
+	 * Function for calculating the SHA-256 hashes, or double
+	 * SHA-256 hashes, of `fixed_lanes32` 64-byte messages in
+	 * parallel, `NULL` if none
+	 */
+	void (*fixed_multi32)(unsigned char *restrict, const unsigned char *restrict, int);
+
+	/**
+	 * The number of messages `fixed_multi32` processes, 0 if none
+	 */
+	size_t fixed_lanes32;
+
+	/**
+	 * The names of the back ends used for each of the functions,
+	 * as returned by `libsha2_get_backend`
+	 */
+	const char *name32, *name64, *multi_name32, *multi_name64;
+};
+
+/**
+ * The functions selected for the machine
+ * 
+ * `.process32` and `.process64` are always
+ * safe to call, the other members are only
+ * valid after `libsha2_resolve_dispatch`
+ * has been called
+ */
+extern struct libsha2_dispatch libsha2_dispatch;
+
+/**
+ * Select the functions to use, unless already done
+ * 
+ * This is called automatically when the library is
+ * loaded, or when `libsha2_dispatch.process32` or
+ * `libsha2_dispatch.process64` is first called;
+ * the back ends may be restricted with the
+ * `LIBSHA2_BACKEND` environment variable
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+void libsha2_resolve_dispatch(void);
+
+/**
+ * Select the functions to use
+ * 
+ * @param   backend  See `libsha2_set_backend`
+ * @return           See `libsha2_set_backend`
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+int libsha2_set_dispatch(const char *);
+
+
+/**
+ * Round constants for the 32-bit algorithms
+ */
+extern const uint_least32_t libsha2_k32[64];
+
+/**
+ * Round constants for the 64-bit algorithms
+ */
+extern const uint_least64_t libsha2_k64[80];
+
+/**
+ * Initial state for SHA-256
+ */
+extern const uint_least32_t libsha2_h256[8];
+
+/**
+ * The message schedule of the padding chunk
+ * of a 64-byte message for SHA-224 and SHA-256
+ */
+extern const uint_least32_t libsha2_sha256_pad64_w[64];
+
+/**
+ * Gear table for content-defined chunking, the `i`:th
+ * value is the first 8 bytes, as a big-endian integer,
+ * of the SHA-256 hash of the byte `i`
+ */
+extern const uint_least64_t libsha2_cdc_gear[256];
+
+
+/**
+ * A message queued for multi-buffer processing
+ */
+struct libsha2_job {
+	/**
+	 * The hash values, updated in place;
+	 * `uint_least32_t[8]` for 32-bit algorithms
+	 * and `uint_least64_t[8]` for 64-bit algorithms
+	 */
+	void *h;
+
+	/**
+	 * The data to process, in up to three
+	 * separate parts, each containing a
+	 * whole number of chunks
+	 */
+	const unsigned char *data[3];
+
+	/**
+	 * The number of chunks in each element of `.data`
+	 */
+	size_t chunks[3];
+};
+
+
+/**
+ * Append the padding to a message
+ * 
+ * Before the function is called, the `message_size / 8 % chunk_size`
+ * first bytes of `buf` shall hold the last whole bytes of the message,
+ * and if `message_size` is not a multiple of 8, the byte after them
+ * shall hold the remaining bits as its most significant bits
+ * 
+ * @param   buf           The last partial chunk of the message, must
+ *                        have an allocation size of `2 * chunk_size`
+ * @param   message_size  The size of the entire message, in bits
+ * @param   chunk_size    The size of the chunks, in bytes
+ * @return                The number of bytes in `buf` to process,
+ *                        either `chunk_size` or `2 * chunk_size`
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+size_t libsha2_pad(unsigned char *restrict, size_t, size_t);
+
+/**
+ * Store hash values in big-endian byte order
+ * 
+ * @param  output     The output buffer, will be filled
+ *                    with `libsha2_algorithm_output_size(algorithm)`
+ *                    bytes
+ * @param  h          The hash values, `uint_least32_t[8]` for
+ *                    32-bit algorithms and `uint_least64_t[8]`
+ *                    for 64-bit algorithms
+ * @param  algorithm  The hashing algorithm
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+void libsha2_store_hash(void *, const void *, enum libsha2_algorithm);
+
+/**
+ * Set up a state to continue the inner or
+ * outer hash of an HMAC after its pad block
+ * 
+ * @param  state      The state to set up
+ * @param  h          The hash values after the pad block
+ *                    has been processed, `.inner` or `.outer`
+ *                    of a `struct libsha2_hmac_key`
+ * @param  algorithm  The hashing algorithm
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+void libsha2_hmac_start(struct libsha2_state *restrict, const union libsha2_hash_values *restrict, enum libsha2_algorithm);
+
+/**
+ * Get the number of lanes used for multi-buffer processing
+ * 
+ * @param   algorithm  The hashing algorithm
+ * @return             The number of messages processed in parallel,
+ *                     0 if multi-buffer processing is not supported
+ *                     for the algorithm on this machine
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+size_t libsha2_multi_lanes(enum libsha2_algorithm);
+
+/**
+ * Process a number of messages in parallel
+ * 
+ * Must not be called unless `libsha2_multi_lanes(algorithm)`
+ * returns a positive value
+ * 
+ * @param  jobs       The messages to process, `.data` and
+ *                    `.chunks` will be modified
+ * @param  n          The number of elements in `jobs`
+ * @param  algorithm  The hashing algorithm, only its word size matters
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_process_multi(struct libsha2_job *restrict, size_t, enum libsha2_algorithm);
+
+/**
+ * The maximum number of messages `libsha2_digest_batch` accepts
+ */
+#define LIBSHA2_BATCH_SIZE 64
+
+/**
+ * The longest password sha256crypt and sha512crypt accept,
+ * longer passwords are rejected as the work is quadratic
+ * in the length of the password
+ */
+#define LIBSHA2_CRYPT_KEY_MAX 256
+
+/**
+ * The longest message hashed in a round of sha256crypt or sha512crypt
+ */
+#define LIBSHA2_CRYPT_ROUND_MAX (2 * LIBSHA2_CRYPT_KEY_MAX + 16 + 64)
+
+/**
+ * Finish hashing a batch of messages in parallel
+ * 
+ * Must not be called unless `libsha2_multi_lanes(algorithm)`
+ * returns a positive value
+ * 
+ * @param  hs         The hash values for each message, after `prefix`
+ *                    bits have been processed; updated in place
+ * @param  prefix     The number of bits processed before the messages,
+ *                    must be a multiple of the chunk size
+ * @param  algorithm  The hashing algorithm
+ * @param  messages   The messages
+ * @param  msglens    The length of each message, in bits
+ * @param  n          The number of messages, at most `LIBSHA2_BATCH_SIZE`
+ * @param  outputs    Output buffer for the hashes, the hash of the
+ *                    `i`:th message is stored at the offset `i` times
+ *                    `libsha2_algorithm_output_size(algorithm)`
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_digest_batch(union libsha2_hash_values *, size_t, enum libsha2_algorithm,
+                          const void *const *, const size_t *, size_t, unsigned char *);
+
+
+/**
+ * The state of the calculation of one block of PBKDF2 output
+ */
+struct libsha2_pbkdf2_chain {
+	/**
+	 * The password, prepared as an HMAC key
+	 */
+	struct libsha2_hmac_key key;
+
+	/**
+	 * The last U_j, padded as the message of the inner hash
+	 */
+	unsigned char inner[128];
+
+	/**
+	 * Scratch space for the inner hash, padded
+	 * as the message of the outer hash
+	 */
+	unsigned char outer[128];
+
+	/**
+	 * The exclusive-or of all U_j so far
+	 */
+	unsigned char t[64];
+};
+
+/**
+ * Calculate U_1 for a block of PBKDF2 output
+ * 
+ * @param  chain    Output parameter for the chain
+ * @param  key      The password, prepared as an HMAC key
+ * @param  salt     The salt
+ * @param  saltlen  The length of the salt, in bytes
+ * @param  block    The index of the block, starting at 1
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 2), __nothrow__))
+#endif
+void libsha2_pbkdf2_start(struct libsha2_pbkdf2_chain *restrict, const struct libsha2_hmac_key *restrict,
+                          const void *, size_t, uint_least32_t);
+
+/**
+ * Calculate U_2 to U_c for blocks of PBKDF2 output, and
+ * exclusive-or them into `.t`, in parallel when possible
+ * 
+ * @param  chains      The chains, all for the same algorithm,
+ *                     set up with `libsha2_pbkdf2_start`
+ * @param  n           The number of chains
+ * @param  iterations  The iteration count, c
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_pbkdf2_chains(struct libsha2_pbkdf2_chain *restrict, size_t, size_t);
+
+/**
+ * Feed the rest of a file into a hashing state
+ * 
+ * @param   state  The hashing state
+ * @param   fd     The file descriptor of the file
+ * @param   flags  Bitwise OR of `LIBSHA2_MAP`,
+ *                 `LIBSHA2_MAP_POPULATE`, and
+ *                 `LIBSHA2_MAP_HUGEPAGE`, or 0
+ * @return         Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__))
+#endif
+int libsha2_update_fd(struct libsha2_state *restrict, int, int);
+
+/**
+ * Get the number of threads to use
+ * 
+ * @param   threads  The number of threads requested, 0 for one per processor
+ * @return           `threads`, or the number of online processors
+ *                   if `threads` is 0, at least 1
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+size_t libsha2_thread_count(size_t);
+
+/**
+ * Run a function in a number of threads, and wait for all of
+ * them to return; the calling thread is one of the threads,
+ * and if no threads can be created, it is the only one
+ * 
+ * @param  worker   The function, it shall claim work from `arg`
+ *                  until there is none left
+ * @param  arg      The argument to pass to `worker`
+ * @param  threads  The number of threads, 0 for one per processor
+ * @param  max      The maximum number of threads worth using
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1)))
+#endif
+void libsha2_run_workers(void *(*)(void *), void *, size_t, size_t);
+
+/**
+ * Get the number of pieces `libsha2_hash_pieces`
+ * gives a thread at a time
+ * 
+ * @param   algorithm  The hashing algorithm
+ * @return             The number of pieces, at least 1
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+size_t libsha2_pieces_group(enum libsha2_algorithm);
+
+/**
+ * Hash data in fixed-size pieces, using a pool of threads
+ * 
+ * @param  data        The data
+ * @param  len         The length of the data, in bytes
+ * @param  piece_size  The size of each piece, in bytes, the
+ *                     last piece may be shorter
+ * @param  algorithm   The hashing algorithm, must be valid
+ * @param  hashsums    Output buffer for the hashes of the pieces
+ * @param  whole       Hashing state to feed the whole data into,
+ *                     in parallel with the pieces; or `NULL`
+ * @param  threads     The number of threads, 0 for one per processor
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(5)))
+#endif
+void libsha2_hash_pieces(const void *, size_t, size_t, enum libsha2_algorithm, void *, struct libsha2_state *, size_t);
+
+/**
+ * Hash blocks for a verity hash tree
+ * 
+ * @param  verity  The parameters of the tree
+ * @param  blocks  The blocks, `verity->block_size` bytes each
+ * @param  n       The number of blocks, at most `LIBSHA2_BATCH_SIZE`
+ * @param  out     Output buffer for the hashes, `verity->digest_stride`
+ *                 bytes each, padded with zeroes
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_verity_hash(const struct libsha2_verity *restrict, const void *const *, size_t, unsigned char *);
+
+/**
+ * Build a verity hash tree, one level at a time,
+ * using a pool of threads for each level
+ * 
+ * @param   verity   The parameters of the tree
+ * @param   data     The data, or `NULL` to read it from `fd`
+ * @param   fd       The file descriptor of the data, if `data` is `NULL`
+ * @param   tree     Output buffer for the tree
+ * @param   root     Output buffer for the root hash
+ * @param   threads  The number of threads, 0 for one per processor
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 5)))
+#endif
+int libsha2_verity_tree(const struct libsha2_verity *restrict, const void *, int, void *, void *, size_t);
+
+/**
+ * Hash leaves of an RFC 6962 Merkle tree, that is,
+ * hash each entry with the byte 0 prepended
+ * 
+ * @param  algorithm  The hashing algorithm, must be valid
+ * @param  entries    The entries
+ * @param  lens       The length of each entry, in bytes
+ * @param  n          The number of entries
+ * @param  out        Output buffer for the hashes
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+void libsha2_merkle_leaves(enum libsha2_algorithm, const void *const *, const size_t *, size_t, unsigned char *);
+
+/**
+ * Hash interior nodes of an RFC 6962 Merkle tree, that is,
+ * hash the byte 1 followed by the hashes of the two children
+ * 
+ * @param  algorithm  The hashing algorithm, must be valid
+ * @param  children   The hashes of the children, the `i`:th node's
+ *                    children being the `2i`:th and `(2i + 1)`:th hash
+ * @param  n          The number of nodes
+ * @param  out        Output buffer for the hashes of the nodes, may
+ *                    be `children`, as no hash is stored before the
+ *                    children of the nodes up to it have been read
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+void libsha2_merkle_nodes(enum libsha2_algorithm, const unsigned char *, size_t, unsigned char *);
+
+/**
+ * Get the hash of a subtree of a Merkle tree log
+ * 
+ * @param  merkle  The log
+ * @param  begin   The index of the first leaf in the subtree, must
+ *                 be a multiple of a power of 2 that is at least
+ *                 `end - begin`
+ * @param  end     The index of the leaf after the subtree,
+ *                 must be greater than `begin`
+ * @param  out     Output buffer for the hash
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_merkle_subtree(const struct libsha2_merkle *restrict, size_t, size_t, unsigned char *);
+
+/**
+ * Calculate the SHA-256 hashes, or double SHA-256
+ * hashes, of 64-byte messages, processing as many
+ * of them in parallel as is worthwhile
+ * 
+ * @param  out    Output buffer for the hashes, 32 bytes per message
+ * @param  data   The messages, 64 bytes each, one after another
+ * @param  n      The number of messages
+ * @param  twice  Whether the hashes shall be hashed again
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_fixed_many(unsigned char *restrict, const unsigned char *restrict, size_t, int);
+
+/**
+ * Hash files in parallel, using a pool of threads
+ * 
+ * @param   fds        The file descriptors of the files, or `NULL`
+ * @param   paths      The paths of the files, used if `fds` is `NULL`
+ * @param   n          The number of files
+ * @param   algorithm  The hashing algorithm
+ * @param   hashsums   Output buffer for the hashes, one after another
+ * @param   errors     Output buffer for the error of each file,
+ *                     0 for files that were hashed; or `NULL`
+ * @param   threads    The number of threads, 0 for one per processor
+ * @param   oflags     Flags to open the files in `paths` with, in
+ *                     addition to `O_RDONLY | O_CLOEXEC`
+ * @return             Zero on success, -1 on error, in which case
+ *                     `errno` is set to the error for the first
+ *                     file that could not be hashed
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(5)))
+#endif
+int libsha2_sum_files(const int *, const char *const *, size_t, enum libsha2_algorithm, void *, int *, size_t, int);
+
+/**
+ * The magic string at the beginning of a digest cache file
+ */
+#define LIBSHA2_CACHE_MAGIC "libsha2-cache-1"
+
+/**
+ * The header of a digest cache file
+ */
+struct libsha2_cache_header {
+	/**
+	 * `LIBSHA2_CACHE_MAGIC`, padded with NUL bytes
+	 */
+	char magic[16];
+
+	/**
+	 * 0x01020304, in the byte order of the machine
+	 * that created the file
+	 */
+	uint32_t byteorder;
+
+	/**
+	 * `sizeof(struct libsha2_cache_record)`
+	 */
+	uint32_t record_size;
+
+	/**
+	 * Zero
+	 */
+	unsigned char reserved[40];
+};
+
+/**
+ * A record in a digest cache file
+ */
+struct libsha2_cache_record {
+	/**
+	 * The file's device number
+	 */
+	uint64_t dev;
+
+	/**
+	 * The file's inode number
+	 */
+	uint64_t ino;
+
+	/**
+	 * The file's size
+	 */
+	uint64_t size;
+
+	/**
+	 * The seconds part of the file's last modification time
+	 */
+	int64_t mtime_sec;
+
+	/**
+	 * The seconds part of the file's last status change time
+	 */
+	int64_t ctime_sec;
+
+	/**
+	 * The nanoseconds part of the file's last modification time
+	 */
+	uint32_t mtime_nsec;
+
+	/**
+	 * The nanoseconds part of the file's last status change time
+	 */
+	uint32_t ctime_nsec;
+
+	/**
+	 * The hashing algorithm, `enum libsha2_algorithm` value
+	 */
+	uint32_t algorithm;
+
+	/**
+	 * `libsha2_cache_check` of the record, so that
+	 * incompletely written records can be detected
+	 */
+	uint32_t check;
+
+	/**
+	 * The hash of the file, padded with zeroes
+	 */
+	unsigned char digest[64];
+
+	/**
+	 * Zero
+	 */
+	unsigned char reserved[8];
+};
+
+/**
+ * Get the first slot to look in, in a digest cache's
+ * hash table, for a file's record
+ * 
+ * @param   R:const struct libsha2_cache_record *  The record
+ * @param   SIZE:size_t                             The number of slots, a power of 2
+ * @return  :size_t                                 The index of the slot
+ */
+#define LIBSHA2_CACHE_SLOT(R, SIZE)\
+	((size_t)((((R)->ino ^ (R)->dev << 40 ^ (uint64_t)(R)->algorithm << 56) * 0x9E3779B97F4A7C15ULL) >> 32) & ((SIZE) - 1))
+
+/**
+ * Calculate the check value of a digest cache record
+ * 
+ * @param   record  The record, `.check` is ignored
+ * @return          The check value
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__, __pure__))
+#endif
+uint32_t libsha2_cache_check(const struct libsha2_cache_record *);
+
+/**
+ * Create the key for a file's digest cache record, that is,
+ * set everything but `.check` and `.digest` to zero
+ * 
+ * @param  record     Output parameter for the key
+ * @param  attr       The file's attributes
+ * @param  algorithm  The hashing algorithm
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_cache_key(struct libsha2_cache_record *, const struct stat *, enum libsha2_algorithm);
+
+/**
+ * Index the records that have been added to a digest
+ * cache file since it was last indexed
+ * 
+ * @param   cache  The digest cache
+ * @return         Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__))
+#endif
+int libsha2_cache_refresh(struct libsha2_cache *);
+
+/**
+ * Look up a file in the index of a digest cache
+ * 
+ * @param   cache  The digest cache
+ * @param   key    The file's key, from `libsha2_cache_key`
+ * @return         The file's record, `NULL` if the file is not
+ *                 in the cache or it has been modified
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+const struct libsha2_cache_record *libsha2_cache_lookup(const struct libsha2_cache *, const struct libsha2_cache_record *);
+
+/**
+ * Forget the index of a digest cache, and unmap the file
+ * 
+ * @param  cache  The digest cache
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_cache_reset(struct libsha2_cache *);
+
+/**
+ * Open a digest cache file, creating it if it does not
+ * exist, and check its header
+ * 
+ * @param   path  The path of the file
+ * @return        The file descriptor of the file, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__))
+#endif
+int libsha2_cache_open_file(const char *);
+
+/**
+ * The state of the calculation of one sha256crypt or sha512crypt hash
+ */
+struct libsha2_crypt_job {
+	/**
+	 * The hashing algorithm, `LIBSHA2_256` or `LIBSHA2_512`
+	 */
+	enum libsha2_algorithm algorithm;
+
+	/**
+	 * Whether the number of rounds was specified in the setting
+	 */
+	int custom_rounds;
+
+	/**
+	 * The number of rounds
+	 */
+	size_t rounds;
+
+	/**
+	 * The length of the salt, in bytes
+	 */
+	size_t saltlen;
+
+	/**
+	 * The length of the password, in bytes
+	 */
+	size_t keylen;
+
+	/**
+	 * The salt
+	 */
+	char salt[16];
+
+	/**
+	 * The salt-derived byte sequence, S
+	 */
+	unsigned char s[16];
+
+	/**
+	 * The output of the last round, initially
+	 * the alternate sum, A
+	 */
+	unsigned char c[64];
+
+	/**
+	 * The password-derived byte sequence, P
+	 */
+	unsigned char p[LIBSHA2_CRYPT_KEY_MAX];
+};
+
+/**
+ * Parse a sha256crypt or sha512crypt setting and
+ * calculate everything that precedes the rounds
+ * 
+ * @param   job      Output parameter for the state of the calculation
+ * @param   phrase   The password, at most `LIBSHA2_CRYPT_KEY_MAX` bytes long
+ * @param   setting  The setting, "$5$" or "$6$", optionally followed
+ *                   by "rounds=<number>$", followed by the salt
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_crypt_start(struct libsha2_crypt_job *restrict, const char *, const char *);
+
+/**
+ * Construct the message that is hashed in a
+ * round of sha256crypt or sha512crypt
+ * 
+ * @param   job      The state of the calculation
+ * @param   round    The index of the round, starting at 0
+ * @param   message  Output buffer for the message, must have room
+ *                   for at least `LIBSHA2_CRYPT_ROUND_MAX` bytes
+ * @return           The length of the message, in bytes
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+size_t libsha2_crypt_round(const struct libsha2_crypt_job *restrict, size_t, unsigned char *restrict);
+
+/**
+ * Format the result of a sha256crypt or sha512crypt calculation
+ * 
+ * @param  job     The state of the calculation, after the last round
+ * @param  output  Output buffer for the NUL-terminated hash string,
+ *                 must have room for `LIBSHA2_CRYPT_SIZE` bytes
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_crypt_finish(const struct libsha2_crypt_job *restrict, char *restrict);
+
+#ifdef HAVE_X86_AVX2_INTRINSICS
+/**
+ * Detect which instruction set extensions
+ * that are supported by the machine and
+ * enabled by the operating system
+ * 
+ * @return  Bitwise OR of `X86_FEATURE_*` values
+ */
+# if defined(__GNUC__)
+__attribute__((__nothrow__))
+# endif
+int libsha2_x86_features(void);
+
+/**
+ * Process chunks of 8 messages in parallel using SHA-256
+ * with AVX2, one lane per message
+ * 
+ * @param  h       The hash values for each lane (`uint_least32_t[8]`)
+ * @param  data    The data for each lane
+ * @param  chunks  The number of chunks to process in each lane
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_process_avx2_sha256_x8(void *const *, const unsigned char *const *, size_t);
+
+/**
+ * Calculate the SHA-256 hashes of 8 64-byte messages in parallel,
+ * or the SHA-256 hashes of their SHA-256 hashes, with AVX2, one
+ * lane per message, and with the message schedule of the padding
+ * chunk precomputed
+ * 
+ * @param  out    Output buffer for the hashes, 32 bytes per message
+ * @param  data   The messages, 64 bytes each, one after another
+ * @param  twice  Whether the hashes shall be hashed again
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_fixed_avx2_sha256_x8(unsigned char *restrict, const unsigned char *restrict, int);
+
+/**
+ * Process chunks using SHA-384, SHA-512, SHA-512/224, or
+ * SHA-512/256, with the message schedule computed with
+ * AVX2 and the rounds computed with BMI2
+ * 
+ * Two chunks are processed at a time: their message
+ * schedules are computed together, one chunk per 128-bit
+ * lane, while the rounds of the previous two chunks run
+ * 
+ * @param  h       The hash values, updated in place
+ * @param  data    The data to process
+ * @param  chunks  The number of 128-byte chunks in `data`
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_process_avx2_sha512(uint_least64_t *restrict, const unsigned char *restrict, size_t);
+#endif
+
+#ifdef HAVE_X86_AVX512_INTRINSICS
+/**
+ * Process chunks of 16 messages in parallel using SHA-256
+ * with AVX-512, one lane per message
+ * 
+ * @param  h       The hash values for each lane (`uint_least32_t[8]`)
+ * @param  data    The data for each lane
+ * @param  chunks  The number of chunks to process in each lane
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_process_avx512_sha256_x16(void *const *, const unsigned char *const *, size_t);
+
+/**
+ * Calculate the SHA-256 hashes of 16 64-byte messages in parallel,
+ * or the SHA-256 hashes of their SHA-256 hashes, with AVX-512, one
+ * lane per message, and with the message schedule of the padding
+ * chunk precomputed
+ * 
+ * @param  out    Output buffer for the hashes, 32 bytes per message
+ * @param  data   The messages, 64 bytes each, one after another
+ * @param  twice  Whether the hashes shall be hashed again
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_fixed_avx512_sha256_x16(unsigned char *restrict, const unsigned char *restrict, int);
+
+/**
+ * Process chunks of 8 messages in parallel using SHA-512
+ * with AVX-512, one lane per message
+ * 
+ * @param  h       The hash values for each lane (`uint_least64_t[8]`)
+ * @param  data    The data for each lane
+ * @param  chunks  The number of chunks to process in each lane
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_process_avx512_sha512_x8(void *const *, const unsigned char *const *, size_t);
+#endif
+
+#ifdef HAVE_X86_SHA_NI_INTRINSICS
+/**
+ * Process chunks using SHA-224 or SHA-256
+ * with the SHA-NI instructions
+ * 
+ * @param  h       The hash values, updated in place
+ * @param  data    The data to process
+ * @param  chunks  The number of 64-byte chunks in `data`
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_process_shani_sha256(uint_least32_t *restrict, const unsigned char *restrict, size_t);
+
+/**
+ * Process chunks of 2 messages in parallel using SHA-256
+ * with the SHA-NI instructions, with the rounds for the
+ * two messages interleaved
+ * 
+ * @param  h       The hash values for each lane (`uint_least32_t[8]`)
+ * @param  data    The data for each lane
+ * @param  chunks  The number of chunks to process in each lane
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_process_shani_sha256_x2(void *const *, const unsigned char *const *, size_t);
+
+/**
+ * Calculate the SHA-256 hashes of 64-byte messages, or the
+ * SHA-256 hashes of their SHA-256 hashes, with the SHA-NI
+ * instructions, and with the message schedule of the
+ * padding chunk precomputed
+ * 
+ * @param  out    Output buffer for the hashes, 32 bytes per message
+ * @param  data   The messages, 64 bytes each, one after another
+ * @param  n      The number of messages
+ * @param  twice  Whether the hashes shall be hashed again
+ */
+# if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+# endif
+void libsha2_fixed_shani_sha256(unsigned char *restrict, const unsigned char *restrict, size_t, int);
+#endif
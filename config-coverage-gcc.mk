@@ -5,7 +5,7 @@ CC   = $(CC_PREFIX)gcc -std=c11
 GCOV = gcov
 
 CFLAGS  = -g -O0 -pedantic -fprofile-arcs -ftest-coverage
-LDFLAGS = -lgcov -fprofile-arcs
+LDFLAGS = -lgcov -fprofile-arcs -lpthread
 
 coverage: check
 	$(GCOV) -pr $(SRC) 2>&1
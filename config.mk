@@ -4,8 +4,8 @@ MANPREFIX = $(PREFIX)/share/man
 CC = cc -std=c11
 
 CPPFLAGS = -D_DEFAULT_SOURCE -D_BSD_SOURCE -D_XOPEN_SOURCE=700
-CFLAGS   = -Wall -O3 -msse4 -msha
-LDFLAGS  = -s
+CFLAGS   = -Wall -O3
+LDFLAGS  = -s -lpthread
 
 # You can add -DALLOCA_LIMIT=# to CPPFLAGS, where # is a size_t
 # value, to put a limit on how large allocation the library is
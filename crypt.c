@@ -0,0 +1,22 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_crypt(const char *phrase, const char *setting, char *output)
+{
+	struct libsha2_crypt_job job;
+	unsigned char message[LIBSHA2_CRYPT_ROUND_MAX];
+	size_t i, len;
+
+	if (libsha2_crypt_start(&job, phrase, setting))
+		return -1;
+
+	for (i = 0; i < job.rounds; i++) {
+		len = libsha2_crypt_round(&job, i, message);
+		libsha2_hash(job.algorithm, message, len * 8, job.c);
+	}
+
+	libsha2_crypt_finish(&job, output);
+	return 0;
+}
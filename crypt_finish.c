@@ -0,0 +1,85 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <stdio.h>
+
+
+/**
+ * The alphabet used to encode the hash
+ */
+static const char alphabet[] = "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+/**
+ * The order in which the bytes of a SHA-256 hash are encoded,
+ * three at a time with the first byte as the most significant
+ */
+static const unsigned char order256[] = {
+	0, 10, 20,  21, 1, 11,  12, 22, 2,  3, 13, 23,  24, 4, 14,
+	15, 25, 5,  6, 16, 26,  27, 7, 17,  18, 28, 8,  9, 19, 29
+};
+
+/**
+ * The order in which the bytes of a SHA-512 hash are encoded,
+ * three at a time with the first byte as the most significant
+ */
+static const unsigned char order512[] = {
+	0, 21, 42,  22, 43, 1,  44, 2, 23,  3, 24, 45,  25, 46, 4,
+	47, 5, 26,  6, 27, 48,  28, 49, 7,  50, 8, 29,  9, 30, 51,
+	31, 52, 10,  53, 11, 32,  12, 33, 54,  34, 55, 13,  56, 14, 35,
+	15, 36, 57,  37, 58, 16,  59, 17, 38,  18, 39, 60,  40, 61, 19,
+	62, 20, 41
+};
+
+
+/**
+ * Encode bytes, least significant 6 bits first
+ * 
+ * @param   out  Output buffer
+ * @param   w    The bytes, as one integer
+ * @param   n    The number of characters to output
+ * @return       `out` offset by `n`
+ */
+static char *
+encode(char *out, unsigned long int w, int n)
+{
+	while (n--) {
+		*out++ = alphabet[w & 0x3F];
+		w >>= 6;
+	}
+	return out;
+}
+
+
+void
+libsha2_crypt_finish(const struct libsha2_crypt_job *restrict job, char *restrict output)
+{
+	const unsigned char *c = job->c;
+	const unsigned char *order;
+	size_t i, n;
+	char *p = output;
+
+	p = stpcpy(p, job->algorithm == LIBSHA2_256 ? "$5$" : "$6$");
+	if (job->custom_rounds) {
+		p = stpcpy(p, "rounds=");
+		p = &p[sprintf(p, "%zu", job->rounds)];
+		*p++ = '$';
+	}
+	memcpy(p, job->salt, job->saltlen);
+	p += job->saltlen;
+	*p++ = '$';
+
+	if (job->algorithm == LIBSHA2_256) {
+		order = order256;
+		n = sizeof(order256);
+	} else {
+		order = order512;
+		n = sizeof(order512);
+	}
+	for (i = 0; i < n; i += 3)
+		p = encode(p, (unsigned long int)c[order[i]] << 16 | (unsigned long int)c[order[i + 1]] << 8 | c[order[i + 2]], 4);
+	if (job->algorithm == LIBSHA2_256)
+		p = encode(p, (unsigned long int)c[31] << 8 | c[30], 3);
+	else
+		p = encode(p, c[63], 2);
+
+	*p = '\0';
+}
@@ -0,0 +1,123 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * The number of candidates that are worked on at the same time
+ */
+#define GROUP_SIZE 32
+
+
+/**
+ * Write the string that is output for a failed hashing,
+ * which never matches the setting
+ * 
+ * @param  output   Output buffer
+ * @param  setting  The setting
+ */
+static void
+fail(char *output, const char *setting)
+{
+	strcpy(output, (setting[0] == '*' && setting[1] == '0') ? "*1" : "*0");
+}
+
+
+/**
+ * Run the rounds for candidates that use the same algorithm
+ * 
+ * @param  jobs       The candidates
+ * @param  n          The number of candidates
+ * @param  algorithm  The hashing algorithm
+ */
+static void
+run_rounds(struct libsha2_crypt_job **jobs, size_t n, enum libsha2_algorithm algorithm)
+{
+	unsigned char messages[GROUP_SIZE][LIBSHA2_CRYPT_ROUND_MAX];
+	const void *ptrs[GROUP_SIZE];
+	size_t lens[GROUP_SIZE];
+	union libsha2_hash_values hs[GROUP_SIZE];
+	unsigned char outputs[GROUP_SIZE * 64];
+	struct libsha2_crypt_job *active[GROUP_SIZE];
+	struct libsha2_state state;
+	size_t i, j, m, outsize;
+
+	/* Candidates with their own number of rounds drop out as
+	 * they finish, so the batch only works on those left */
+	libsha2_init(&state, algorithm);
+	outsize = libsha2_algorithm_output_size(algorithm);
+	for (i = 0;; i++) {
+		for (j = m = 0; j < n; j++) {
+			if (i < jobs[j]->rounds) {
+				active[m] = jobs[j];
+				lens[m] = libsha2_crypt_round(jobs[j], i, messages[m]) * 8;
+				ptrs[m] = messages[m];
+				hs[m] = state.h;
+				m++;
+			}
+		}
+		if (!m)
+			break;
+		libsha2_digest_batch(hs, 0, algorithm, ptrs, lens, m, outputs);
+		for (j = 0; j < m; j++)
+			memcpy(active[j]->c, &outputs[j * outsize], outsize);
+	}
+}
+
+
+/**
+ * Run the rounds for one candidate
+ * 
+ * @param  job  The candidate
+ */
+static void
+run_single(struct libsha2_crypt_job *job)
+{
+	unsigned char message[LIBSHA2_CRYPT_ROUND_MAX];
+	size_t i, len;
+
+	for (i = 0; i < job->rounds; i++) {
+		len = libsha2_crypt_round(job, i, message);
+		libsha2_hash(job->algorithm, message, len * 8, job->c);
+	}
+}
+
+
+int
+libsha2_crypt_many(const char *const *phrases, const char *const *settings, char *outputs, size_t n)
+{
+	struct libsha2_crypt_job jobs[GROUP_SIZE];
+	struct libsha2_crypt_job *group256[GROUP_SIZE], *group512[GROUP_SIZE];
+	int ok[GROUP_SIZE];
+	size_t i, j, batch, n256, n512;
+	int lanes256, lanes512;
+
+	/* With two lanes or less, the batch does not pay
+	 * for itself, see `libsha2_digest_many` */
+	lanes256 = libsha2_multi_lanes(LIBSHA2_256) > 2;
+	lanes512 = libsha2_multi_lanes(LIBSHA2_512) > 2;
+
+	for (i = 0; i < n; i += batch) {
+		batch = n - i < GROUP_SIZE ? n - i : GROUP_SIZE;
+		n256 = n512 = 0;
+		for (j = 0; j < batch; j++) {
+			ok[j] = !libsha2_crypt_start(&jobs[j], phrases[i + j], settings[i + j]);
+			if (!ok[j])
+				fail(&outputs[(i + j) * LIBSHA2_CRYPT_SIZE], settings[i + j]);
+			else if (jobs[j].algorithm == LIBSHA2_256 && lanes256)
+				group256[n256++] = &jobs[j];
+			else if (jobs[j].algorithm == LIBSHA2_512 && lanes512)
+				group512[n512++] = &jobs[j];
+			else
+				run_single(&jobs[j]);
+		}
+		if (n256)
+			run_rounds(group256, n256, LIBSHA2_256);
+		if (n512)
+			run_rounds(group512, n512, LIBSHA2_512);
+		for (j = 0; j < batch; j++)
+			if (ok[j])
+				libsha2_crypt_finish(&jobs[j], &outputs[(i + j) * LIBSHA2_CRYPT_SIZE]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,33 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+size_t
+libsha2_crypt_round(const struct libsha2_crypt_job *restrict job, size_t round, unsigned char *restrict message)
+{
+	size_t outsize = libsha2_algorithm_output_size(job->algorithm);
+	size_t len = 0;
+
+#define ADD(DATA, N)\
+	do {\
+		memcpy(&message[len], (DATA), (N));\
+		len += (N);\
+	} while (0)
+
+	if (round & 1)
+		ADD(job->p, job->keylen);
+	else
+		ADD(job->c, outsize);
+	if (round % 3)
+		ADD(job->s, job->saltlen);
+	if (round % 7)
+		ADD(job->p, job->keylen);
+	if (round & 1)
+		ADD(job->c, outsize);
+	else
+		ADD(job->p, job->keylen);
+
+#undef ADD
+
+	return len;
+}
@@ -0,0 +1,103 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Feed a string into a hashing state
+ * 
+ * @param  state  The hashing state
+ * @param  data   The string
+ * @param  len    The length of the string, in bytes
+ */
+static void
+add(struct libsha2_state *restrict state, const void *restrict data, size_t len)
+{
+	libsha2_update(state, data, len * 8);
+}
+
+
+int
+libsha2_crypt_start(struct libsha2_crypt_job *restrict job, const char *phrase, const char *setting)
+{
+	struct libsha2_state state;
+	unsigned char b[64], dp[64], ds[64];
+	size_t outsize, rounds, cnt;
+	const char *p;
+
+	if (!strncmp(setting, "$5$", 3))
+		job->algorithm = LIBSHA2_256;
+	else if (!strncmp(setting, "$6$", 3))
+		job->algorithm = LIBSHA2_512;
+	else
+		goto einval;
+	setting = &setting[3];
+	outsize = libsha2_algorithm_output_size(job->algorithm);
+
+	/* Like glibc, "rounds=" is only recognised if followed
+	 * by a number and a '$', and the number is clamped */
+	job->rounds = 5000;
+	job->custom_rounds = 0;
+	if (!strncmp(setting, "rounds=", 7) && '0' <= setting[7] && setting[7] <= '9') {
+		rounds = 0;
+		for (p = &setting[7]; '0' <= *p && *p <= '9'; p++)
+			rounds = rounds > 999999999 ? 1000000000 : rounds * 10 + (size_t)(*p - '0');
+		if (*p == '$') {
+			job->rounds = rounds < 1000 ? 1000 : rounds > 999999999 ? 999999999 : rounds;
+			job->custom_rounds = 1;
+			setting = &p[1];
+		}
+	}
+
+	job->saltlen = strcspn(setting, "$");
+	if (job->saltlen > sizeof(job->salt))
+		job->saltlen = sizeof(job->salt);
+	memcpy(job->salt, setting, job->saltlen);
+
+	job->keylen = strlen(phrase);
+	if (job->keylen > sizeof(job->p))
+		goto einval;
+
+	/* B = H(key || salt || key) */
+	libsha2_init(&state, job->algorithm);
+	add(&state, phrase, job->keylen);
+	add(&state, job->salt, job->saltlen);
+	add(&state, phrase, job->keylen);
+	libsha2_digest(&state, NULL, 0, b);
+
+	/* A = H(key || salt || B repeated to the length of the key
+	 *       || B or the key for each bit in the key's length) */
+	libsha2_init(&state, job->algorithm);
+	add(&state, phrase, job->keylen);
+	add(&state, job->salt, job->saltlen);
+	for (cnt = job->keylen; cnt > outsize; cnt -= outsize)
+		add(&state, b, outsize);
+	add(&state, b, cnt);
+	for (cnt = job->keylen; cnt; cnt >>= 1) {
+		if (cnt & 1)
+			add(&state, b, outsize);
+		else
+			add(&state, phrase, job->keylen);
+	}
+	libsha2_digest(&state, NULL, 0, job->c);
+
+	/* P = H(key repeated as many times as it is long), repeated to the length of the key */
+	libsha2_init(&state, job->algorithm);
+	for (cnt = 0; cnt < job->keylen; cnt++)
+		add(&state, phrase, job->keylen);
+	libsha2_digest(&state, NULL, 0, dp);
+	for (cnt = 0; cnt < job->keylen; cnt += outsize)
+		memcpy(&job->p[cnt], dp, job->keylen - cnt < outsize ? job->keylen - cnt : outsize);
+
+	/* S = H(salt repeated 16 + A[0] times), truncated to the length of the salt */
+	libsha2_init(&state, job->algorithm);
+	for (cnt = 0; cnt < 16U + job->c[0]; cnt++)
+		add(&state, job->salt, job->saltlen);
+	libsha2_digest(&state, NULL, 0, ds);
+	memcpy(job->s, ds, job->saltlen);
+
+	return 0;
+
+einval:
+	errno = EINVAL;
+	return -1;
+}
@@ -3,11 +3,10 @@
 
 
 void
-libsha2_digest(struct libsha2_state *restrict state, const void *message_, size_t msglen, void *output_)
+libsha2_digest(struct libsha2_state *restrict state, const void *message_, size_t msglen, void *output)
 {
 	const char *message = message_;
-	unsigned char *output = output_;
-	size_t off, i, n;
+	size_t off;
 
 	if (msglen & ~(size_t)7) {
 		libsha2_update(state, message, msglen & ~(size_t)7);
@@ -43,24 +42,5 @@ libsha2_digest(struct libsha2_state *restrict state, const void *message_, size_
 	state->chunk[state->chunk_size - 1] = (unsigned char)(state->message_size >>  0);
 	libsha2_process(state, state->chunk, state->chunk_size);
 
-	n = libsha2_algorithm_output_size(state->algorithm);
-	if (state->algorithm <= LIBSHA2_256) {
-		for (i = 0, n /= 4; i < n; i++) {
-			output[4 * i + 0] = (unsigned char)(state->h.b32[i] >> 24);
-			output[4 * i + 1] = (unsigned char)(state->h.b32[i] >> 16);
-			output[4 * i + 2] = (unsigned char)(state->h.b32[i] >>  8);
-			output[4 * i + 3] = (unsigned char)(state->h.b32[i] >>  0);
-		}
-	} else {
-		for (i = 0, n = (n + 7) / 8; i < n; i++) {
-			output[8 * i + 0] = (unsigned char)(state->h.b64[i] >> 56);
-			output[8 * i + 1] = (unsigned char)(state->h.b64[i] >> 48);
-			output[8 * i + 2] = (unsigned char)(state->h.b64[i] >> 40);
-			output[8 * i + 3] = (unsigned char)(state->h.b64[i] >> 32);
-			output[8 * i + 4] = (unsigned char)(state->h.b64[i] >> 24);
-			output[8 * i + 5] = (unsigned char)(state->h.b64[i] >> 16);
-			output[8 * i + 6] = (unsigned char)(state->h.b64[i] >>  8);
-			output[8 * i + 7] = (unsigned char)(state->h.b64[i] >>  0);
-		}
-	}
+	libsha2_store_hash(output, &state->h, state->algorithm);
 }
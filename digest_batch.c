@@ -0,0 +1,51 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_digest_batch(union libsha2_hash_values *hs, size_t prefix, enum libsha2_algorithm algorithm,
+                     const void *const *messages, const size_t *msglens, size_t n, unsigned char *outputs)
+{
+	struct libsha2_job jobs[LIBSHA2_BATCH_SIZE];
+	unsigned char tails[LIBSHA2_BATCH_SIZE][256];
+	size_t order[LIBSHA2_BATCH_SIZE], total[LIBSHA2_BATCH_SIZE];
+	const unsigned char *message;
+	size_t i, j, k, bytes, body, chunk_size, outsize;
+
+	chunk_size = algorithm <= LIBSHA2_256 ? 64 : 128;
+	outsize = libsha2_algorithm_output_size(algorithm);
+
+	/* Sort the messages by size so that messages that
+	 * run in parallel finish at about the same time */
+	for (i = 0; i < n; i++) {
+		total[i] = (msglens[i] / 8 + 1 + chunk_size / 8 + chunk_size - 1) / chunk_size;
+		for (j = i; j && total[order[j - 1]] > total[i]; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+
+	for (j = 0; j < n; j++) {
+		i = order[j];
+		message = messages[i];
+		bytes = msglens[i] / 8;
+		body = bytes / chunk_size * chunk_size;
+
+		jobs[j].h = &hs[i];
+		jobs[j].chunks[0] = 0;
+		jobs[j].data[1] = message;
+		jobs[j].chunks[1] = body / chunk_size;
+
+		k = bytes - body;
+		if (k)
+			memcpy(tails[j], &message[body], k);
+		if (msglens[i] & 7)
+			tails[j][k] = (unsigned char)(message[bytes] << (8 - (msglens[i] & 7)));
+		jobs[j].data[2] = tails[j];
+		jobs[j].chunks[2] = libsha2_pad(tails[j], prefix + msglens[i], chunk_size) / chunk_size;
+	}
+
+	libsha2_process_multi(jobs, n, algorithm);
+
+	for (i = 0; i < n; i++)
+		libsha2_store_hash(&outputs[i * outsize], &hs[i], algorithm);
+}
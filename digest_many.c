@@ -0,0 +1,34 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_digest_many(enum libsha2_algorithm algorithm, const void *const *messages, const size_t *msglens,
+                    size_t n, void *outputs_)
+{
+	unsigned char *outputs = outputs_;
+	struct libsha2_state state;
+	union libsha2_hash_values hs[LIBSHA2_BATCH_SIZE];
+	size_t i, j, outsize, batch;
+
+	if (libsha2_init(&state, algorithm))
+		return -1;
+	outsize = libsha2_algorithm_output_size(algorithm);
+
+	/* With only two lanes, sorting and copying the tails costs
+	 * more than the interleaving gains for short messages */
+	if (libsha2_multi_lanes(algorithm) <= 2) {
+		for (i = 0; i < n; i++)
+			libsha2_hash(algorithm, messages[i], msglens[i], &outputs[i * outsize]);
+		return 0;
+	}
+
+	for (i = 0; i < n; i += batch) {
+		batch = n - i < LIBSHA2_BATCH_SIZE ? n - i : LIBSHA2_BATCH_SIZE;
+		for (j = 0; j < batch; j++)
+			hs[j] = state.h;
+		libsha2_digest_batch(hs, 0, algorithm, &messages[i], &msglens[i], batch, &outputs[i * outsize]);
+	}
+
+	return 0;
+}
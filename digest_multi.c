@@ -0,0 +1,116 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * The maximum number of messages to queue at a time
+ */
+#define BATCH_SIZE 32
+
+
+/**
+ * Prepare a message for multi-buffer processing
+ * 
+ * @param  job      Output parameter for the job
+ * @param  tail     Buffer for the padded end of the message,
+ *                  must be at least `2 * state->chunk_size` bytes
+ * @param  state    The hashing state
+ * @param  message  The message, in bits
+ * @param  msglen   The length of the message
+ */
+static void
+prepare_job(struct libsha2_job *restrict job, unsigned char *restrict tail, struct libsha2_state *restrict state,
+            const unsigned char *message, size_t msglen)
+{
+	size_t off, n, bytes = msglen / 8;
+
+	off = (state->message_size / 8) % state->chunk_size;
+	state->message_size += msglen;
+	job->h = &state->h;
+
+	job->chunks[0] = 0;
+	if (off && bytes >= state->chunk_size - off) {
+		n = state->chunk_size - off;
+		memcpy(&state->chunk[off], message, n);
+		job->data[0] = state->chunk;
+		job->chunks[0] = 1;
+		message += n;
+		bytes -= n;
+		off = 0;
+	}
+
+	job->data[1] = message;
+	job->chunks[1] = bytes / state->chunk_size;
+	n = job->chunks[1] * state->chunk_size;
+	if (n) {
+		message += n;
+		bytes -= n;
+	}
+
+	memcpy(tail, state->chunk, off);
+	if (bytes)
+		memcpy(&tail[off], message, bytes);
+	if (msglen & 7)
+		tail[off + bytes] = (unsigned char)(message[bytes] << (8 - (msglen & 7)));
+	job->data[2] = tail;
+	job->chunks[2] = libsha2_pad(tail, state->message_size, state->chunk_size) / state->chunk_size;
+}
+
+
+/**
+ * Process prepared messages and output their hashes
+ * 
+ * @param  jobs     The prepared messages
+ * @param  indices  The index of each prepared message in `states`
+ * @param  count    The number of prepared messages
+ * @param  family   Any algorithm with the same word size as the messages
+ * @param  states   The hashing states
+ * @param  outputs  The output buffers for the hashes
+ */
+static void
+finish_jobs(struct libsha2_job *restrict jobs, const size_t *restrict indices, size_t count, enum libsha2_algorithm family,
+            struct libsha2_state *const *restrict states, void *const *outputs)
+{
+	size_t i;
+
+	libsha2_process_multi(jobs, count, family);
+	for (i = 0; i < count; i++)
+		libsha2_store_hash(outputs[indices[i]], &states[indices[i]]->h, states[indices[i]]->algorithm);
+}
+
+
+void
+libsha2_digest_multi(struct libsha2_state *const *restrict states, const void *const *messages,
+                     const size_t *msglens, void *const *outputs, size_t n)
+{
+	struct libsha2_job jobs[BATCH_SIZE];
+	unsigned char tails[BATCH_SIZE][256];
+	size_t indices[BATCH_SIZE];
+	enum libsha2_algorithm family;
+	size_t i, count;
+	int wide;
+
+	for (wide = 0; wide < 2; wide++) {
+		family = wide ? LIBSHA2_512 : LIBSHA2_256;
+
+		if (!libsha2_multi_lanes(family)) {
+			for (i = 0; i < n; i++)
+				if ((states[i]->algorithm > LIBSHA2_256) == wide)
+					libsha2_digest(states[i], messages[i], msglens[i], outputs[i]);
+			continue;
+		}
+
+		for (i = 0, count = 0; i < n; i++) {
+			if ((states[i]->algorithm > LIBSHA2_256) != wide)
+				continue;
+			prepare_job(&jobs[count], tails[count], states[i], messages[i], msglens[i]);
+			indices[count++] = i;
+			if (count == BATCH_SIZE) {
+				finish_jobs(jobs, indices, count, family, states, outputs);
+				count = 0;
+			}
+		}
+		if (count)
+			finish_jobs(jobs, indices, count, family, states, outputs);
+	}
+}
@@ -0,0 +1,22 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_digest_pieces(enum libsha2_algorithm algorithm, const void *data, size_t len, size_t piece_size,
+                      void *hashsums, void *hashsum, size_t threads)
+{
+	struct libsha2_state whole;
+
+	if (libsha2_init(&whole, algorithm))
+		return -1;
+	if (!piece_size || piece_size > SIZE_MAX / 8) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	libsha2_hash_pieces(data, len, piece_size, algorithm, hashsums, hashsum ? &whole : NULL, threads);
+	if (hashsum)
+		libsha2_digest(&whole, NULL, 0, hashsum);
+	return 0;
+}
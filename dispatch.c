@@ -0,0 +1,251 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <stdatomic.h>
+
+
+static void resolve_process32(uint_least32_t *restrict, const unsigned char *restrict, size_t);
+static void resolve_process64(uint_least64_t *restrict, const unsigned char *restrict, size_t);
+
+struct libsha2_dispatch libsha2_dispatch = {
+	.process32 = &resolve_process32,
+	.process64 = &resolve_process64,
+	.multi32   = NULL,
+	.multi64   = NULL,
+	.lanes32   = 0,
+	.lanes64   = 0,
+	.fixed32   = NULL,
+	.fixed_multi32 = NULL,
+	.fixed_lanes32 = 0,
+	.name32    = "portable",
+	.name64    = "portable",
+	.multi_name32 = NULL,
+	.multi_name64 = NULL
+};
+
+static volatile int resolved = 0;
+static volatile atomic_flag spinlock = ATOMIC_FLAG_INIT;
+
+
+/**
+ * Instruction set extensions that can be
+ * selected by name, with their names
+ */
+static const struct {
+	const char *name;
+	int features;
+} backends[] = {
+	{"portable", 0},
+	{"sha-ni", X86_FEATURE_SHA_NI},
+	{"avx2", X86_FEATURE_AVX2 | X86_FEATURE_BMI2},
+	{"avx512", X86_FEATURE_AVX512}
+};
+
+
+/**
+ * Get the instruction set extensions that
+ * are supported by the machine
+ * 
+ * @return  Bitwise OR of `X86_FEATURE_*` values
+ */
+static int
+supported_features(void)
+{
+#ifdef HAVE_X86_AVX2_INTRINSICS
+	return libsha2_x86_features();
+#else
+	return 0;
+#endif
+}
+
+
+/**
+ * Fill in the dispatch table
+ * 
+ * @param  features  The instruction set extensions that may be used,
+ *                   bitwise OR of `X86_FEATURE_*` values, must be
+ *                   supported by the machine
+ */
+static void
+fill_table(int features)
+{
+	struct libsha2_dispatch *t = &libsha2_dispatch;
+
+	t->process32 = &libsha2_process_portable_sha256;
+	t->name32 = "portable";
+#ifdef HAVE_X86_SHA_NI_INTRINSICS
+	if (features & X86_FEATURE_SHA_NI) {
+		t->process32 = &libsha2_process_shani_sha256;
+		t->name32 = "sha-ni";
+	}
+#endif
+
+	t->process64 = &libsha2_process_portable_sha512;
+	t->name64 = "portable";
+#ifdef HAVE_X86_AVX2_INTRINSICS
+	if ((features & (X86_FEATURE_AVX2 | X86_FEATURE_BMI2)) == (X86_FEATURE_AVX2 | X86_FEATURE_BMI2)) {
+		t->process64 = &libsha2_process_avx2_sha512;
+		t->name64 = "avx2";
+	}
+#endif
+
+	t->multi32 = NULL;
+	t->lanes32 = 0;
+	t->multi_name32 = NULL;
+#ifdef HAVE_X86_AVX2_INTRINSICS
+	if (features & X86_FEATURE_AVX2) {
+		t->multi32 = &libsha2_process_avx2_sha256_x8;
+		t->lanes32 = 8;
+		t->multi_name32 = "avx2-x8";
+	}
+#endif
+#ifdef HAVE_X86_SHA_NI_INTRINSICS
+	if (features & X86_FEATURE_SHA_NI) {
+		t->multi32 = &libsha2_process_shani_sha256_x2;
+		t->lanes32 = 2;
+		t->multi_name32 = "sha-ni-x2";
+	}
+#endif
+#ifdef HAVE_X86_AVX512_INTRINSICS
+	if (features & X86_FEATURE_AVX512) {
+		t->multi32 = &libsha2_process_avx512_sha256_x16;
+		t->lanes32 = 16;
+		t->multi_name32 = "avx512-x16";
+	}
+#endif
+
+	t->fixed32 = &libsha2_fixed_portable_sha256;
+#ifdef HAVE_X86_SHA_NI_INTRINSICS
+	if (features & X86_FEATURE_SHA_NI)
+		t->fixed32 = &libsha2_fixed_shani_sha256;
+#endif
+
+	/* Unlike for `multi32`, AVX2 is preferred over SHA-NI, as skipping
+	 * the message schedule of the padding chunk saves more for AVX2 */
+	t->fixed_multi32 = NULL;
+	t->fixed_lanes32 = 0;
+#ifdef HAVE_X86_AVX2_INTRINSICS
+	if (features & X86_FEATURE_AVX2) {
+		t->fixed_multi32 = &libsha2_fixed_avx2_sha256_x8;
+		t->fixed_lanes32 = 8;
+	}
+#endif
+#ifdef HAVE_X86_AVX512_INTRINSICS
+	if (features & X86_FEATURE_AVX512) {
+		t->fixed_multi32 = &libsha2_fixed_avx512_sha256_x16;
+		t->fixed_lanes32 = 16;
+	}
+#endif
+
+	t->multi64 = NULL;
+	t->lanes64 = 0;
+	t->multi_name64 = NULL;
+#ifdef HAVE_X86_AVX512_INTRINSICS
+	if (features & X86_FEATURE_AVX512) {
+		t->multi64 = &libsha2_process_avx512_sha512_x8;
+		t->lanes64 = 8;
+		t->multi_name64 = "avx512-x8";
+	}
+#endif
+}
+
+
+/**
+ * Parse a comma-separated list of back end names
+ * 
+ * @param   names     The list of names
+ * @param   features  Output parameter for the instruction set extensions
+ *                    that may be used, bitwise OR of `X86_FEATURE_*` values
+ * @return            0 on success, `EINVAL` if a name is not recognised,
+ *                    `ENOTSUP` if a back end is not supported by the machine
+ */
+static int
+parse_backends(const char *names, int *features)
+{
+	int supported = supported_features();
+	size_t i, len;
+
+	if (!strcmp(names, "auto")) {
+		*features = supported;
+		return 0;
+	}
+
+	*features = 0;
+	for (;; names = &names[len + 1]) {
+		len = strcspn(names, ",");
+		for (i = 0; i < sizeof(backends) / sizeof(*backends); i++)
+			if (strlen(backends[i].name) == len && !strncmp(names, backends[i].name, len))
+				break;
+		if (i == sizeof(backends) / sizeof(*backends))
+			return EINVAL;
+		if ((backends[i].features & supported) != backends[i].features)
+			return ENOTSUP;
+		*features |= backends[i].features;
+		if (!names[len])
+			return 0;
+	}
+}
+
+
+#if defined(__GNUC__)
+__attribute__((__constructor__))
+#endif
+void
+libsha2_resolve_dispatch(void)
+{
+	const char *env;
+	int features;
+
+	if (resolved)
+		return;
+
+	while (atomic_flag_test_and_set(&spinlock));
+
+	if (resolved)
+		goto out;
+
+	env = getenv("LIBSHA2_BACKEND");
+	if (!env || !*env || parse_backends(env, &features))
+		features = supported_features();
+	fill_table(features);
+	resolved = 1;
+
+out:
+	atomic_flag_clear(&spinlock);
+}
+
+
+int
+libsha2_set_dispatch(const char *backend)
+{
+	int features, err;
+
+	if (!backend) {
+		features = supported_features();
+	} else if ((err = parse_backends(backend, &features))) {
+		errno = err;
+		return -1;
+	}
+
+	while (atomic_flag_test_and_set(&spinlock));
+	fill_table(features);
+	resolved = 1;
+	atomic_flag_clear(&spinlock);
+
+	return 0;
+}
+
+
+static void
+resolve_process32(uint_least32_t *restrict h, const unsigned char *restrict data, size_t chunks)
+{
+	libsha2_resolve_dispatch();
+	libsha2_dispatch.process32(h, data, chunks);
+}
+
+
+static void
+resolve_process64(uint_least64_t *restrict h, const unsigned char *restrict data, size_t chunks)
+{
+	libsha2_resolve_dispatch();
+	libsha2_dispatch.process64(h, data, chunks);
+}
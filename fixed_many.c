@@ -0,0 +1,31 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_fixed_many(unsigned char *restrict out, const unsigned char *restrict data, size_t n, int twice)
+{
+	unsigned char in_buf[16 * 64], out_buf[16 * 32];
+	size_t lanes;
+
+	libsha2_resolve_dispatch();
+	lanes = libsha2_dispatch.fixed_lanes32;
+
+	if (lanes) {
+		for (; n >= lanes; n -= lanes, data += 64 * lanes, out += 32 * lanes)
+			libsha2_dispatch.fixed_multi32(out, data, twice);
+
+		/* The last messages are processed in parallel too, with
+		 * the unused lanes idle, unless most lanes would be idle */
+		if (n * 2 >= lanes) {
+			memcpy(in_buf, data, n * 64);
+			memset(&in_buf[n * 64], 0, (lanes - n) * 64);
+			libsha2_dispatch.fixed_multi32(out_buf, in_buf, twice);
+			memcpy(out, out_buf, n * 32);
+			return;
+		}
+	}
+
+	if (n)
+		libsha2_dispatch.fixed32(out, data, n, twice);
+}
@@ -0,0 +1,33 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_fsverity_digest(const struct libsha2_verity *restrict verity, const void *root, void *digest)
+{
+	unsigned char desc[256];
+	uint_least64_t size = verity->data_size;
+	size_t i, log_blocksize = 0;
+
+	if (verity->format != LIBSHA2_VERITY_FS) {
+		errno = EINVAL;
+		return -1;
+	}
+	while ((size_t)1 << log_blocksize < verity->block_size)
+		log_blocksize++;
+
+	/* struct fsverity_descriptor, with the signature size
+	 * set to 0, as the signature is not part of what it signs */
+	memset(desc, 0, sizeof(desc));
+	desc[0] = 1; /* version */
+	desc[1] = verity->salted.algorithm == LIBSHA2_256 ? 1 : 2;
+	desc[2] = (unsigned char)log_blocksize;
+	desc[3] = (unsigned char)verity->salt_size;
+	for (i = 0; i < 8; i++, size >>= 8)
+		desc[8 + i] = (unsigned char)(size & 255);
+	memcpy(&desc[16], root, libsha2_algorithm_output_size(verity->salted.algorithm));
+	memcpy(&desc[80], verity->salt, sizeof(verity->salt));
+
+	libsha2_hash(verity->salted.algorithm, desc, sizeof(desc) * 8, digest);
+	return 0;
+}
@@ -0,0 +1,13 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+const char *
+libsha2_get_backend(enum libsha2_algorithm algorithm, int multibuffer)
+{
+	libsha2_resolve_dispatch();
+	if (algorithm <= LIBSHA2_256)
+		return multibuffer ? libsha2_dispatch.multi_name32 : libsha2_dispatch.name32;
+	else
+		return multibuffer ? libsha2_dispatch.multi_name64 : libsha2_dispatch.name64;
+}
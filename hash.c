@@ -0,0 +1,53 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Process complete chunks
+ * 
+ * @param  state  The hashing state
+ * @param  data   The data to process
+ * @param  len    The number of bytes in `data`, must be
+ *                a multiple of the algorithm's chunk size
+ */
+static inline void
+process(struct libsha2_state *restrict state, const unsigned char *restrict data, size_t len)
+{
+	if (state->algorithm <= LIBSHA2_256)
+		libsha2_dispatch.process32(state->h.b32, data, len / 64);
+	else
+		libsha2_dispatch.process64(state->h.b64, data, len / 128);
+}
+
+
+int
+libsha2_hash(enum libsha2_algorithm algorithm, const void *message_, size_t msglen, void *output)
+{
+	const unsigned char *message = message_;
+	struct libsha2_state state;
+	unsigned char tail[256];
+	size_t whole, rem;
+
+	if (libsha2_init(&state, algorithm))
+		return -1;
+
+	/* Process complete chunks directly from the message */
+	whole = msglen / 8 / state.chunk_size * state.chunk_size;
+	if (whole) {
+		process(&state, message, whole);
+		message += whole;
+	}
+
+	/* Pad the rest of the message, which is at most two chunks,
+	 * on the stack; the partial byte, if any, holds the remaining
+	 * bits as its least significant bits */
+	rem = msglen / 8 - whole;
+	if (rem)
+		memcpy(tail, message, rem);
+	if (msglen % 8)
+		tail[rem] = (unsigned char)(message[rem] << (8 - msglen % 8));
+	process(&state, tail, libsha2_pad(tail, msglen, state.chunk_size));
+
+	libsha2_store_hash(output, &state.h, algorithm);
+	return 0;
+}
@@ -0,0 +1,143 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <stdatomic.h>
+
+
+/**
+ * The number of bytes fed into the whole-data hash at a
+ * time, so that the length in bits fits in a `size_t`
+ */
+#define WHOLE_STEP ((size_t)64 << 20)
+
+
+/**
+ * The work shared by the workers
+ */
+struct pool {
+	/**
+	 * The data
+	 */
+	const unsigned char *data;
+
+	/**
+	 * The length of the data, in bytes
+	 */
+	size_t len;
+
+	/**
+	 * The size of each piece, in bytes
+	 */
+	size_t piece_size;
+
+	/**
+	 * The number of pieces
+	 */
+	size_t npieces;
+
+	/**
+	 * The number of pieces in each task
+	 */
+	size_t group;
+
+	/**
+	 * The hashing algorithm
+	 */
+	enum libsha2_algorithm algorithm;
+
+	/**
+	 * The size of each hash
+	 */
+	size_t outsize;
+
+	/**
+	 * Output buffer for the hashes of the pieces
+	 */
+	unsigned char *hashsums;
+
+	/**
+	 * The hashing state for the whole data, or `NULL`
+	 */
+	struct libsha2_state *whole;
+
+	/**
+	 * The index of the next task to claim; if `.whole` is
+	 * not `NULL`, task 0 is to update it, and the other
+	 * tasks are shifted up by one
+	 */
+	atomic_size_t next;
+
+	/**
+	 * The number of tasks
+	 */
+	size_t ntasks;
+};
+
+
+/**
+ * Claim and run tasks until there are none left
+ * 
+ * @param   pool_  The work, `struct pool *`
+ * @return         `NULL`
+ */
+static void *
+worker(void *pool_)
+{
+	struct pool *pool = pool_;
+	const void *messages[LIBSHA2_BATCH_SIZE];
+	size_t msglens[LIBSHA2_BATCH_SIZE];
+	size_t task, i, j, n, off, len;
+
+	while ((task = atomic_fetch_add(&pool->next, 1)) < pool->ntasks) {
+		if (pool->whole) {
+			if (!task) {
+				for (off = 0; off < pool->len; off += len) {
+					len = pool->len - off < WHOLE_STEP ? pool->len - off : WHOLE_STEP;
+					libsha2_update(pool->whole, &pool->data[off], len * 8);
+				}
+				continue;
+			}
+			task -= 1;
+		}
+		i = task * pool->group;
+		n = pool->npieces - i < pool->group ? pool->npieces - i : pool->group;
+		for (j = 0; j < n; j++) {
+			off = (i + j) * pool->piece_size;
+			len = pool->len - off < pool->piece_size ? pool->len - off : pool->piece_size;
+			messages[j] = &pool->data[off];
+			msglens[j] = len * 8;
+		}
+		libsha2_digest_many(pool->algorithm, messages, msglens, n, &pool->hashsums[i * pool->outsize]);
+	}
+
+	return NULL;
+}
+
+
+size_t
+libsha2_pieces_group(enum libsha2_algorithm algorithm)
+{
+	size_t lanes = libsha2_multi_lanes(algorithm);
+	return lanes > LIBSHA2_BATCH_SIZE ? LIBSHA2_BATCH_SIZE : lanes ? lanes : 1;
+}
+
+
+void
+libsha2_hash_pieces(const void *data, size_t len, size_t piece_size, enum libsha2_algorithm algorithm,
+                    void *hashsums, struct libsha2_state *whole, size_t threads)
+{
+	struct pool pool;
+
+	pool.data = data;
+	pool.len = len;
+	pool.piece_size = piece_size;
+	pool.npieces = len / piece_size + !!(len % piece_size);
+	pool.group = libsha2_pieces_group(algorithm);
+	pool.algorithm = algorithm;
+	pool.outsize = libsha2_algorithm_output_size(algorithm);
+	pool.hashsums = hashsums;
+	pool.whole = whole;
+	atomic_init(&pool.next, 0);
+	pool.ntasks = pool.npieces / pool.group + !!(pool.npieces % pool.group) + !!whole;
+
+	libsha2_run_workers(&worker, &pool, threads, pool.ntasks);
+}
@@ -0,0 +1,32 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_hkdf_expand(const struct libsha2_hmac_key *restrict prk, const void *info, size_t infolen,
+                    void *output_, size_t outlen)
+{
+	unsigned char *output = output_;
+	struct libsha2_hmac_state state;
+	unsigned char t[64], counter;
+	size_t outsize, off;
+
+	outsize = libsha2_algorithm_output_size(prk->algorithm);
+	if (outlen > 255 * outsize) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* T(i) = HMAC(PRK, T(i - 1) || info || i), where T(0) is empty */
+	for (off = 0, counter = 1; off < outlen; off += outsize, counter++) {
+		libsha2_hmac_init_from_key(&state, prk);
+		if (counter > 1)
+			libsha2_hmac_update(&state, t, outsize * 8);
+		if (infolen)
+			libsha2_hmac_update(&state, info, infolen * 8);
+		libsha2_hmac_digest(&state, &counter, 8, t);
+		memcpy(&output[off], t, outlen - off < outsize ? outlen - off : outsize);
+	}
+
+	return 0;
+}
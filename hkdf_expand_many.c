@@ -0,0 +1,89 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * The longest `info` that is expanded in parallel
+ * with other labels, longer ones are expanded one
+ * at a time
+ */
+#define MAX_INFO 255
+
+
+int
+libsha2_hkdf_expand_many(const struct libsha2_hmac_key *restrict prk, const void *const *infos, const size_t *infolens,
+                         void *const *outputs, const size_t *outlens, size_t n)
+{
+	const struct libsha2_hmac_key *keys[LIBSHA2_BATCH_SIZE];
+	unsigned char messages[LIBSHA2_BATCH_SIZE][64 + MAX_INFO + 1];
+	const void *message_ptrs[LIBSHA2_BATCH_SIZE];
+	size_t message_lens[LIBSHA2_BATCH_SIZE], label[LIBSHA2_BATCH_SIZE];
+	unsigned char t[LIBSHA2_BATCH_SIZE * 64];
+	size_t outsize, lanes, first, batch, i, j, m, off, len, round;
+	unsigned char *output;
+
+	outsize = libsha2_algorithm_output_size(prk->algorithm);
+	for (i = 0; i < n; i++) {
+		if (outlens[i] > 255 * outsize) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	for (j = 0; j < LIBSHA2_BATCH_SIZE; j++) {
+		keys[j] = prk;
+		message_ptrs[j] = messages[j];
+	}
+
+	/* Unless every lane can be filled, the labels are expanded one at
+	 * a time, as the single-stream implementation is then faster */
+	lanes = libsha2_multi_lanes(prk->algorithm);
+
+	for (first = 0; first < n; first += batch) {
+		batch = n - first < LIBSHA2_BATCH_SIZE ? n - first : LIBSHA2_BATCH_SIZE;
+		if (batch < lanes || lanes <= 2) {
+			for (i = first; i < first + batch; i++)
+				libsha2_hkdf_expand(prk, infos[i], infolens[i], outputs[i], outlens[i]);
+			continue;
+		}
+
+		/* Calculate T(round) for every label that needs
+		 * it, all of which are independent of each other */
+		for (round = 1;; round++) {
+			m = 0;
+			for (i = first; i < first + batch; i++) {
+				if (outlens[i] <= (round - 1) * outsize || infolens[i] > MAX_INFO)
+					continue;
+				output = outputs[i];
+				len = 0;
+				if (round > 1) {
+					memcpy(messages[m], &output[(round - 2) * outsize], outsize);
+					len = outsize;
+				}
+				if (infolens[i])
+					memcpy(&messages[m][len], infos[i], infolens[i]);
+				len += infolens[i];
+				messages[m][len++] = (unsigned char)round;
+				message_lens[m] = len * 8;
+				label[m++] = i;
+			}
+			if (!m)
+				break;
+
+			libsha2_hmac_digest_many(keys, message_ptrs, message_lens, m, t);
+
+			for (j = 0; j < m; j++) {
+				output = outputs[label[j]];
+				off = (round - 1) * outsize;
+				len = outlens[label[j]] - off < outsize ? outlens[label[j]] - off : outsize;
+				memcpy(&output[off], &t[j * outsize], len);
+			}
+		}
+
+		for (i = first; i < first + batch; i++)
+			if (infolens[i] > MAX_INFO)
+				libsha2_hkdf_expand(prk, infos[i], infolens[i], outputs[i], outlens[i]);
+	}
+
+	return 0;
+}
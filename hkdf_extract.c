@@ -0,0 +1,30 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_hkdf_extract(struct libsha2_hmac_key *restrict key, enum libsha2_algorithm algorithm,
+                     const void *salt, size_t saltlen, const void *ikm, size_t ikmlen, void *prk_)
+{
+	unsigned char *prk = prk_;
+	unsigned char zeroes[64], buf[64];
+	struct libsha2_hmac_state state;
+	size_t outsize;
+
+	outsize = libsha2_algorithm_output_size(algorithm);
+	if (!outsize) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* PRK = HMAC(salt, IKM), with HashLen zeroes if the salt is not provided */
+	if (!saltlen) {
+		memset(zeroes, 0, outsize);
+		salt = zeroes;
+		saltlen = outsize;
+	}
+	libsha2_hmac_init(&state, algorithm, salt, saltlen * 8);
+	libsha2_hmac_digest(&state, ikmlen ? ikm : "", ikmlen * 8, prk ? prk : buf);
+
+	return libsha2_hmac_key_init(key, algorithm, prk ? prk : buf, outsize * 8);
+}
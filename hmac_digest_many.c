@@ -0,0 +1,58 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_hmac_digest_many(const struct libsha2_hmac_key *const *keys, const void *const *messages,
+                         const size_t *msglens, size_t n, void *outputs_)
+{
+	unsigned char *outputs = outputs_;
+	union libsha2_hash_values hs[LIBSHA2_BATCH_SIZE];
+	unsigned char inner[LIBSHA2_BATCH_SIZE * 64];
+	const void *inner_messages[LIBSHA2_BATCH_SIZE];
+	size_t inner_lens[LIBSHA2_BATCH_SIZE];
+	enum libsha2_algorithm algorithm;
+	size_t i, j, outsize, prefix, batch;
+
+	if (!n)
+		return 0;
+
+	algorithm = keys[0]->algorithm;
+	outsize = libsha2_algorithm_output_size(algorithm);
+	for (i = 1; i < n && outsize; i++)
+		if (keys[i]->algorithm != algorithm)
+			outsize = 0;
+	if (!outsize) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* See libsha2_digest_many */
+	if (libsha2_multi_lanes(algorithm) <= 2) {
+		for (i = 0; i < n; i++)
+			libsha2_hmac_key_digest(keys[i], messages[i], msglens[i], &outputs[i * outsize]);
+		return 0;
+	}
+
+	/* Both hashes resume after their pad block */
+	prefix = (algorithm <= LIBSHA2_256 ? 64 : 128) * 8;
+
+	for (j = 0; j < LIBSHA2_BATCH_SIZE; j++) {
+		inner_messages[j] = &inner[j * outsize];
+		inner_lens[j] = outsize * 8;
+	}
+
+	for (i = 0; i < n; i += batch) {
+		batch = n - i < LIBSHA2_BATCH_SIZE ? n - i : LIBSHA2_BATCH_SIZE;
+
+		for (j = 0; j < batch; j++)
+			hs[j] = keys[i + j]->inner;
+		libsha2_digest_batch(hs, prefix, algorithm, &messages[i], &msglens[i], batch, inner);
+
+		for (j = 0; j < batch; j++)
+			hs[j] = keys[i + j]->outer;
+		libsha2_digest_batch(hs, prefix, algorithm, inner_messages, inner_lens, batch, &outputs[i * outsize]);
+	}
+
+	return 0;
+}
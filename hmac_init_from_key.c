@@ -0,0 +1,11 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_hmac_init_from_key(struct libsha2_hmac_state *restrict state, const struct libsha2_hmac_key *restrict key)
+{
+	state->key = *key;
+	state->outsize = libsha2_algorithm_output_size(key->algorithm) * 8;
+	libsha2_hmac_start(&state->sha2_state, &key->inner, key->algorithm);
+}
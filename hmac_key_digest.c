@@ -0,0 +1,57 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Process complete chunks
+ * 
+ * @param  h          The hash values, updated in place
+ * @param  algorithm  The hashing algorithm
+ * @param  data       The data to process
+ * @param  len        The number of bytes in `data`, must be
+ *                    a multiple of the algorithm's chunk size
+ */
+static inline void
+process(union libsha2_hash_values *restrict h, enum libsha2_algorithm algorithm,
+        const unsigned char *restrict data, size_t len)
+{
+	if (algorithm <= LIBSHA2_256)
+		libsha2_dispatch.process32(h->b32, data, len / 64);
+	else
+		libsha2_dispatch.process64(h->b64, data, len / 128);
+}
+
+
+void
+libsha2_hmac_key_digest(const struct libsha2_hmac_key *restrict key, const void *data_, size_t n, void *output)
+{
+	const unsigned char *data = data_;
+	union libsha2_hash_values h;
+	unsigned char tail[256];
+	size_t chunk_size, outsize, whole, rem;
+
+	chunk_size = key->algorithm <= LIBSHA2_256 ? 64 : 128;
+	outsize = libsha2_algorithm_output_size(key->algorithm);
+
+	/* Inner hash, resumed after the inner pad,
+	 * which counts toward the message length */
+	h = key->inner;
+	whole = n / 8 / chunk_size * chunk_size;
+	if (whole) {
+		process(&h, key->algorithm, data, whole);
+		data += whole;
+	}
+	rem = n / 8 - whole;
+	if (rem)
+		memcpy(tail, data, rem);
+	if (n % 8)
+		tail[rem] = (unsigned char)(data[rem] << (8 - n % 8));
+	process(&h, key->algorithm, tail, libsha2_pad(tail, chunk_size * 8 + n, chunk_size));
+
+	/* Outer hash, of the inner hash, resumed after the outer pad */
+	libsha2_store_hash(tail, &h, key->algorithm);
+	h = key->outer;
+	process(&h, key->algorithm, tail, libsha2_pad(tail, (chunk_size + outsize) * 8, chunk_size));
+
+	libsha2_store_hash(output, &h, key->algorithm);
+}
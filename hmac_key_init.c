@@ -0,0 +1,51 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_hmac_key_init(struct libsha2_hmac_key *restrict key, enum libsha2_algorithm algorithm,
+                      const void *restrict key_data_, size_t keylen)
+{
+	const unsigned char *restrict key_data = key_data_;
+	struct libsha2_state state;
+	unsigned char ipad[128], opad[128], hashed_key[64];
+	size_t i;
+
+	if (libsha2_init(&state, algorithm))
+		return -1;
+
+	memset(ipad, 0x36, state.chunk_size);
+	memset(opad, 0x5C, state.chunk_size);
+
+	if (keylen > state.chunk_size * 8) {
+		libsha2_digest(&state, key_data, keylen, hashed_key);
+		key_data = hashed_key;
+		keylen = libsha2_algorithm_output_size(algorithm) * 8;
+		libsha2_init(&state, algorithm);
+	}
+
+	for (i = 0; i < keylen / 8; i++) {
+		ipad[i] ^= key_data[i];
+		opad[i] ^= key_data[i];
+	}
+	if (keylen & 7) {
+		ipad[i] ^= (unsigned char)(key_data[i] << (8 - (keylen & 7)));
+		opad[i] ^= (unsigned char)(key_data[i] << (8 - (keylen & 7)));
+	}
+
+	/* Process the pads once, so that each message
+	 * can start from the resulting hash values */
+	key->inner = state.h;
+	key->outer = state.h;
+	if (algorithm <= LIBSHA2_256) {
+		libsha2_dispatch.process32(key->inner.b32, ipad, 1);
+		libsha2_dispatch.process32(key->outer.b32, opad, 1);
+	} else {
+		libsha2_dispatch.process64(key->inner.b64, ipad, 1);
+		libsha2_dispatch.process64(key->outer.b64, opad, 1);
+	}
+	key->algorithm = algorithm;
+	key->__padding1 = 0;
+
+	return 0;
+}
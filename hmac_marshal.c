@@ -6,10 +6,10 @@ size_t
 libsha2_hmac_marshal(const struct libsha2_hmac_state *restrict state, void *restrict buf_)
 {
 	char *restrict buf = buf_;
-	size_t off = 0;
+	size_t off = 0, hsize;
 
 	if (buf)
-		*(int *)buf = 0; /* version */
+		*(int *)buf = 1; /* version */
 	off += sizeof(int);
 
 	off += libsha2_marshal(&state->sha2_state, buf ? &buf[off] : NULL);
@@ -18,17 +18,15 @@ libsha2_hmac_marshal(const struct libsha2_hmac_state *restrict state, void *rest
 		*(size_t *)&buf[off] = state->outsize;
 	off += sizeof(size_t);
 
-	if (buf)
-		*(unsigned char *)&buf[off] = state->inited;
-	off += sizeof(unsigned char);
+	hsize = state->key.algorithm <= LIBSHA2_256 ? sizeof(state->key.inner.b32) : sizeof(state->key.inner.b64);
 
 	if (buf)
-		memcpy(&buf[off], state->ipad, state->sha2_state.chunk_size);
-	off += state->sha2_state.chunk_size;
+		memcpy(&buf[off], &state->key.inner, hsize);
+	off += hsize;
 
 	if (buf)
-		memcpy(&buf[off], state->opad, state->sha2_state.chunk_size);
-	off += state->sha2_state.chunk_size;
+		memcpy(&buf[off], &state->key.outer, hsize);
+	off += hsize;
 
 	return off;
 }
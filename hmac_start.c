@@ -0,0 +1,13 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_hmac_start(struct libsha2_state *restrict state, const union libsha2_hash_values *restrict h,
+                   enum libsha2_algorithm algorithm)
+{
+	state->h = *h;
+	state->chunk_size = algorithm <= LIBSHA2_256 ? 64 : 128;
+	state->message_size = state->chunk_size * 8;
+	state->algorithm = algorithm;
+}
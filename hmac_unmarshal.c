@@ -6,15 +6,19 @@ size_t
 libsha2_hmac_unmarshal(struct libsha2_hmac_state *restrict state, const void *restrict buf_, size_t bufsize)
 {
 	const char *restrict buf = buf_;
-	size_t off = 0;
+	struct libsha2_state pad_state;
+	size_t off = 0, hsize;
 	size_t r;
+	int version;
+	unsigned char inited;
 
 	if (bufsize < sizeof(int)) {
 		errno = EINVAL;
 		return 0;
 	}
 
-	if (*(const int *)buf) { /* version */
+	version = *(const int *)buf;
+	if (version < 0 || version > 1) { /* version */
 		errno = EINVAL;
 		return 0;
 	}
@@ -25,7 +29,46 @@ libsha2_hmac_unmarshal(struct libsha2_hmac_state *restrict state, const void *re
 		return 0;
 	off += r;
 
-	if (bufsize - off < sizeof(size_t) + sizeof(unsigned char) + 2 * state->sha2_state.chunk_size) {
+	state->key.algorithm = state->sha2_state.algorithm;
+	state->key.__padding1 = 0;
+	hsize = state->key.algorithm <= LIBSHA2_256 ? sizeof(state->key.inner.b32) : sizeof(state->key.inner.b64);
+
+	if (version == 0) {
+		/* Version 0 stored the pads rather than the hash values after them,
+		 * and, until data was fed, left the hash function uninitialised */
+		if (bufsize - off < sizeof(size_t) + sizeof(unsigned char) + 2 * state->sha2_state.chunk_size) {
+			errno = EINVAL;
+			return 0;
+		}
+
+		state->outsize = *(const size_t *)&buf[off];
+		off += sizeof(size_t);
+
+		inited = *(const unsigned char *)&buf[off];
+		off += sizeof(unsigned char);
+
+		libsha2_init(&pad_state, state->key.algorithm);
+		state->key.inner = pad_state.h;
+		state->key.outer = pad_state.h;
+		if (state->key.algorithm <= LIBSHA2_256) {
+			libsha2_dispatch.process32(state->key.inner.b32, (const void *)&buf[off], 1);
+			off += state->sha2_state.chunk_size;
+			libsha2_dispatch.process32(state->key.outer.b32, (const void *)&buf[off], 1);
+			off += state->sha2_state.chunk_size;
+		} else {
+			libsha2_dispatch.process64(state->key.inner.b64, (const void *)&buf[off], 1);
+			off += state->sha2_state.chunk_size;
+			libsha2_dispatch.process64(state->key.outer.b64, (const void *)&buf[off], 1);
+			off += state->sha2_state.chunk_size;
+		}
+
+		if (!inited)
+			libsha2_hmac_start(&state->sha2_state, &state->key.inner, state->key.algorithm);
+
+		return off;
+	}
+
+	if (bufsize - off < sizeof(size_t) + 2 * hsize) {
 		errno = EINVAL;
 		return 0;
 	}
@@ -33,14 +76,11 @@ libsha2_hmac_unmarshal(struct libsha2_hmac_state *restrict state, const void *re
 	state->outsize = *(const size_t *)&buf[off];
 	off += sizeof(size_t);
 
-	state->inited = *(const unsigned char *)&buf[off];
-	off += sizeof(unsigned char);
-
-	memcpy(state->ipad, &buf[off], state->sha2_state.chunk_size);
-	off += state->sha2_state.chunk_size;
+	memcpy(&state->key.inner, &buf[off], hsize);
+	off += hsize;
 
-	memcpy(state->opad, &buf[off], state->sha2_state.chunk_size);
-	off += state->sha2_state.chunk_size;
+	memcpy(&state->key.outer, &buf[off], hsize);
+	off += hsize;
 
 	return off;
 }
@@ -0,0 +1,52 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Compare two byte strings in a time that
+ * does not depend on where they differ
+ * 
+ * @param   a  One of the strings
+ * @param   b  The other string
+ * @param   n  The length of the strings
+ * @return     1 if the strings are equal, 0 otherwise
+ */
+static unsigned char
+equal(const unsigned char *a, const unsigned char *b, size_t n)
+{
+	unsigned diff = 0;
+	while (n--)
+		diff |= (unsigned)(a[n] ^ b[n]);
+	return (unsigned char)(1 & ((diff - 1) >> 8));
+}
+
+
+int
+libsha2_hmac_verify_many(const struct libsha2_hmac_key *const *keys, const void *const *messages,
+                         const size_t *msglens, size_t n, const void *macs_, unsigned char *valid)
+{
+	const unsigned char *macs = macs_;
+	unsigned char outputs[LIBSHA2_BATCH_SIZE * 64];
+	size_t i, j, outsize, batch;
+
+	if (!n)
+		return 0;
+
+	outsize = libsha2_algorithm_output_size(keys[0]->algorithm);
+	for (i = 1; i < n && outsize; i++)
+		if (keys[i]->algorithm != keys[0]->algorithm)
+			outsize = 0;
+	if (!outsize) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (i = 0; i < n; i += batch) {
+		batch = n - i < LIBSHA2_BATCH_SIZE ? n - i : LIBSHA2_BATCH_SIZE;
+		libsha2_hmac_digest_many(&keys[i], &messages[i], &msglens[i], batch, outputs);
+		for (j = 0; j < batch; j++)
+			valid[i + j] = equal(&outputs[j * outsize], &macs[(i + j) * outsize], outsize);
+	}
+
+	return 0;
+}
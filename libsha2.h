@@ -2,6 +2,7 @@
 #ifndef LIBSHA2_H
 #define LIBSHA2_H  1
 
+#include <sys/types.h>
 #include <errno.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -43,237 +44,1180 @@ enum libsha2_algorithm {
 	LIBSHA2_512_256
 };
 
+/**
+ * Hash values (the chaining values) of a hashing process
+ */
+union libsha2_hash_values {
+	/**
+	 * For 32-bit algorithms
+	 */
+	uint_least32_t b32[8];
+
+	/**
+	 * For 64-bit algorithms
+	 */
+	uint_least64_t b64[8];
+};
+
 /**
  * Data structure that describes the state of a hashing process
  * 
- * Data that could just as well be allocated (with `auto`) are
- * allocated here so that is is easier to wipe the data without
- * exposing two versions of each function: one to wipe data,
- * and one not to wipe data to gain speed, now you can use use
- * `explicit_bzero` (or `memset`) when you are done.
+ * The round constants are shared by all states, and the
+ * scratch space used while processing chunks is kept on
+ * the stack, so only what is needed to resume a hashing
+ * is stored. The members are ordered so that, if the
+ * state is aligned to 64 bytes, the hash values fill one
+ * cache line and everything the library reads on every
+ * call is in the first two.
+ * 
+ * The state can be wiped with `explicit_bzero` (or `memset`)
+ * when you are done, but this does not wipe the message
+ * schedule and working variables left on the stack, which
+ * are derived from the message; if the message is secret,
+ * that stack memory must be wiped or discarded separately.
  */
 struct libsha2_state {
 
+	/**
+	 * Hashing values
+	 */
+	union libsha2_hash_values h;
+
 	/**
 	 * The size of the message, as far as processed, in bits;
 	 */
 	size_t message_size;
 
 	/**
-	 * Round constants
+	 * The size of the chunks, in bytes
 	 */
-	union {
-		/**
-		 * For 32-bit algorithms
-		 */
-		uint_least32_t b32[64];
-    
-		/**
-		 * For 64-bit algorithms
-		 */
-		uint_least64_t b64[80];
-	} k;
+	size_t chunk_size;
 
 	/**
-	 * Words
-	 * 
-	 * Does not need to be marshalled
+	 * The algorithm that is used
 	 */
-	union {
-		/**
-		 * For 32-bit algorithms
-		 */
-		uint_least32_t b32[64];
+	enum libsha2_algorithm algorithm;
 
-		/**
-		 * For 64-bit algorithms
-		 */
-		uint_least64_t b64[80];
-	} w;
+	int __padding1;
 
 	/**
-	 * Hashing values
+	 * Space for chunks to process, limited
+	 * to 64 bytes on 32-bit algorithms
 	 */
-	union {
-		/**
-		 * For 32-bit algorithms
-		 */
-		uint_least32_t b32[8];
+	unsigned char chunk[128];
+};
 
-		/**
-		 * For 64-bit algorithms
-		 */
-		uint_least64_t b64[8];
-	} h;
+
+/**
+ * The size of the buffer `libsha2_crypt` needs for its
+ * output, enough for the longest setting and the hash
+ * of a sha512crypt hash, and a NUL byte
+ */
+#define LIBSHA2_CRYPT_SIZE 124
+
+/**
+ * The maximum number of bytes `libsha2_marshal` can
+ * write, and thus the size of a checkpoint for
+ * `libsha2_sum_fd_resume`
+ */
+#define LIBSHA2_MARSHAL_SIZE (sizeof(int) + sizeof(enum libsha2_algorithm) + 2 * sizeof(size_t) + 64 + 128)
+
+/**
+ * Map regular files into memory, a window at a time, and
+ * hash them directly from the page cache, rather than
+ * reading them; the process receives a `SIGBUS` signal
+ * if the file is truncated while it is mapped
+ */
+#define LIBSHA2_MAP 0x0001
+
+/**
+ * Fault in each mapped window in advance (`MAP_POPULATE`)
+ */
+#define LIBSHA2_MAP_POPULATE 0x0002
+
+/**
+ * Back each mapped window with huge pages if
+ * possible (`MADV_HUGEPAGE`)
+ */
+#define LIBSHA2_MAP_HUGEPAGE 0x0004
+
+/**
+ * A key prepared for HMAC hashing
+ * 
+ * The key is stored as the hash values that result from
+ * processing the inner and the outer pad XOR the processed
+ * key, so that neither block has to be processed again
+ * for each message. Once prepared, the key is only read,
+ * so it can be shared between threads.
+ * 
+ * The hash values are derived from the key, so they should
+ * be wiped with `explicit_bzero` (or `memset`) when you
+ * are done with the key.
+ */
+struct libsha2_hmac_key {
 
 	/**
-	 * Temporary hashing values
-	 * 
-	 * Does not need to be marshalled
+	 * The hash values after the inner pad
+	 * XOR processed key has been processed
 	 */
-	union {
-		/**
-		 * For 32-bit algorithms
-		 */
-		uint_least32_t b32[8];
+	union libsha2_hash_values inner;
 
-		/**
-		 * For 64-bit algorithms
-		 */
-		uint_least64_t b64[8];
-	} work_h;
+	/**
+	 * The hash values after the outer pad
+	 * XOR processed key has been processed
+	 */
+	union libsha2_hash_values outer;
 
 	/**
-	 * Space for chunks to process, limited
-	 * to 64 bytes on 32-bit algorithms
+	 * The underlaying hash algorithm
 	 */
-	unsigned char chunk[128];
+	enum libsha2_algorithm algorithm;
+
+	int __padding1;
+};
+
+/**
+ * Data structure that describes the state of a HMAC hashing process
+ * 
+ * The state can be wiped with `explicit_bzero` (or `memset`)
+ * when you are done, but, as for `struct libsha2_state`, this
+ * does not wipe the scratch space that was used on the stack
+ * while processing the key and the message.
+ */
+struct libsha2_hmac_state {
 
 	/**
-	 * The size of the chunks, in bytes
+	 * State of the underlaying hash function,
+	 * always ready to have the message fed
+	 * into it
 	 */
-	size_t chunk_size;
+	struct libsha2_state sha2_state;
 
 	/**
-	 * The algorithm that is used
+	 * The output size of the underlaying
+	 * hash algorithm, in bits
+	 */
+	size_t outsize;
+
+	/**
+	 * The prepared key
+	 */
+	struct libsha2_hmac_key key;
+};
+
+/**
+ * The maximum number of levels in a verity hash tree
+ */
+#define LIBSHA2_VERITY_MAX_LEVELS 32
+
+/**
+ * Verity hash tree formats
+ */
+enum libsha2_verity_format {
+
+	/**
+	 * dm-verity, hash format version 1, with the hashes
+	 * stored in the same block size as the data
+	 */
+	LIBSHA2_VERITY_DM,
+
+	/**
+	 * fs-verity
+	 */
+	LIBSHA2_VERITY_FS
+};
+
+/**
+ * The parameters and geometry of a verity hash tree
+ * 
+ * The members are private
+ */
+struct libsha2_verity {
+
+	/**
+	 * Hashing state that has been fed the salt,
+	 * padded if the format pads it
+	 */
+	struct libsha2_state salted;
+
+	/**
+	 * The size of the data, in bytes
+	 */
+	uint_least64_t data_size;
+
+	/**
+	 * The number of data blocks
+	 */
+	uint_least64_t data_blocks;
+
+	/**
+	 * The index, in the tree, of the first block of each level,
+	 * level 0 being the one that holds the hashes of the data
+	 */
+	uint_least64_t level_start[LIBSHA2_VERITY_MAX_LEVELS];
+
+	/**
+	 * The number of blocks in each level
+	 */
+	uint_least64_t level_blocks[LIBSHA2_VERITY_MAX_LEVELS];
+
+	/**
+	 * The number of blocks in the tree
+	 */
+	uint_least64_t tree_blocks;
+
+	/**
+	 * The size of each block, in bytes
+	 */
+	size_t block_size;
+
+	/**
+	 * The space each hash takes up in the tree, in bytes
+	 */
+	size_t digest_stride;
+
+	/**
+	 * The number of levels in the tree
+	 */
+	size_t levels;
+
+	/**
+	 * The length of the salt, in bytes
+	 */
+	size_t salt_size;
+
+	/**
+	 * The format of the tree
+	 */
+	enum libsha2_verity_format format;
+
+	int __padding1;
+
+	/**
+	 * The salt, if the format is `LIBSHA2_VERITY_FS`
+	 */
+	unsigned char salt[32];
+};
+
+/**
+ * The maximum number of levels in a Merkle tree log
+ */
+#define LIBSHA2_MERKLE_MAX_LEVELS 64
+
+/**
+ * The maximum number of hashes in a Merkle tree proof
+ */
+#define LIBSHA2_MERKLE_MAX_PROOF (LIBSHA2_MERKLE_MAX_LEVELS + 1)
+
+/**
+ * An append-only Merkle tree log, as specified in RFC 6962
+ * (Certificate Transparency), that keeps the hash of
+ * every perfect subtree
+ * 
+ * The members are private
+ */
+struct libsha2_merkle {
+
+	/**
+	 * The hashes of the perfect subtrees of each height,
+	 * left to right, level 0 being the leaf hashes
+	 */
+	unsigned char *levels[LIBSHA2_MERKLE_MAX_LEVELS];
+
+	/**
+	 * The number of hashes allocated for each level
+	 */
+	size_t capacity[LIBSHA2_MERKLE_MAX_LEVELS];
+
+	/**
+	 * The number of leaves
+	 */
+	size_t size;
+
+	/**
+	 * The size of each hash
+	 */
+	size_t hash_size;
+
+	/**
+	 * The hashing algorithm
 	 */
 	enum libsha2_algorithm algorithm;
 
-	int __padding1;
-};
+	int __padding1;
+};
+
+/**
+ * The state of content-defined chunking of a stream
+ * 
+ * The members are private
+ */
+struct libsha2_cdc {
+
+	/**
+	 * The hashing state for the current chunk, fed with the
+	 * parts of the chunk that were given in earlier calls
+	 */
+	struct libsha2_state state;
+
+	/**
+	 * The offset of the current chunk in the stream
+	 */
+	uint_least64_t offset;
+
+	/**
+	 * The rolling hash
+	 */
+	uint_least64_t fingerprint;
+
+	/**
+	 * The mask the rolling hash is tested with before
+	 * the current chunk reaches `.avg_size` bytes
+	 */
+	uint_least64_t mask_small;
+
+	/**
+	 * The mask the rolling hash is tested with after
+	 * the current chunk has reached `.avg_size` bytes
+	 */
+	uint_least64_t mask_large;
+
+	/**
+	 * The number of bytes in the current chunk so far
+	 */
+	size_t length;
+
+	/**
+	 * The minimum chunk size
+	 */
+	size_t min_size;
+
+	/**
+	 * The normal chunk size
+	 */
+	size_t avg_size;
+
+	/**
+	 * The maximum chunk size
+	 */
+	size_t max_size;
+};
+
+/**
+ * A chunk found by content-defined chunking
+ */
+struct libsha2_cdc_chunk {
+	/**
+	 * The offset of the chunk in the stream
+	 */
+	uint_least64_t offset;
+
+	/**
+	 * The length of the chunk, in bytes
+	 */
+	size_t length;
+
+	/**
+	 * The hash of the chunk
+	 */
+	unsigned char digest[64];
+};
+
+/**
+ * A persistent cache of file hashes, keyed by the
+ * files' device and inode numbers, sizes, and
+ * modification and status change times
+ * 
+ * The members are private
+ */
+struct libsha2_cache {
+
+	/**
+	 * The path of the cache file
+	 */
+	char *path;
+
+	/**
+	 * The file descriptor of the cache file
+	 */
+	int fd;
+
+	int __padding1;
+
+	/**
+	 * The cache file, mapped into memory
+	 */
+	const unsigned char *map;
+
+	/**
+	 * The number of mapped bytes
+	 */
+	size_t mapsize;
+
+	/**
+	 * The number of records that have been indexed
+	 */
+	size_t nrecords;
+
+	/**
+	 * Hash table of the records, 1 + the index of
+	 * a record, or 0 for an empty slot
+	 */
+	size_t *table;
+
+	/**
+	 * The number of slots in `.table`, a power of 2
+	 */
+	size_t tablesize;
+
+	/**
+	 * The number of occupied slots in `.table`
+	 */
+	size_t used;
+};
+
+
+/**
+ * Initialise a state
+ * 
+ * @param   state      The state that should be initialised
+ * @param   algorithm  The hashing algorithm
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nothrow__, __nonnull__))
+#endif
+int libsha2_init(struct libsha2_state *restrict, enum libsha2_algorithm);
+
+/**
+ * Get the output size of an algorithm
+ * 
+ * @param   algorithm  The hashing algorithm
+ * @return             The number of bytes in the output, zero on error
+ */
+#if defined(__GNUC__)
+__attribute__((__warn_unused_result__, __nothrow__))
+#endif
+inline size_t
+libsha2_algorithm_output_size(enum libsha2_algorithm algorithm__)
+{
+	switch (algorithm__) {
+	case LIBSHA2_224:     return 28;
+	case LIBSHA2_256:     return 32;
+	case LIBSHA2_384:     return 48;
+	case LIBSHA2_512:     return 64;
+	case LIBSHA2_512_224: return 28;
+	case LIBSHA2_512_256: return 32;
+	default:
+		errno = EINVAL;
+		return 0;
+	}
+}
+
+/**
+ * Get the output size of the algorithm specified for a state
+ * 
+ * @param   state  The state
+ * @return         The number of bytes in the output, zero on error
+ */
+#if defined(__GNUC__)
+__attribute__((__warn_unused_result__, __nothrow__, __nonnull__))
+#endif
+inline size_t
+libsha2_state_output_size(const struct libsha2_state *restrict state__)
+{
+	return libsha2_algorithm_output_size(state__->algorithm);
+}
+
+/**
+ * Make a copy of a state, so that two messages
+ * with a common prefix can be hashed without
+ * processing the prefix twice
+ * 
+ * Only the parts of the state that are in use
+ * are copied, which makes this cheaper than
+ * copying the entire structure
+ * 
+ * @param  dest  Output parameter for the copy
+ * @param  src   The state to copy
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+void libsha2_state_copy(struct libsha2_state *restrict, const struct libsha2_state *restrict);
+
+/**
+ * Absorb more of the message
+ * 
+ * @param  state    The hashing state
+ * @param  message  The message, in bits, must be equivalent to 0 modulus 8
+ * @param  msglen   The length of the message
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_update(struct libsha2_state *restrict, const void *restrict, size_t);
+
+/**
+ * Absorb the last part of the message and output a hash
+ * 
+ * @param  state    The hashing state
+ * @param  message  The message, in bits
+ * @param  msglen   The length of the message, zero if there is nothing more to absorb
+ * @param  output   The output buffer for the hash
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 4), __nothrow__))
+#endif
+void libsha2_digest(struct libsha2_state *restrict, const void *, size_t, void *);
+
+/**
+ * Absorb the last part of a number of messages, each with
+ * its own state, and output their hashes
+ * 
+ * This is equivalent to calling `libsha2_digest` for each
+ * state, except that multiple messages are processed in
+ * parallel if supported by the machine
+ * 
+ * @param  states    The hashing states, all must be distinct
+ * @param  messages  The message for each state, in bits
+ * @param  msglens   The length of each message, zero if there is nothing more to absorb
+ * @param  outputs   The output buffer for each hash
+ * @param  n         The number of states
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_digest_multi(struct libsha2_state *const *restrict, const void *const *, const size_t *, void *const *, size_t);
+
+/**
+ * Calculate the hashes of a number of messages
+ * 
+ * This is equivalent to calling `libsha2_hash` for
+ * each message, except that multiple messages are
+ * processed in parallel if supported by the machine
+ * 
+ * @param   algorithm  The hashing algorithm
+ * @param   messages   The messages, in bits
+ * @param   msglens    The length of each message
+ * @param   n          The number of messages
+ * @param   outputs    Output buffer for the hashes, the hash of the
+ *                     i:th message is stored at offset `i` times
+ *                     the output size of the algorithm
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+int libsha2_digest_many(enum libsha2_algorithm, const void *const *, const size_t *, size_t, void *);
+
+/**
+ * Calculate a checksum for each fixed-size piece of a
+ * buffer, hashing the pieces in parallel, across threads
+ * and, when the machine supports it, lanes
+ * 
+ * @param   algorithm   The hashing algorithm
+ * @param   data        The data
+ * @param   len         The length of the data, in bytes
+ * @param   piece_size  The size of each piece, in bytes, the last
+ *                      piece is shorter unless `len` is a multiple
+ *                      of `piece_size`
+ * @param   hashsums    Output buffer for the hashes of the pieces,
+ *                      one after another
+ * @param   hashsum     Output buffer for the hash of the whole data,
+ *                      calculated in parallel with the pieces; or `NULL`
+ * @param   threads     The number of threads, 0 for one per processor
+ * @return              Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(5)))
+#endif
+int libsha2_digest_pieces(enum libsha2_algorithm, const void *, size_t, size_t, void *, void *, size_t);
+
+/**
+ * Initialise a state for content-defined chunking of a
+ * stream, with FastCDC, hashing each chunk
+ * 
+ * @param   cdc        The state to initialise
+ * @param   algorithm  The hashing algorithm
+ * @param   min_size   The minimum chunk size, 0 for 2048 bytes
+ * @param   avg_size   The normal chunk size, a power of 2 of at least
+ *                     64 and at most 2 to the power of 30, or 0 for
+ *                     8192 bytes
+ * @param   max_size   The maximum chunk size, 0 for 65536 bytes
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_cdc_init(struct libsha2_cdc *restrict, enum libsha2_algorithm, size_t, size_t, size_t);
+
+/**
+ * Feed data into content-defined chunking, and get the
+ * chunks that end in the data, with their hashes
+ * 
+ * Chunks that are wholly within the data are hashed
+ * in parallel when the machine supports it
+ * 
+ * @param   cdc      The state
+ * @param   data     The data
+ * @param   len      The length of the data, in bytes
+ * @param   chunks   Output buffer for the chunks
+ * @param   nchunks  The number of chunks `chunks` has room for;
+ *                   output parameter for the number of chunks
+ * @return           The number of bytes consumed, less than `len`
+ *                   only if `chunks` is full, in which case the
+ *                   rest shall be fed again
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 4, 5), __nothrow__))
+#endif
+size_t libsha2_cdc_update(struct libsha2_cdc *restrict, const void *, size_t, struct libsha2_cdc_chunk *restrict, size_t *);
+
+/**
+ * End the stream, and get the last chunk, and
+ * reset the state for a new stream
+ * 
+ * @param   cdc    The state
+ * @param   chunk  Output parameter for the last chunk
+ * @return         1 if a chunk was stored in `chunk`,
+ *                 0 if the stream ended with a chunk
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+size_t libsha2_cdc_finish(struct libsha2_cdc *restrict, struct libsha2_cdc_chunk *restrict);
+
+/**
+ * Set up the parameters of a verity hash tree, a Merkle
+ * tree over fixed-size blocks that allows each block
+ * to be verified on its own
+ * 
+ * @param   verity      Output parameter for the parameters and geometry
+ * @param   format      The format of the tree
+ * @param   algorithm   The hashing algorithm, `LIBSHA2_256` or `LIBSHA2_512`
+ *                      for `LIBSHA2_VERITY_FS`
+ * @param   block_size  The size of each data and tree block, a power of 2
+ *                      of at least 512 (1024 for `LIBSHA2_VERITY_FS`) and
+ *                      at most 65536
+ * @param   salt        The salt, may be `NULL` if `salt_size` is 0
+ * @param   salt_size   The length of the salt, in bytes, at most 256
+ *                      (32 for `LIBSHA2_VERITY_FS`)
+ * @param   data_size   The size of the data, in bytes, must not be 0
+ *                      for `LIBSHA2_VERITY_DM`
+ * @param   tree_size   Output parameter for the size of the tree, in bytes
+ * @return              Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 8), __nothrow__))
+#endif
+int libsha2_verity_init(struct libsha2_verity *restrict, enum libsha2_verity_format, enum libsha2_algorithm,
+                        size_t, const void *, size_t, uint_least64_t, uint_least64_t *);
+
+/**
+ * Build a verity hash tree for data in memory, hashing
+ * each level in parallel, across threads and, when the
+ * machine supports it, lanes
+ * 
+ * @param   verity   The parameters, from `libsha2_verity_init`
+ * @param   data     The data
+ * @param   tree     Output buffer for the tree
+ * @param   root     Output buffer for the root hash
+ * @param   threads  The number of threads, 0 for one per processor
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 4)))
+#endif
+int libsha2_verity_build(const struct libsha2_verity *restrict, const void *, void *, void *, size_t);
+
+/**
+ * Build a verity hash tree for a file, hashing
+ * each level in parallel, across threads and, when
+ * the machine supports it, lanes
+ * 
+ * @param   verity   The parameters, from `libsha2_verity_init`
+ * @param   fd       The file descriptor of the file, which is read with
+ *                   pread(3) from offset 0, and must be at least as
+ *                   large as the data size given to `libsha2_verity_init`
+ * @param   tree     Output buffer for the tree
+ * @param   root     Output buffer for the root hash
+ * @param   threads  The number of threads, 0 for one per processor
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 4)))
+#endif
+int libsha2_verity_build_fd(const struct libsha2_verity *restrict, int, void *, void *, size_t);
+
+/**
+ * Verify a data block against a verity hash tree
+ * 
+ * Only the tree blocks on the path from the data block to
+ * the root that have not already been verified are hashed
+ * 
+ * @param   verity    The parameters, from `libsha2_verity_init`
+ * @param   root      The trusted root hash
+ * @param   tree      The tree, which need not be trusted
+ * @param   verified  Bitmap, with one bit per tree block, least
+ *                    significant bit first, of the tree blocks that
+ *                    have been verified, which is updated; initially
+ *                    zeroed; or `NULL`
+ * @param   index     The index of the data block
+ * @param   block     The data block, the last block shall be
+ *                    padded with zeroes to the block size
+ * @return            Zero if the block is authentic, -1 otherwise
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1, 2, 3, 6)))
+#endif
+int libsha2_verity_verify(const struct libsha2_verity *restrict, const void *, const void *,
+                          unsigned char *, uint_least64_t, const void *);
+
+/**
+ * Calculate the fs-verity file digest, which is what
+ * fs-verity signs and reports as the file's measurement
+ * 
+ * @param   verity  The parameters, from `libsha2_verity_init`,
+ *                  with the format `LIBSHA2_VERITY_FS`
+ * @param   root    The root hash of the tree
+ * @param   digest  Output buffer for the file digest
+ * @return          Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_fsverity_digest(const struct libsha2_verity *restrict, const void *, void *);
+
+/**
+ * Calculate the Merkle tree hash, as specified in RFC 6962
+ * (Certificate Transparency), of a list of entries
+ * 
+ * Leaves are hashed as the byte 0 followed by the entry,
+ * and interior nodes as the byte 1 followed by the hashes
+ * of the two children
+ * 
+ * @param   algorithm  The hashing algorithm
+ * @param   entries    The entries
+ * @param   lens       The length of each entry, in bytes
+ * @param   n          The number of entries
+ * @param   root       Output buffer for the tree hash
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(5)))
+#endif
+int libsha2_merkle_tree_hash(enum libsha2_algorithm, const void *const *, const size_t *, size_t, void *);
+
+/**
+ * Create an empty Merkle tree log
+ * 
+ * @param   merkle     Output parameter for the log
+ * @param   algorithm  The hashing algorithm
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_merkle_init(struct libsha2_merkle *restrict, enum libsha2_algorithm);
+
+/**
+ * Release the resources of a Merkle tree log
+ * 
+ * @param  merkle  The log
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_merkle_destroy(struct libsha2_merkle *restrict);
+
+/**
+ * Append entries to a Merkle tree log
+ * 
+ * Only the leaves of the entries, and the subtrees
+ * they complete, are hashed
+ * 
+ * @param   merkle   The log
+ * @param   entries  The entries
+ * @param   lens     The length of each entry, in bytes
+ * @param   n        The number of entries
+ * @return           Zero on success, -1 on error, in which
+ *                   case the log is unchanged
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1)))
+#endif
+int libsha2_merkle_append(struct libsha2_merkle *restrict, const void *const *, const size_t *, size_t);
+
+/**
+ * Get the tree hash of a Merkle tree log, as
+ * it was when it had a specific number of entries
+ * 
+ * @param   merkle  The log
+ * @param   size    The number of entries, at most the
+ *                  number of entries in the log
+ * @param   root    Output buffer for the tree hash
+ * @return          Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_merkle_root(const struct libsha2_merkle *restrict, size_t, void *);
+
+/**
+ * Get the audit path, as specified in RFC 6962, that proves
+ * that an entry is included in a Merkle tree log, as it was
+ * when it had a specific number of entries
+ * 
+ * @param   merkle   The log
+ * @param   index    The index of the entry
+ * @param   size     The number of entries, greater than `index`
+ *                   and at most the number of entries in the log
+ * @param   proof    Output buffer for the hashes of the proof, large
+ *                   enough for `LIBSHA2_MERKLE_MAX_PROOF` hashes
+ * @param   nhashes  Output parameter for the number of hashes in the proof
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_merkle_inclusion_proof(const struct libsha2_merkle *restrict, size_t, size_t, void *, size_t *);
+
+/**
+ * Get the proof, as specified in RFC 6962, that a Merkle tree
+ * log with a number of entries is a prefix of the log with
+ * a greater number of entries
+ * 
+ * @param   merkle    The log
+ * @param   old_size  The smaller number of entries, at least 1
+ * @param   new_size  The greater number of entries, at least `old_size`,
+ *                    and at most the number of entries in the log
+ * @param   proof     Output buffer for the hashes of the proof, large
+ *                    enough for `LIBSHA2_MERKLE_MAX_PROOF` hashes
+ * @param   nhashes   Output parameter for the number of hashes in the proof
+ * @return            Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_merkle_consistency_proof(const struct libsha2_merkle *restrict, size_t, size_t, void *, size_t *);
+
+/**
+ * Calculate the hash of a message
+ * 
+ * This is equivalent to calling `libsha2_init`
+ * followed by `libsha2_digest`, but is faster
+ * for short messages
+ * 
+ * @param   algorithm  The hashing algorithm
+ * @param   message    The message, in bits
+ * @param   msglen     The length of the message
+ * @param   output     Output buffer for the hash
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(4), __nothrow__))
+#endif
+int libsha2_hash(enum libsha2_algorithm, const void *, size_t, void *);
+
+/**
+ * Calculate the SHA-256 hash of a 64-byte message
+ * 
+ * This is equivalent to calling `libsha2_hash` with
+ * `LIBSHA2_256` and a message length of 512 bits,
+ * but is faster as the padding is known in advance
+ * 
+ * @param  message  The message, 64 bytes
+ * @param  hashsum  Output buffer for the hash, 32 bytes
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_sha256_64(const void *restrict, void *restrict);
 
+/**
+ * Calculate the SHA-256 hashes of multiple 64-byte
+ * messages, such as pairs of 32-byte hashes in a
+ * hash tree, in parallel if supported
+ * 
+ * @param  messages  The messages, 64 bytes each, one after another
+ * @param  n         The number of messages
+ * @param  hashsums  Output buffer for the hashes, 32 bytes each,
+ *                   in the same order as the messages
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_sha256_64_many(const void *restrict, size_t, void *restrict);
 
 /**
- * Data structure that describes the state of a HMAC hashing process
+ * Calculate the double SHA-256 hash of a message,
+ * that is, the SHA-256 hash of its SHA-256 hash
  * 
- * Data that could just as well be allocated (with `auto`) are
- * allocated here so that is is easier to wipe the data without
- * exposing two versions of each function: one to wipe data,
- * and one not to wipe data to gain speed, now you can use use
- * `explicit_bzero` (or `memset`) when you are done.
+ * @param  message  The message
+ * @param  msglen   The length of the message, in bits
+ * @param  hashsum  Output buffer for the hash, 32 bytes
  */
-struct libsha2_hmac_state {
+#if defined(__GNUC__)
+__attribute__((__nonnull__(3), __nothrow__))
+#endif
+void libsha2_sha256d(const void *restrict, size_t, void *restrict);
 
-	/**
-	 * State of the underlaying hash function
-	 */
-	struct libsha2_state sha2_state;
+/**
+ * Calculate the double SHA-256 hashes of multiple
+ * 64-byte messages, in parallel if supported
+ * 
+ * @param  messages  The messages, 64 bytes each, one after another
+ * @param  n         The number of messages
+ * @param  hashsums  Output buffer for the hashes, 32 bytes each,
+ *                   in the same order as the messages
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+void libsha2_sha256d_64_many(const void *restrict, size_t, void *restrict);
 
-	/**
-	 * The output size of the underlaying
-	 * hash algorithm, in bits
-	 */
-	size_t outsize;
+/**
+ * Calculate the checksum for a file,
+ * the content of the file is assumed non-sensitive
+ * 
+ * @param   fd         The file descriptor of the file
+ * @param   algorithm  The hashing algorithm
+ * @param   hashsum    Output buffer for the hash
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __leaf__))
+#endif
+int libsha2_sum_fd(int, enum libsha2_algorithm, void *restrict);
 
-	/**
-	 * Whether `.sha2_state` has been initialised
-	 * and whether the `ipad` has been feed into
-	 * the algorithm
-	 */
-	unsigned char inited;
+/**
+ * Calculate the checksum for a file, mapping regular files
+ * into memory rather than reading them, the content of the
+ * file is assumed non-sensitive
+ * 
+ * The process receives a `SIGBUS` signal if the
+ * file is truncated while it is being hashed
+ * 
+ * @param   fd         The file descriptor of the file
+ * @param   algorithm  The hashing algorithm
+ * @param   hashsum    Output buffer for the hash
+ * @param   flags      Bitwise OR of `LIBSHA2_MAP_POPULATE`
+ *                     and `LIBSHA2_MAP_HUGEPAGE`, or 0
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __leaf__))
+#endif
+int libsha2_sum_fd_mapped(int, enum libsha2_algorithm, void *restrict, int);
 
-	/**
-	 * Inner pad XOR processed key
-	 */
-	unsigned char ipad[128];
+/**
+ * Calculate the checksum for a file, reading the file
+ * into multiple buffers at the same time, so that the
+ * reading overlaps the hashing; the content of the file
+ * is assumed non-sensitive
+ * 
+ * The file may be opened with `O_DIRECT`, if the
+ * file offset is aligned to 4096 bytes
+ * 
+ * @param   fd         The file descriptor of the file
+ * @param   algorithm  The hashing algorithm
+ * @param   hashsum    Output buffer for the hash
+ * @param   depth      The number of buffers, 0 for the default
+ * @param   bufsize    The size of each buffer, rounded up to a
+ *                     multiple of 4096 bytes, 0 for the default
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__))
+#endif
+int libsha2_sum_fd_queued(int, enum libsha2_algorithm, void *restrict, size_t, size_t);
 
-	/**
-	 * Outer pad XOR processed key
-	 */
-	unsigned char opad[128];
-};
+/**
+ * Calculate the checksum for a file that is only ever
+ * appended to, continuing from a checkpoint saved by
+ * an earlier call, so that only the bytes appended
+ * since then are read
+ * 
+ * @param   fd               The file descriptor of the file, must be seekable
+ * @param   algorithm        The hashing algorithm
+ * @param   hashsum          Output buffer for the hash of the whole file
+ * @param   checkpoint       The checkpoint from the last call, output buffer
+ *                           for the new checkpoint, `LIBSHA2_MARSHAL_SIZE`
+ *                           bytes large
+ * @param   checkpoint_size  The size of the checkpoint in `checkpoint`, 0 if
+ *                           there is none; output parameter for the size of
+ *                           the new checkpoint
+ * @param   offset           The offset the checkpoint was made at, 0 if there
+ *                           is no checkpoint; output parameter for the offset
+ *                           the new checkpoint is made at
+ * @return                   Zero on success, -1 on error, in which case
+ *                           `checkpoint`, `*checkpoint_size`, and `*offset`
+ *                           are unmodified
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__))
+#endif
+int libsha2_sum_fd_resume(int, enum libsha2_algorithm, void *restrict, void *restrict, size_t *restrict, off_t *restrict);
 
+/**
+ * Calculate a checksum for each fixed-size piece of a file,
+ * reading the file once, and hashing the pieces in parallel,
+ * across threads and, when the machine supports it, lanes
+ * 
+ * @param   fd          The file descriptor of the file
+ * @param   algorithm   The hashing algorithm
+ * @param   piece_size  The size of each piece, in bytes, the last
+ *                      piece is shorter unless the file's size
+ *                      is a multiple of `piece_size`
+ * @param   hashsums    Output buffer for the hashes of the pieces,
+ *                      one after another
+ * @param   npieces     The number of hashes `hashsums` has room for;
+ *                      output parameter for the number of pieces
+ * @param   hashsum     Output buffer for the hash of the whole file,
+ *                      calculated in the same pass; or `NULL`
+ * @param   threads     The number of threads, 0 for one per processor
+ * @param   flags       Bitwise OR of `LIBSHA2_MAP`, `LIBSHA2_MAP_POPULATE`,
+ *                      and `LIBSHA2_MAP_HUGEPAGE`, or 0
+ * @return              Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(4, 5)))
+#endif
+int libsha2_sum_fd_pieces(int, enum libsha2_algorithm, size_t, void *, size_t *, void *, size_t, int);
 
 /**
- * Initialise a state
+ * Calculate the checksums for multiple files in parallel,
+ * using a pool of threads; small files are hashed in
+ * batches, in parallel when the machine supports it;
+ * the content of the files is assumed non-sensitive
  * 
- * @param   state      The state that should be initialised
+ * Each file is hashed from its file offset to its end
+ * 
+ * @param   fds        The file descriptors of the files
+ * @param   n          The number of files
  * @param   algorithm  The hashing algorithm
- * @return             Zero on success, -1 on error
+ * @param   hashsums   Output buffer for the hashes, one after another
+ *                     in the same order as the files
+ * @param   errors     Output buffer for the error of each file, 0 for
+ *                     files that were hashed; or `NULL`
+ * @param   threads    The number of threads, 0 for one per processor
+ * @return             Zero on success, -1 on error, in which case
+ *                     `errno` is set to the error for the first
+ *                     file that could not be hashed
  */
 #if defined(__GNUC__)
-__attribute__((__leaf__, __nothrow__, __nonnull__))
+__attribute__((__nonnull__(4)))
 #endif
-int libsha2_init(struct libsha2_state *restrict, enum libsha2_algorithm);
+int libsha2_sum_fds(const int *, size_t, enum libsha2_algorithm, void *, int *, size_t);
 
 /**
- * Get the output size of an algorithm
+ * Calculate the checksums for multiple files in parallel,
+ * using a pool of threads; small files are hashed in
+ * batches, in parallel when the machine supports it;
+ * the content of the files is assumed non-sensitive
  * 
+ * @param   paths      The paths of the files
+ * @param   n          The number of files
  * @param   algorithm  The hashing algorithm
- * @return             The number of bytes in the output, zero on error
+ * @param   hashsums   Output buffer for the hashes, one after another
+ *                     in the same order as the files
+ * @param   errors     Output buffer for the error of each file, 0 for
+ *                     files that were hashed; or `NULL`
+ * @param   threads    The number of threads, 0 for one per processor
+ * @return             Zero on success, -1 on error, in which case
+ *                     `errno` is set to the error for the first
+ *                     file that could not be hashed
  */
 #if defined(__GNUC__)
-__attribute__((__warn_unused_result__, __nothrow__))
+__attribute__((__nonnull__(4)))
 #endif
-inline size_t
-libsha2_algorithm_output_size(enum libsha2_algorithm algorithm__)
-{
-	switch (algorithm__) {
-	case LIBSHA2_224:     return 28;
-	case LIBSHA2_256:     return 32;
-	case LIBSHA2_384:     return 48;
-	case LIBSHA2_512:     return 64;
-	case LIBSHA2_512_224: return 28;
-	case LIBSHA2_512_256: return 32;
-	default:
-		errno = EINVAL;
-		return 0;
-	}
-}
+int libsha2_sum_paths(const char *const *, size_t, enum libsha2_algorithm, void *, int *, size_t);
 
 /**
- * Get the output size of the algorithm specified for a state
+ * Calculate one checksum for a directory tree, covering
+ * the names, types, and permission bits of all entries,
+ * the targets of symbolic links, and the content of
+ * regular files, which are hashed in parallel; the
+ * content of the files is assumed non-sensitive
  * 
- * @param   state  The state
- * @return         The number of bytes in the output, zero on error
+ * The result does not depend on the order the directories
+ * are listed in or the order the files are hashed in
+ * 
+ * @param   path       The path of the root of the tree
+ * @param   algorithm  The hashing algorithm
+ * @param   hashsum    Output buffer for the hash
+ * @param   threads    The number of threads, 0 for one per processor
+ * @return             Zero on success, -1 on error
  */
 #if defined(__GNUC__)
-__attribute__((__warn_unused_result__, __nothrow__, __nonnull__))
+__attribute__((__nonnull__))
 #endif
-inline size_t
-libsha2_state_output_size(const struct libsha2_state *restrict state__)
-{
-	return libsha2_algorithm_output_size(state__->algorithm);
-}
+int libsha2_sum_tree(const char *, enum libsha2_algorithm, void *, size_t);
 
 /**
- * Absorb more of the message
+ * Open a digest cache, creating the cache file if it
+ * does not exist
  * 
- * @param  state    The hashing state
- * @param  message  The message, in bits, must be equivalent to 0 modulus 8
- * @param  msglen   The length of the message
+ * The cache file may be shared by several processes
+ * 
+ * @param   cache  Output parameter for the digest cache
+ * @param   path   The path of the cache file
+ * @return         Zero on success, -1 on error
  */
 #if defined(__GNUC__)
-__attribute__((__nonnull__, __nothrow__))
+__attribute__((__nonnull__))
 #endif
-void libsha2_update(struct libsha2_state *restrict, const void *restrict, size_t);
+int libsha2_cache_open(struct libsha2_cache *restrict, const char *);
 
 /**
- * Absorb the last part of the message and output a hash
+ * Close a digest cache
  * 
- * @param  state    The hashing state
- * @param  message  The message, in bits
- * @param  msglen   The length of the message, zero if there is nothing more to absorb
- * @param  output   The output buffer for the hash
+ * @param  cache  The digest cache
  */
 #if defined(__GNUC__)
-__attribute__((__nonnull__(1, 4), __nothrow__))
+__attribute__((__nonnull__))
 #endif
-void libsha2_digest(struct libsha2_state *restrict, const void *, size_t, void *);
+void libsha2_cache_close(struct libsha2_cache *restrict);
 
 /**
- * Calculate the checksum for a file,
- * the content of the file is assumed non-sensitive
+ * Calculate the checksum of a file, or get it from a
+ * digest cache if the file has not been modified since
+ * it was stored; the hash is stored in the cache unless
+ * the file was modified too recently to rule out a
+ * modification that does not change its timestamps
+ * 
+ * Unlike `libsha2_sum_fd`, the whole of a regular file
+ * is hashed, regardless of the file offset
  * 
+ * Failure to read or update the cache does not cause
+ * the function to fail, the file is simply hashed
+ * 
+ * @param   cache      The digest cache
  * @param   fd         The file descriptor of the file
  * @param   algorithm  The hashing algorithm
  * @param   hashsum    Output buffer for the hash
  * @return             Zero on success, -1 on error
  */
 #if defined(__GNUC__)
-__attribute__((__nonnull__, __leaf__))
+__attribute__((__nonnull__))
 #endif
-int libsha2_sum_fd(int, enum libsha2_algorithm, void *restrict);
+int libsha2_cache_sum_fd(struct libsha2_cache *restrict, int, enum libsha2_algorithm, void *restrict);
+
+/**
+ * Rewrite a digest cache file, leaving out outdated
+ * and damaged records
+ * 
+ * Processes that have the cache open may continue to
+ * use it, and switch to the new file when they see it
+ * 
+ * @param   path  The path of the cache file
+ * @return        Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__))
+#endif
+int libsha2_cache_compact(const char *);
 
 /**
  * Convert a binary hashsum to lower case hexadecimal representation
@@ -351,6 +1295,35 @@ __attribute__((__leaf__, __nonnull__, __nothrow__))
 #endif
 int libsha2_hmac_init(struct libsha2_hmac_state *restrict, enum libsha2_algorithm, const void *restrict, size_t);
 
+/**
+ * Prepare a key for HMAC hashing
+ * 
+ * @param   key          Output parameter for the prepared key
+ * @param   algorithm    The hashing algorithm
+ * @param   key_data     The key
+ * @param   key_length   The length of key, in bits
+ * @return               Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+int libsha2_hmac_key_init(struct libsha2_hmac_key *restrict, enum libsha2_algorithm, const void *restrict, size_t);
+
+/**
+ * Initialise an HMAC state from a prepared key
+ * 
+ * This is equivalent to `libsha2_hmac_init`, with the
+ * same key, but the key need not be processed again
+ * 
+ * @param  state  The state that should be initialised
+ * @param  key    The prepared key, it will not be modified,
+ *                and the state does not refer to it
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+void libsha2_hmac_init_from_key(struct libsha2_hmac_state *restrict, const struct libsha2_hmac_key *restrict);
+
 /**
  * Get the output size of the algorithm specified for an HMAC state
  * 
@@ -384,8 +1357,8 @@ void libsha2_hmac_update(struct libsha2_hmac_state *restrict, const void *restri
  * get the result
  * 
  * The state of the algorithm will be reset and
- * `libsha2_hmac_update` and `libsha2_hmac_update`
- * can be called again
+ * `libsha2_hmac_update` and `libsha2_hmac_digest`
+ * can be called again with the same key
  * 
  * @param  state   The state of the algorithm
  * @param  data    Data to feed into the algorithm
@@ -398,6 +1371,213 @@ __attribute__((__leaf__, __nonnull__, __nothrow__))
 #endif
 void libsha2_hmac_digest(struct libsha2_hmac_state *restrict, const void *, size_t, void *);
 
+/**
+ * Calculate the HMAC of a message with a prepared key
+ * 
+ * The key is not modified, so the function can be
+ * called from multiple threads with the same key
+ * 
+ * @param  key     The prepared key
+ * @param  data    The message
+ * @param  n       The length of the message, in bits
+ * @param  output  The output buffer for the hash, it will be as
+ *                 large as for the underlaying hash algorithm
+ */
+#if defined(__GNUC__)
+__attribute__((__leaf__, __nonnull__, __nothrow__))
+#endif
+void libsha2_hmac_key_digest(const struct libsha2_hmac_key *restrict, const void *, size_t, void *);
+
+/**
+ * Calculate the HMAC of multiple messages, processing
+ * them in parallel when the machine supports it
+ * 
+ * @param   keys      The prepared key for each message, all for the same
+ *                    algorithm; the same key may be used multiple times
+ * @param   messages  The messages
+ * @param   msglens   The length of each message, in bits
+ * @param   n         The number of messages
+ * @param   outputs   Output buffer for the hashes, the hash of the `i`:th
+ *                    message is stored at the offset `i` times the hash size
+ * @return            Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+int libsha2_hmac_digest_many(const struct libsha2_hmac_key *const *, const void *const *, const size_t *, size_t, void *);
+
+/**
+ * Verify the HMAC of multiple messages, processing
+ * them in parallel when the machine supports it
+ * 
+ * The calculated hashes are compared to the expected
+ * hashes in a time that does not depend on their content
+ * 
+ * @param   keys      The prepared key for each message, all for the same
+ *                    algorithm; the same key may be used multiple times
+ * @param   messages  The messages
+ * @param   msglens   The length of each message, in bits
+ * @param   n         The number of messages
+ * @param   macs      The expected hashes, the hash of the `i`:th message
+ *                    is stored at the offset `i` times the hash size
+ * @param   valid     Output parameter for whether each message's hash
+ *                    matched: `valid[i]` is set to 1 if it did, 0 otherwise
+ * @return            Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+int libsha2_hmac_verify_many(const struct libsha2_hmac_key *const *, const void *const *, const size_t *,
+                             size_t, const void *, unsigned char *);
+
+/**
+ * Derive a key from a password with PBKDF2,
+ * using HMAC with a SHA-2 algorithm
+ * 
+ * @param   algorithm   The hashing algorithm
+ * @param   password    The password
+ * @param   passlen     The length of the password, in bytes
+ * @param   salt        The salt
+ * @param   saltlen     The length of the salt, in bytes
+ * @param   iterations  The iteration count, must be positive
+ * @param   output      Output buffer for the derived key
+ * @param   outlen      The length of the derived key, in bytes
+ * @return              Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(7), __nothrow__))
+#endif
+int libsha2_pbkdf2(enum libsha2_algorithm, const void *, size_t, const void *, size_t, size_t, void *, size_t);
+
+/**
+ * Derive keys from multiple passwords with PBKDF2,
+ * using HMAC with a SHA-2 algorithm, processing
+ * them in parallel when the machine supports it
+ * 
+ * @param   algorithm   The hashing algorithm
+ * @param   passwords   The passwords
+ * @param   passlens    The length of each password, in bytes
+ * @param   salts       The salt for each password
+ * @param   saltlens    The length of each salt, in bytes
+ * @param   iterations  The iteration count, must be positive
+ * @param   outputs     Output buffer for the derived keys, the key derived
+ *                      from the `i`:th password is stored at the offset
+ *                      `i * outlen`
+ * @param   outlen      The length of each derived key, in bytes
+ * @param   n           The number of passwords
+ * @return              Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+int libsha2_pbkdf2_many(enum libsha2_algorithm, const void *const *, const size_t *, const void *const *,
+                        const size_t *, size_t, void *, size_t, size_t);
+
+/**
+ * Extract a pseudorandom key from input keying material
+ * with HKDF, using HMAC with a SHA-2 algorithm
+ * 
+ * @param   key        Output parameter for the pseudorandom key,
+ *                     prepared as an HMAC key for `libsha2_hkdf_expand`
+ * @param   algorithm  The hashing algorithm
+ * @param   salt       The salt, may be `NULL` if `saltlen` is 0
+ * @param   saltlen    The length of the salt, in bytes; if 0,
+ *                     a string of zeroes is used as the salt
+ * @param   ikm        The input keying material, may be `NULL` if `ikmlen` is 0
+ * @param   ikmlen     The length of the input keying material, in bytes
+ * @param   prk        Output buffer for the pseudorandom key itself, it
+ *                     will be as large as for the hash algorithm; or `NULL`
+ * @return             Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1), __nothrow__))
+#endif
+int libsha2_hkdf_extract(struct libsha2_hmac_key *restrict, enum libsha2_algorithm,
+                         const void *, size_t, const void *, size_t, void *);
+
+/**
+ * Expand a pseudorandom key into output keying material
+ * with HKDF, using HMAC with a SHA-2 algorithm
+ * 
+ * @param   prk      The pseudorandom key, prepared as an HMAC key,
+ *                   for example by `libsha2_hkdf_extract`
+ * @param   info     The context and application specific information,
+ *                   may be `NULL` if `infolen` is 0
+ * @param   infolen  The length of `info`, in bytes
+ * @param   output   Output buffer for the output keying material
+ * @param   outlen   The length of the output keying material, in bytes,
+ *                   at most 255 times the hash size
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1), __nothrow__))
+#endif
+int libsha2_hkdf_expand(const struct libsha2_hmac_key *restrict, const void *, size_t, void *, size_t);
+
+/**
+ * Expand a pseudorandom key into output keying material for
+ * multiple labels with HKDF, using HMAC with a SHA-2 algorithm,
+ * processing the labels in parallel when the machine supports it
+ * 
+ * @param   prk       The pseudorandom key, prepared as an HMAC key,
+ *                    for example by `libsha2_hkdf_extract`
+ * @param   infos     The context and application specific
+ *                    information for each label
+ * @param   infolens  The length of each element in `infos`, in bytes
+ * @param   outputs   Output buffer for the output keying material
+ *                    for each label
+ * @param   outlens   The length of the output keying material for each
+ *                    label, in bytes, at most 255 times the hash size
+ * @param   n         The number of labels
+ * @return            Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__(1), __nothrow__))
+#endif
+int libsha2_hkdf_expand_many(const struct libsha2_hmac_key *restrict, const void *const *, const size_t *,
+                             void *const *, const size_t *, size_t);
+
+/**
+ * Hash a password with sha256crypt or sha512crypt,
+ * the "$5$" and "$6$" formats of crypt(3)
+ * 
+ * @param   phrase   The password, at most 256 bytes long
+ * @param   setting  The setting, "$5$" for sha256crypt or "$6$"
+ *                   for sha512crypt, optionally followed by
+ *                   "rounds=<number>$", followed by the salt,
+ *                   of which at most 16 characters are used;
+ *                   anything after the salt's terminating '$'
+ *                   is ignored, so a previous output can be
+ *                   used as the setting
+ * @param   output   Output buffer for the NUL-terminated hash
+ *                   string, must have room for `LIBSHA2_CRYPT_SIZE`
+ *                   bytes
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_crypt(const char *, const char *, char *);
+
+/**
+ * Hash multiple passwords with sha256crypt or sha512crypt,
+ * running the rounds for the passwords in parallel when
+ * the machine supports it
+ * 
+ * @param   phrases   The passwords
+ * @param   settings  The setting for each password, see `libsha2_crypt`
+ * @param   outputs   Output buffer for the NUL-terminated hash strings,
+ *                    `LIBSHA2_CRYPT_SIZE` bytes per password; if a
+ *                    password cannot be hashed, its output will be
+ *                    "*0", or "*1" if its setting starts with "*0"
+ * @param   n         The number of passwords
+ * @return            Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nonnull__, __nothrow__))
+#endif
+int libsha2_crypt_many(const char *const *, const char *const *, char *, size_t);
+
 /**
  * Marshal an HMAC state into a buffer
  * 
@@ -424,4 +1604,38 @@ __attribute__((__leaf__, __nonnull__, __nothrow__))
 size_t libsha2_hmac_unmarshal(struct libsha2_hmac_state *restrict, const void *restrict, size_t);
 
 
+/**
+ * Select which instruction set extensions the library
+ * may use, primarily for benchmarking and debugging
+ * 
+ * The selection is global and shall not be changed while
+ * another thread is using the library
+ * 
+ * @param   backend  Comma-separated list of back ends to allow:
+ *                   "portable", "sha-ni", "avx2", and "avx512";
+ *                   or "auto" or `NULL` for all supported back ends
+ * @return           Zero on success, -1 on error
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+int libsha2_set_backend(const char *);
+
+/**
+ * Get the name of the back end used for an algorithm
+ * 
+ * @param   algorithm    The hashing algorithm
+ * @param   multibuffer  Zero to get the back end used for hashing one
+ *                       message, non-zero to get the back end used
+ *                       when hashing multiple messages in parallel
+ * @return               The name of the back end, `NULL` if `multibuffer`
+ *                       is non-zero and multi-buffer processing is not
+ *                       supported for the algorithm
+ */
+#if defined(__GNUC__)
+__attribute__((__nothrow__))
+#endif
+const char *libsha2_get_backend(enum libsha2_algorithm, int);
+
+
 #endif
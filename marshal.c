@@ -9,7 +9,7 @@ libsha2_marshal(const struct libsha2_state *restrict state, void *restrict buf_)
 	size_t off = 0;
 
 	if (buf)
-		*(int *)buf = 1; /* version */
+		*(int *)buf = 2; /* version */
 	off += sizeof(int);
 	if (buf)
 		*(enum libsha2_algorithm *)&buf[off] = state->algorithm;
@@ -19,16 +19,10 @@ libsha2_marshal(const struct libsha2_state *restrict state, void *restrict buf_)
 	off += sizeof(size_t);
 
 	if (state->algorithm <= LIBSHA2_256) {
-		if (buf)
-			memcpy(&buf[off], state->k.b32, sizeof(state->k.b32));
-		off += sizeof(state->k.b32);
 		if (buf)
 			memcpy(&buf[off], state->h.b32, sizeof(state->h.b32));
 		off += sizeof(state->h.b32);
 	} else {
-		if (buf)
-			memcpy(&buf[off], state->k.b64, sizeof(state->k.b64));
-		off += sizeof(state->k.b64);
 		if (buf)
 			memcpy(&buf[off], state->h.b64, sizeof(state->h.b64));
 		off += sizeof(state->h.b64);
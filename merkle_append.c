@@ -0,0 +1,52 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_merkle_append(struct libsha2_merkle *restrict merkle, const void *const *entries, const size_t *lens, size_t n)
+{
+	size_t level, need, capacity, old, new, size, hash_size = merkle->hash_size;
+	unsigned char *p;
+
+	if (n > SIZE_MAX - merkle->size) {
+		errno = EFBIG;
+		return -1;
+	}
+	if (!n)
+		return 0;
+	size = merkle->size + n;
+
+	/* Everything is allocated before anything is
+	 * stored, so that the log is unchanged on failure */
+	for (level = 0; level < LIBSHA2_MERKLE_MAX_LEVELS && size >> level; level++) {
+		need = size >> level;
+		if (merkle->capacity[level] >= need)
+			continue;
+		capacity = merkle->capacity[level] * 2 > need ? merkle->capacity[level] * 2 : need;
+		if (capacity > SIZE_MAX / hash_size) {
+			errno = ENOMEM;
+			return -1;
+		}
+		p = realloc(merkle->levels[level], capacity * hash_size);
+		if (!p)
+			return -1;
+		merkle->levels[level] = p;
+		merkle->capacity[level] = capacity;
+	}
+
+	/* Only the nodes whose subtrees the new leaves complete
+	 * have to be hashed, and if a level gets no new nodes,
+	 * neither does any level above it */
+	libsha2_merkle_leaves(merkle->algorithm, entries, lens, n, &merkle->levels[0][merkle->size * hash_size]);
+	for (level = 0; level + 1 < LIBSHA2_MERKLE_MAX_LEVELS; level++) {
+		old = merkle->size >> (level + 1);
+		new = size >> (level + 1);
+		if (new == old)
+			break;
+		libsha2_merkle_nodes(merkle->algorithm, &merkle->levels[level][2 * old * hash_size], new - old,
+		                     &merkle->levels[level + 1][old * hash_size]);
+	}
+
+	merkle->size = size;
+	return 0;
+}
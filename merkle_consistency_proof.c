@@ -0,0 +1,44 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_merkle_consistency_proof(const struct libsha2_merkle *restrict merkle, size_t old_size, size_t new_size,
+                                 void *proof_, size_t *nhashes)
+{
+	unsigned char *proof = proof_;
+	size_t begins[LIBSHA2_MERKLE_MAX_PROOF], ends[LIBSHA2_MERKLE_MAX_PROOF];
+	size_t i, n = 0, begin = 0, end = new_size, half;
+	int known = 1;
+
+	if (!old_size || old_size > new_size || new_size > merkle->size) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Going from the root, until the subtree that ends where
+	 * the old tree ends is found, the subtrees that are left
+	 * out are part of the proof; the subtree that is found is
+	 * too, unless it is the whole old tree, whose tree hash
+	 * the verifier already has */
+	while (end != old_size) {
+		for (half = 1; half < end - begin - half; half <<= 1);
+		if (old_size <= begin + half) {
+			begins[n] = begin + half;
+			ends[n++] = end;
+			end = begin + half;
+		} else {
+			begins[n] = begin;
+			ends[n++] = begin + half;
+			begin += half;
+			known = 0;
+		}
+	}
+
+	*nhashes = 0;
+	if (!known)
+		libsha2_merkle_subtree(merkle, begin, end, &proof[(*nhashes)++ * merkle->hash_size]);
+	for (i = 0; i < n; i++)
+		libsha2_merkle_subtree(merkle, begins[n - 1 - i], ends[n - 1 - i], &proof[(*nhashes)++ * merkle->hash_size]);
+	return 0;
+}
@@ -0,0 +1,16 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_merkle_destroy(struct libsha2_merkle *restrict merkle)
+{
+	size_t i;
+
+	for (i = 0; i < LIBSHA2_MERKLE_MAX_LEVELS; i++) {
+		free(merkle->levels[i]);
+		merkle->levels[i] = NULL;
+		merkle->capacity[i] = 0;
+	}
+	merkle->size = 0;
+}
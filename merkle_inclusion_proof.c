@@ -0,0 +1,38 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_merkle_inclusion_proof(const struct libsha2_merkle *restrict merkle, size_t index, size_t size,
+                               void *proof_, size_t *nhashes)
+{
+	unsigned char *proof = proof_;
+	size_t begins[LIBSHA2_MERKLE_MAX_PROOF], ends[LIBSHA2_MERKLE_MAX_PROOF];
+	size_t i, n = 0, begin = 0, end = size, half;
+
+	if (index >= size || size > merkle->size) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Going from the root towards the leaf, the subtree
+	 * that does not contain the leaf is part of the proof,
+	 * but the proof lists them from the leaf */
+	while (end - begin > 1) {
+		for (half = 1; half < end - begin - half; half <<= 1);
+		if (index < begin + half) {
+			begins[n] = begin + half;
+			ends[n++] = end;
+			end = begin + half;
+		} else {
+			begins[n] = begin;
+			ends[n++] = begin + half;
+			begin += half;
+		}
+	}
+
+	*nhashes = n;
+	for (i = 0; i < n; i++)
+		libsha2_merkle_subtree(merkle, begins[n - 1 - i], ends[n - 1 - i], &proof[i * merkle->hash_size]);
+	return 0;
+}
@@ -0,0 +1,21 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_merkle_init(struct libsha2_merkle *restrict merkle, enum libsha2_algorithm algorithm)
+{
+	size_t i;
+
+	merkle->hash_size = libsha2_algorithm_output_size(algorithm);
+	if (!merkle->hash_size)
+		return -1;
+
+	for (i = 0; i < LIBSHA2_MERKLE_MAX_LEVELS; i++) {
+		merkle->levels[i] = NULL;
+		merkle->capacity[i] = 0;
+	}
+	merkle->size = 0;
+	merkle->algorithm = algorithm;
+	return 0;
+}
@@ -0,0 +1,66 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_merkle_leaves(enum libsha2_algorithm algorithm, const void *const *entries, const size_t *lens,
+                      size_t n, unsigned char *out)
+{
+	struct libsha2_state state, leaf;
+	struct libsha2_job jobs[LIBSHA2_BATCH_SIZE];
+	union libsha2_hash_values hs[LIBSHA2_BATCH_SIZE];
+	unsigned char heads[LIBSHA2_BATCH_SIZE][128];
+	unsigned char tails[LIBSHA2_BATCH_SIZE][256];
+	const unsigned char *entry;
+	size_t i, j, batch, outsize, chunk_size, len, body, rest, lanes;
+
+	libsha2_init(&state, algorithm);
+	outsize = libsha2_algorithm_output_size(algorithm);
+	chunk_size = state.chunk_size;
+
+	/* Lanes that are left idle still cost as much as busy ones */
+	lanes = libsha2_multi_lanes(algorithm);
+	if (lanes <= 2 || n * 2 < lanes) {
+		for (i = 0; i < n; i++) {
+			leaf = state;
+			libsha2_update(&leaf, "", 8);
+			libsha2_digest(&leaf, entries[i], lens[i] * 8, &out[i * outsize]);
+		}
+		return;
+	}
+
+	/* Only the first chunk, which holds the prepended byte,
+	 * and the last, padded, chunks are copied; the rest of
+	 * each entry is processed where it is */
+	for (i = 0; i < n; i += batch) {
+		batch = n - i < LIBSHA2_BATCH_SIZE ? n - i : LIBSHA2_BATCH_SIZE;
+		for (j = 0; j < batch; j++) {
+			entry = entries[i + j];
+			len = lens[i + j];
+			hs[j] = state.h;
+			jobs[j].h = &hs[j];
+			if (len + 1 < chunk_size) {
+				tails[j][0] = 0;
+				if (len)
+					memcpy(&tails[j][1], entry, len);
+				jobs[j].chunks[0] = 0;
+				jobs[j].chunks[1] = 0;
+			} else {
+				heads[j][0] = 0;
+				memcpy(&heads[j][1], entry, chunk_size - 1);
+				rest = len - (chunk_size - 1);
+				body = rest / chunk_size * chunk_size;
+				jobs[j].data[0] = heads[j];
+				jobs[j].chunks[0] = 1;
+				jobs[j].data[1] = &entry[chunk_size - 1];
+				jobs[j].chunks[1] = body / chunk_size;
+				memcpy(tails[j], &entry[chunk_size - 1 + body], rest - body);
+			}
+			jobs[j].data[2] = tails[j];
+			jobs[j].chunks[2] = libsha2_pad(tails[j], (len + 1) * 8, chunk_size) / chunk_size;
+		}
+		libsha2_process_multi(jobs, batch, algorithm);
+		for (j = 0; j < batch; j++)
+			libsha2_store_hash(&out[(i + j) * outsize], &hs[j], algorithm);
+	}
+}
@@ -0,0 +1,59 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_merkle_nodes(enum libsha2_algorithm algorithm, const unsigned char *children, size_t n, unsigned char *out)
+{
+	struct libsha2_state state;
+	struct libsha2_job jobs[LIBSHA2_BATCH_SIZE];
+	union libsha2_hash_values hs[LIBSHA2_BATCH_SIZE], h;
+	unsigned char blocks[LIBSHA2_BATCH_SIZE][256];
+	size_t i, j, batch, outsize, len, size, chunks, lanes;
+
+	libsha2_init(&state, algorithm);
+	outsize = libsha2_algorithm_output_size(algorithm);
+
+	/* The input is always the byte 1 followed by two hashes,
+	 * so the padding is prepared once and the chunks are
+	 * given directly to the compression function */
+	len = 1 + 2 * outsize;
+	size = len / state.chunk_size * state.chunk_size;
+	size += libsha2_pad(&blocks[0][size], len * 8, state.chunk_size);
+	blocks[0][0] = 1;
+	chunks = size / state.chunk_size;
+
+	lanes = libsha2_multi_lanes(algorithm);
+	if (n < 2 || lanes < 2 || n * 2 < lanes) {
+		for (i = 0; i < n; i++) {
+			memcpy(&blocks[0][1], &children[2 * i * outsize], 2 * outsize);
+			h = state.h;
+			if (algorithm <= LIBSHA2_256)
+				libsha2_dispatch.process32(h.b32, blocks[0], chunks);
+			else
+				libsha2_dispatch.process64(h.b64, blocks[0], chunks);
+			libsha2_store_hash(&out[i * outsize], &h, algorithm);
+		}
+		return;
+	}
+
+	for (j = 1; j < LIBSHA2_BATCH_SIZE && j < n; j++) {
+		blocks[j][0] = 1;
+		memcpy(&blocks[j][len], &blocks[0][len], size - len);
+	}
+	for (i = 0; i < n; i += batch) {
+		batch = n - i < LIBSHA2_BATCH_SIZE ? n - i : LIBSHA2_BATCH_SIZE;
+		for (j = 0; j < batch; j++) {
+			memcpy(&blocks[j][1], &children[2 * (i + j) * outsize], 2 * outsize);
+			hs[j] = state.h;
+			jobs[j].h = &hs[j];
+			jobs[j].data[0] = blocks[j];
+			jobs[j].chunks[0] = chunks;
+			jobs[j].chunks[1] = 0;
+			jobs[j].chunks[2] = 0;
+		}
+		libsha2_process_multi(jobs, batch, algorithm);
+		for (j = 0; j < batch; j++)
+			libsha2_store_hash(&out[(i + j) * outsize], &hs[j], algorithm);
+	}
+}
@@ -0,0 +1,16 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_merkle_root(const struct libsha2_merkle *restrict merkle, size_t size, void *root)
+{
+	if (size > merkle->size) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (!size)
+		return libsha2_hash(merkle->algorithm, "", 0, root);
+	libsha2_merkle_subtree(merkle, 0, size, root);
+	return 0;
+}
@@ -0,0 +1,27 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_merkle_subtree(const struct libsha2_merkle *restrict merkle, size_t begin, size_t end, unsigned char *out)
+{
+	unsigned char pair[2 * 64];
+	size_t level, hash_size = merkle->hash_size;
+	int have = 0;
+
+	/* The range is made up of one perfect subtree for each bit
+	 * set in its length, the largest to the left, and they are
+	 * combined from the right, as the rightmost is the deepest */
+	while (end > begin) {
+		for (level = 0; !(((end - begin) >> level) & 1); level++);
+		end -= (size_t)1 << level;
+		if (!have) {
+			memcpy(out, &merkle->levels[level][(end >> level) * hash_size], hash_size);
+			have = 1;
+		} else {
+			memcpy(pair, &merkle->levels[level][(end >> level) * hash_size], hash_size);
+			memcpy(&pair[hash_size], out, hash_size);
+			libsha2_merkle_nodes(merkle->algorithm, pair, 1, out);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * The number of leaves hashed at a time, a power of 2
+ */
+#define GROUP ((size_t)4096)
+
+
+int
+libsha2_merkle_tree_hash(enum libsha2_algorithm algorithm, const void *const *entries, const size_t *lens,
+                         size_t n, void *root)
+{
+	struct libsha2_state state;
+	unsigned char *hashes, pair[2 * 64];
+	unsigned char frontier[LIBSHA2_MERKLE_MAX_LEVELS][64];
+	size_t i, k, m, level, groups, outsize;
+	int have = 0;
+
+	if (libsha2_init(&state, algorithm))
+		return -1;
+	if (!n)
+		return libsha2_hash(algorithm, "", 0, root);
+	outsize = libsha2_algorithm_output_size(algorithm);
+
+	hashes = malloc((n < GROUP ? n : GROUP) * outsize);
+	if (!hashes)
+		return -1;
+
+	/* Each group is reduced to its tree hash, level by level,
+	 * a node without a sibling being moved up unchanged; the
+	 * hashes of whole groups are combined like the digits of a
+	 * binary counter, so only one hash per level is kept */
+	for (i = 0; i < n; i += m) {
+		m = n - i < GROUP ? n - i : GROUP;
+		libsha2_merkle_leaves(algorithm, &entries[i], &lens[i], m, hashes);
+		for (k = m; k > 1; k = (k + 1) / 2) {
+			libsha2_merkle_nodes(algorithm, hashes, k / 2, hashes);
+			if (k & 1)
+				memcpy(&hashes[k / 2 * outsize], &hashes[(k - 1) * outsize], outsize);
+		}
+		if (m < GROUP)
+			break;
+		for (level = 0; ((i / GROUP) >> level) & 1; level++) {
+			memcpy(pair, frontier[level], outsize);
+			memcpy(&pair[outsize], hashes, outsize);
+			libsha2_merkle_nodes(algorithm, pair, 1, hashes);
+		}
+		memcpy(frontier[level], hashes, outsize);
+	}
+
+	/* The tree hash combines the hash of the last, partial,
+	 * group with the hashes of the whole groups, from the right */
+	groups = n / GROUP;
+	if (n % GROUP) {
+		memcpy(root, hashes, outsize);
+		have = 1;
+	}
+	for (level = 0; groups >> level; level++) {
+		if (!((groups >> level) & 1))
+			continue;
+		if (!have) {
+			memcpy(root, frontier[level], outsize);
+			have = 1;
+		} else {
+			memcpy(pair, frontier[level], outsize);
+			memcpy(&pair[outsize], root, outsize);
+			libsha2_merkle_nodes(algorithm, pair, 1, root);
+		}
+	}
+
+	free(hashes);
+	return 0;
+}
@@ -0,0 +1,33 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+size_t
+libsha2_pad(unsigned char *restrict buf, size_t message_size, size_t chunk_size)
+{
+	size_t off = (message_size / 8) % chunk_size;
+	size_t bits = message_size % 8;
+	size_t end;
+
+	if (bits) {
+		buf[off] &= (unsigned char)~(0xFF >> bits);
+		buf[off] |= (unsigned char)(0x80 >> bits);
+	} else {
+		buf[off] = 0x80;
+	}
+	off += 1;
+
+	end = off > chunk_size - chunk_size / 8 ? 2 * chunk_size : chunk_size;
+
+	memset(&buf[off], 0, end - 8 - off);
+	buf[end - 8] = (unsigned char)((uint_least64_t)message_size >> 56);
+	buf[end - 7] = (unsigned char)((uint_least64_t)message_size >> 48);
+	buf[end - 6] = (unsigned char)((uint_least64_t)message_size >> 40);
+	buf[end - 5] = (unsigned char)((uint_least64_t)message_size >> 32);
+	buf[end - 4] = (unsigned char)((uint_least64_t)message_size >> 24);
+	buf[end - 3] = (unsigned char)((uint_least64_t)message_size >> 16);
+	buf[end - 2] = (unsigned char)((uint_least64_t)message_size >>  8);
+	buf[end - 1] = (unsigned char)((uint_least64_t)message_size >>  0);
+
+	return end;
+}
@@ -0,0 +1,38 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_pbkdf2(enum libsha2_algorithm algorithm, const void *password, size_t passlen,
+               const void *salt, size_t saltlen, size_t iterations, void *output_, size_t outlen)
+{
+	unsigned char *output = output_;
+	struct libsha2_hmac_key key;
+	struct libsha2_pbkdf2_chain chains[16]; /* a multiple of every lane count */
+	size_t outsize, blocks, block, i, n;
+
+	if (libsha2_hmac_key_init(&key, algorithm, password, passlen * 8))
+		return -1;
+	outsize = libsha2_algorithm_output_size(algorithm);
+	blocks = outlen / outsize + (outlen % outsize ? 1 : 0);
+	if (!iterations || blocks > (size_t)0xFFFFFFFFUL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* The blocks are independent, so they are calculated in parallel */
+	for (block = 0; block < blocks; block += n) {
+		n = blocks - block < 16 ? blocks - block : 16;
+		for (i = 0; i < n; i++)
+			libsha2_pbkdf2_start(&chains[i], &key, salt, saltlen, (uint_least32_t)(block + i + 1));
+		libsha2_pbkdf2_chains(chains, n, iterations);
+		for (i = 0; i < n; i++) {
+			if (i + 1 == n && block + n == blocks && outlen % outsize)
+				memcpy(&output[(block + i) * outsize], chains[i].t, outlen % outsize);
+			else
+				memcpy(&output[(block + i) * outsize], chains[i].t, outsize);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Exclusive-or a hash into the accumulated result of a chain
+ * 
+ * @param  t        The accumulated result
+ * @param  u        The hash
+ * @param  outsize  The size of the hash, in bytes
+ */
+static inline void
+accumulate(unsigned char *restrict t, const unsigned char *restrict u, size_t outsize)
+{
+	size_t i;
+	for (i = 0; i < outsize; i++)
+		t[i] ^= u[i];
+}
+
+
+/**
+ * Run one chain on its own
+ * 
+ * @param  chain       The chain
+ * @param  iterations  The total number of iterations
+ */
+static void
+run_single(struct libsha2_pbkdf2_chain *restrict chain, size_t iterations)
+{
+	enum libsha2_algorithm algorithm = chain->key.algorithm;
+	size_t j, outsize = libsha2_algorithm_output_size(algorithm);
+	union libsha2_hash_values h;
+
+	for (j = 1; j < iterations; j++) {
+		h = chain->key.inner;
+		if (algorithm <= LIBSHA2_256)
+			libsha2_dispatch.process32(h.b32, chain->inner, 1);
+		else
+			libsha2_dispatch.process64(h.b64, chain->inner, 1);
+		libsha2_store_hash(chain->outer, &h, algorithm);
+
+		h = chain->key.outer;
+		if (algorithm <= LIBSHA2_256)
+			libsha2_dispatch.process32(h.b32, chain->outer, 1);
+		else
+			libsha2_dispatch.process64(h.b64, chain->outer, 1);
+		libsha2_store_hash(chain->inner, &h, algorithm);
+
+		accumulate(chain->t, chain->inner, outsize);
+	}
+}
+
+
+/**
+ * Run chains in parallel, one per lane
+ * 
+ * @param  chains      The chains
+ * @param  n           The number of chains, at most `lanes`
+ * @param  iterations  The total number of iterations
+ * @param  kernel      The multi-buffer function
+ * @param  lanes       The number of lanes `kernel` processes
+ */
+static void
+run_lanes(struct libsha2_pbkdf2_chain *restrict chains, size_t n, size_t iterations,
+          void (*kernel)(void *const *, const unsigned char *const *, size_t), size_t lanes)
+{
+	enum libsha2_algorithm algorithm = chains[0].key.algorithm;
+	size_t j, l, outsize = libsha2_algorithm_output_size(algorithm);
+	union libsha2_hash_values hs[16];
+	void *h[16];
+	const unsigned char *inner[16], *outer[16];
+	struct libsha2_pbkdf2_chain *chain[16];
+
+	/* Idle lanes shadow the first chain, discarding the result */
+	for (l = 0; l < lanes; l++) {
+		chain[l] = &chains[l < n ? l : 0];
+		h[l] = &hs[l];
+		inner[l] = chain[l]->inner;
+		outer[l] = chain[l]->outer;
+	}
+
+	for (j = 1; j < iterations; j++) {
+		for (l = 0; l < lanes; l++)
+			hs[l] = chain[l]->key.inner;
+		kernel(h, inner, 1);
+		for (l = 0; l < n; l++)
+			libsha2_store_hash(chains[l].outer, &hs[l], algorithm);
+
+		for (l = 0; l < lanes; l++)
+			hs[l] = chain[l]->key.outer;
+		kernel(h, outer, 1);
+		for (l = 0; l < n; l++) {
+			libsha2_store_hash(chains[l].inner, &hs[l], algorithm);
+			accumulate(chains[l].t, chains[l].inner, outsize);
+		}
+	}
+}
+
+
+void
+libsha2_pbkdf2_chains(struct libsha2_pbkdf2_chain *restrict chains, size_t n, size_t iterations)
+{
+	void (*kernel)(void *const *, const unsigned char *const *, size_t);
+	size_t i = 0, m, lanes;
+
+	if (!n)
+		return;
+
+	lanes = libsha2_multi_lanes(chains[0].key.algorithm);
+	kernel = chains[0].key.algorithm <= LIBSHA2_256 ? libsha2_dispatch.multi32 : libsha2_dispatch.multi64;
+
+	/* A multi-buffer function costs about as much as processing
+	 * a third of its lanes one at a time, so only use it when
+	 * at least that many lanes are in use */
+	while (lanes >= 2 && n - i >= 2) {
+		m = n - i < lanes ? n - i : lanes;
+		if (m * 3 < lanes)
+			break;
+		run_lanes(&chains[i], m, iterations, kernel, lanes);
+		i += m;
+	}
+
+	for (; i < n; i++)
+		run_single(&chains[i], iterations);
+}
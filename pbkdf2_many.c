@@ -0,0 +1,47 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_pbkdf2_many(enum libsha2_algorithm algorithm, const void *const *passwords, const size_t *passlens,
+                    const void *const *salts, const size_t *saltlens, size_t iterations,
+                    void *outputs_, size_t outlen, size_t n)
+{
+	unsigned char *outputs = outputs_;
+	struct libsha2_hmac_key key;
+	struct libsha2_pbkdf2_chain chains[16]; /* a multiple of every lane count */
+	size_t outsize, blocks, total, first, pos, i, m, len;
+
+	outsize = libsha2_algorithm_output_size(algorithm);
+	if (!outsize) {
+		errno = EINVAL;
+		return -1;
+	}
+	blocks = outlen / outsize + (outlen % outsize ? 1 : 0);
+	if (!iterations || blocks > (size_t)0xFFFFFFFFUL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Every block of every password is independent of the
+	 * others, so they are all calculated in parallel */
+	total = n * blocks;
+	for (first = 0; first < total; first += m) {
+		m = total - first < 16 ? total - first : 16;
+		for (i = 0; i < m; i++) {
+			pos = first + i;
+			if (!i || pos % blocks == 0)
+				libsha2_hmac_key_init(&key, algorithm, passwords[pos / blocks], passlens[pos / blocks] * 8);
+			libsha2_pbkdf2_start(&chains[i], &key, salts[pos / blocks], saltlens[pos / blocks],
+			                     (uint_least32_t)(pos % blocks + 1));
+		}
+		libsha2_pbkdf2_chains(chains, m, iterations);
+		for (i = 0; i < m; i++) {
+			pos = first + i;
+			len = pos % blocks + 1 == blocks && outlen % outsize ? outlen % outsize : outsize;
+			memcpy(&outputs[pos / blocks * outlen + pos % blocks * outsize], chains[i].t, len);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_pbkdf2_start(struct libsha2_pbkdf2_chain *restrict chain, const struct libsha2_hmac_key *restrict key,
+                     const void *salt, size_t saltlen, uint_least32_t block)
+{
+	struct libsha2_hmac_state state;
+	unsigned char index[4];
+	size_t chunk_size, outsize;
+
+	chain->key = *key;
+	chunk_size = key->algorithm <= LIBSHA2_256 ? 64 : 128;
+	outsize = libsha2_algorithm_output_size(key->algorithm);
+
+	/* U_1 = HMAC(P, S || INT(i)) */
+	index[0] = (unsigned char)(block >> 24);
+	index[1] = (unsigned char)(block >> 16);
+	index[2] = (unsigned char)(block >>  8);
+	index[3] = (unsigned char)(block >>  0);
+	libsha2_hmac_init_from_key(&state, key);
+	libsha2_hmac_update(&state, salt, saltlen * 8);
+	libsha2_hmac_digest(&state, index, sizeof(index) * 8, chain->inner);
+	memcpy(chain->t, chain->inner, outsize);
+
+	/* Every later message, to both the inner and the outer
+	 * hash, is one hash long and follows the pad block, so
+	 * the padding is the same for every iteration */
+	libsha2_pad(chain->inner, (chunk_size + outsize) * 8, chunk_size);
+	memcpy(chain->outer, chain->inner, chunk_size);
+}
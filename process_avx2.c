@@ -0,0 +1,308 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+#ifdef HAVE_X86_AVX2_INTRINSICS
+# include <immintrin.h>
+
+
+# define TARGET __attribute__((__target__("avx2")))
+
+# define ADD(A, B)    _mm256_add_epi32(A, B)
+# define ROTR(X, N)   _mm256_or_si256(_mm256_srli_epi32(X, N), _mm256_slli_epi32(X, 32 - (N)))
+# define SHR(X, N)    _mm256_srli_epi32(X, N)
+# define XOR3(A, B, C) _mm256_xor_si256(_mm256_xor_si256(A, B), C)
+
+# define CH(E, F, G)  _mm256_xor_si256(G, _mm256_and_si256(E, _mm256_xor_si256(F, G)))
+# define MAJ(A, B, C) _mm256_or_si256(_mm256_and_si256(A, B), _mm256_and_si256(C, _mm256_or_si256(A, B)))
+
+# define BSIG0(X) XOR3(ROTR(X, 2), ROTR(X, 13), ROTR(X, 22))
+# define BSIG1(X) XOR3(ROTR(X, 6), ROTR(X, 11), ROTR(X, 25))
+# define SSIG0(X) XOR3(ROTR(X, 7), ROTR(X, 18), SHR(X, 3))
+# define SSIG1(X) XOR3(ROTR(X, 17), ROTR(X, 19), SHR(X, 10))
+
+# define SCHEDULE(I)\
+	(w[(I) & 15] = ADD(ADD(w[(I) & 15], SSIG0(w[((I) + 1) & 15])),\
+	                   ADD(w[((I) + 9) & 15], SSIG1(w[((I) + 14) & 15]))))
+
+# define ROUND(A, B, C, D, E, F, G, H, I, W)\
+	do {\
+		t1 = ADD(ADD(H, BSIG1(E)), ADD(CH(E, F, G), ADD(_mm256_set1_epi32((int)libsha2_k32[I]), W)));\
+		t2 = ADD(BSIG0(A), MAJ(A, B, C));\
+		D = ADD(D, t1);\
+		H = ADD(t1, t2);\
+	} while (0)
+
+# define ROUNDS8(I, W)\
+	do {\
+		ROUND(a, b, c, d, e, f, g, h, (I) + 0, W((I) + 0));\
+		ROUND(h, a, b, c, d, e, f, g, (I) + 1, W((I) + 1));\
+		ROUND(g, h, a, b, c, d, e, f, (I) + 2, W((I) + 2));\
+		ROUND(f, g, h, a, b, c, d, e, (I) + 3, W((I) + 3));\
+		ROUND(e, f, g, h, a, b, c, d, (I) + 4, W((I) + 4));\
+		ROUND(d, e, f, g, h, a, b, c, (I) + 5, W((I) + 5));\
+		ROUND(c, d, e, f, g, h, a, b, (I) + 6, W((I) + 6));\
+		ROUND(b, c, d, e, f, g, h, a, (I) + 7, W((I) + 7));\
+	} while (0)
+
+# define LOADED(I) w[I]
+
+
+/**
+ * Transpose an 8-by-8 matrix of 32-bit words
+ * 
+ * @param  r  The rows of the matrix
+ */
+TARGET static inline void
+transpose(__m256i r[8])
+{
+	__m256i t0, t1, t2, t3, t4, t5, t6, t7;
+
+	t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+	t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+	t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+	t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+	t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+	t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+	t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+	t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+	r[0] = _mm256_unpacklo_epi64(t0, t2);
+	r[1] = _mm256_unpackhi_epi64(t0, t2);
+	r[2] = _mm256_unpacklo_epi64(t1, t3);
+	r[3] = _mm256_unpackhi_epi64(t1, t3);
+	r[4] = _mm256_unpacklo_epi64(t4, t6);
+	r[5] = _mm256_unpackhi_epi64(t4, t6);
+	r[6] = _mm256_unpacklo_epi64(t5, t7);
+	r[7] = _mm256_unpackhi_epi64(t5, t7);
+
+	t0 = _mm256_permute2x128_si256(r[0], r[4], 0x20);
+	t4 = _mm256_permute2x128_si256(r[0], r[4], 0x31);
+	t1 = _mm256_permute2x128_si256(r[1], r[5], 0x20);
+	t5 = _mm256_permute2x128_si256(r[1], r[5], 0x31);
+	t2 = _mm256_permute2x128_si256(r[2], r[6], 0x20);
+	t6 = _mm256_permute2x128_si256(r[2], r[6], 0x31);
+	t3 = _mm256_permute2x128_si256(r[3], r[7], 0x20);
+	t7 = _mm256_permute2x128_si256(r[3], r[7], 0x31);
+
+	r[0] = t0, r[1] = t1, r[2] = t2, r[3] = t3;
+	r[4] = t4, r[5] = t5, r[6] = t6, r[7] = t7;
+}
+
+
+TARGET void
+libsha2_process_avx2_sha256_x8(void *const *hs, const unsigned char *const *data, size_t chunks)
+{
+	const __m256i SHUFFLE_MASK = _mm256_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                               0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+	__m256i a, b, c, d, e, f, g, h, t1, t2, w[16], s[8];
+	size_t i, off, lane;
+
+	for (lane = 0; lane < 8; lane++)
+		s[lane] = _mm256_loadu_si256((const __m256i *)hs[lane]);
+	transpose(s);
+
+	for (off = 0; chunks--; off += 64) {
+		for (i = 0; i < 2; i++) {
+			for (lane = 0; lane < 8; lane++) {
+				w[8 * i + lane] = _mm256_loadu_si256((const __m256i *)&data[lane][off + 32 * i]);
+				w[8 * i + lane] = _mm256_shuffle_epi8(w[8 * i + lane], SHUFFLE_MASK);
+			}
+			transpose(&w[8 * i]);
+		}
+
+		a = s[0], b = s[1], c = s[2], d = s[3];
+		e = s[4], f = s[5], g = s[6], h = s[7];
+
+		ROUNDS8(0, LOADED);
+		ROUNDS8(8, LOADED);
+		for (i = 16; i < 64; i += 8)
+			ROUNDS8(i, SCHEDULE);
+
+		s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+	}
+
+	transpose(s);
+	for (lane = 0; lane < 8; lane++)
+		_mm256_storeu_si256((__m256i *)hs[lane], s[lane]);
+}
+
+
+
+# define PADDED(I) _mm256_set1_epi32((int)libsha2_sha256_pad64_w[I])
+
+TARGET void
+libsha2_fixed_avx2_sha256_x8(unsigned char *restrict out, const unsigned char *restrict data, int twice)
+{
+	const __m256i SHUFFLE_MASK = _mm256_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                               0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+	__m256i a, b, c, d, e, f, g, h, t1, t2, w[16], s[8];
+	size_t i, lane;
+
+	for (i = 0; i < 2; i++) {
+		for (lane = 0; lane < 8; lane++) {
+			w[8 * i + lane] = _mm256_loadu_si256((const __m256i *)&data[64 * lane + 32 * i]);
+			w[8 * i + lane] = _mm256_shuffle_epi8(w[8 * i + lane], SHUFFLE_MASK);
+		}
+		transpose(&w[8 * i]);
+	}
+
+	for (i = 0; i < 8; i++)
+		s[i] = _mm256_set1_epi32((int)libsha2_h256[i]);
+	a = s[0], b = s[1], c = s[2], d = s[3];
+	e = s[4], f = s[5], g = s[6], h = s[7];
+	ROUNDS8(0, LOADED);
+	ROUNDS8(8, LOADED);
+	for (i = 16; i < 64; i += 8)
+		ROUNDS8(i, SCHEDULE);
+	s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+	s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+
+	a = s[0], b = s[1], c = s[2], d = s[3];
+	e = s[4], f = s[5], g = s[6], h = s[7];
+	for (i = 0; i < 64; i += 8)
+		ROUNDS8(i, PADDED);
+	s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+	s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+
+	if (twice) {
+		/* The hashes are already laid out as message words */
+		for (i = 0; i < 8; i++)
+			w[i] = s[i];
+		w[8] = _mm256_set1_epi32((int)0x80000000L);
+		for (i = 9; i < 15; i++)
+			w[i] = _mm256_setzero_si256();
+		w[15] = _mm256_set1_epi32(256);
+
+		for (i = 0; i < 8; i++)
+			s[i] = _mm256_set1_epi32((int)libsha2_h256[i]);
+		a = s[0], b = s[1], c = s[2], d = s[3];
+		e = s[4], f = s[5], g = s[6], h = s[7];
+		ROUNDS8(0, LOADED);
+		ROUNDS8(8, LOADED);
+		for (i = 16; i < 64; i += 8)
+			ROUNDS8(i, SCHEDULE);
+		s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+	}
+
+	transpose(s);
+	for (lane = 0; lane < 8; lane++)
+		_mm256_storeu_si256((__m256i *)&out[32 * lane], _mm256_shuffle_epi8(s[lane], SHUFFLE_MASK));
+}
+
+# define ROTR64(X, N) (((X) >> (N)) | ((X) << (64 - (N))))
+
+# define ROUND512(A, B, C, D, E, F, G, H, WK)\
+	do {\
+		t1 = H + (ROTR64(E, 14) ^ ROTR64(E, 18) ^ ROTR64(E, 41)) + (G ^ (E & (F ^ G))) + (WK);\
+		t2 = (ROTR64(A, 28) ^ ROTR64(A, 34) ^ ROTR64(A, 39)) + ((A & B) | (C & (A | B)));\
+		D += t1;\
+		H = t1 + t2;\
+	} while (0)
+
+# define ROUNDS512_X2(A, B, C, D, E, F, G, H, I)\
+	do {\
+		ROUND512(A, B, C, D, E, F, G, H, wk[cur][I][lane + 0]);\
+		ROUND512(H, A, B, C, D, E, F, G, wk[cur][I][lane + 1]);\
+	} while (0)
+
+# define VROTR64(X, N) _mm256_or_si256(_mm256_srli_epi64(X, N), _mm256_slli_epi64(X, 64 - (N)))
+
+# define SSIG0_512(X) XOR3(VROTR64(X, 1), VROTR64(X, 8), _mm256_srli_epi64(X, 7))
+# define SSIG1_512(X) XOR3(VROTR64(X, 19), VROTR64(X, 61), _mm256_srli_epi64(X, 6))
+
+# define K512_X2(I) _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)&libsha2_k64[2 * (I)]))
+
+/* Compute words 2(I + J) and 2(I + J) + 1, for both interleaved chunks, of the next message schedule */
+# define LOAD512(I, J)\
+	(x[J] = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)&next1[16 * (J)])),\
+	 x[J] = _mm256_inserti128_si256(x[J], _mm_loadu_si128((const __m128i *)&next2[16 * (J)]), 1),\
+	 x[J] = _mm256_shuffle_epi8(x[J], SHUFFLE_MASK),\
+	 _mm256_storeu_si256((__m256i *)wk[cur ^ 1][J], _mm256_add_epi64(x[J], K512_X2(J))))
+# define SCHEDULE512(I, J)\
+	(t = _mm256_add_epi64(x[J], SSIG0_512(_mm256_alignr_epi8(x[((J) + 1) & 7], x[J], 8))),\
+	 t = _mm256_add_epi64(t, _mm256_alignr_epi8(x[((J) + 5) & 7], x[((J) + 4) & 7], 8)),\
+	 x[J] = _mm256_add_epi64(t, SSIG1_512(x[((J) + 7) & 7])),\
+	 _mm256_storeu_si256((__m256i *)wk[cur ^ 1][(I) + (J)], _mm256_add_epi64(x[J], K512_X2((I) + (J)))))
+# define NO_SCHEDULE512(I, J) ((void)0)
+
+/* Run 16 rounds, and interleave them with 16 words of the next message schedule */
+# define ROUNDS512_X16(I, STEP)\
+	do {\
+		STEP(I, 0); ROUNDS512_X2(a, b, c, d, e, f, g, h, (I) + 0);\
+		STEP(I, 1); ROUNDS512_X2(g, h, a, b, c, d, e, f, (I) + 1);\
+		STEP(I, 2); ROUNDS512_X2(e, f, g, h, a, b, c, d, (I) + 2);\
+		STEP(I, 3); ROUNDS512_X2(c, d, e, f, g, h, a, b, (I) + 3);\
+		STEP(I, 4); ROUNDS512_X2(a, b, c, d, e, f, g, h, (I) + 4);\
+		STEP(I, 5); ROUNDS512_X2(g, h, a, b, c, d, e, f, (I) + 5);\
+		STEP(I, 6); ROUNDS512_X2(e, f, g, h, a, b, c, d, (I) + 6);\
+		STEP(I, 7); ROUNDS512_X2(c, d, e, f, g, h, a, b, (I) + 7);\
+	} while (0)
+
+__attribute__((__target__("avx2,bmi2")))
+void
+libsha2_process_avx2_sha512(uint_least64_t *restrict hash, const unsigned char *restrict data, size_t chunks)
+{
+	const __m256i SHUFFLE_MASK = _mm256_set_epi64x(0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL,
+	                                               0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL);
+	uint_least64_t wk[2][40][4];
+	uint_least64_t a, b, c, d, e, f, g, h, t1, t2;
+	__m256i x[8], t;
+	const unsigned char *restrict next1;
+	const unsigned char *restrict next2;
+	size_t len = chunks * 128, off, n, next_n, i, lane, cur = 1;
+
+	if (!chunks)
+		return;
+
+	/* Compute the message schedule for the first one or two chunks */
+	n = len >= 256 ? 256 : 128;
+	next1 = data;
+	next2 = &data[n - 128];
+	LOAD512(0, 0), LOAD512(0, 1), LOAD512(0, 2), LOAD512(0, 3);
+	LOAD512(0, 4), LOAD512(0, 5), LOAD512(0, 6), LOAD512(0, 7);
+	for (i = 8; i < 40; i += 8) {
+		SCHEDULE512(i, 0), SCHEDULE512(i, 1), SCHEDULE512(i, 2), SCHEDULE512(i, 3);
+		SCHEDULE512(i, 4), SCHEDULE512(i, 5), SCHEDULE512(i, 6), SCHEDULE512(i, 7);
+	}
+	cur = 0;
+
+	for (off = 0;; off += n, n = next_n, cur ^= 1) {
+		next_n = len - off - n >= 256 ? 256 : len - off - n >= 128 ? 128 : 0;
+		next1 = &data[off + n];
+		next2 = &data[off + n + next_n - 128];
+
+		/* First chunk, interleaved with the message schedule for the next chunks */
+		lane = 0;
+		a = hash[0], b = hash[1], c = hash[2], d = hash[3];
+		e = hash[4], f = hash[5], g = hash[6], h = hash[7];
+		if (next_n) {
+			ROUNDS512_X16(0, LOAD512);
+			for (i = 8; i < 40; i += 8)
+				ROUNDS512_X16(i, SCHEDULE512);
+		} else {
+			for (i = 0; i < 40; i += 8)
+				ROUNDS512_X16(i, NO_SCHEDULE512);
+		}
+		hash[0] += a, hash[1] += b, hash[2] += c, hash[3] += d;
+		hash[4] += e, hash[5] += f, hash[6] += g, hash[7] += h;
+
+		/* Second chunk */
+		if (n == 256) {
+			lane = 2;
+			a = hash[0], b = hash[1], c = hash[2], d = hash[3];
+			e = hash[4], f = hash[5], g = hash[6], h = hash[7];
+			for (i = 0; i < 40; i += 8)
+				ROUNDS512_X16(i, NO_SCHEDULE512);
+			hash[0] += a, hash[1] += b, hash[2] += c, hash[3] += d;
+			hash[4] += e, hash[5] += f, hash[6] += g, hash[7] += h;
+		}
+
+		if (!next_n)
+			return;
+	}
+}
+
+
+#endif
@@ -0,0 +1,279 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+#ifdef HAVE_X86_AVX512_INTRINSICS
+# include <immintrin.h>
+
+
+# define TARGET __attribute__((__target__("avx512f,avx512bw")))
+
+# define CH(E, F, G)   _mm512_ternarylogic_epi32(E, F, G, 0xCA)
+# define MAJ(A, B, C)  _mm512_ternarylogic_epi32(A, B, C, 0xE8)
+# define XOR3(A, B, C) _mm512_ternarylogic_epi32(A, B, C, 0x96)
+
+# define ROUND(A, B, C, D, E, F, G, H, I, W)\
+	do {\
+		t1 = ADD(ADD(H, BSIG1(E)), ADD(CH(E, F, G), ADD(K(I), W)));\
+		t2 = ADD(BSIG0(A), MAJ(A, B, C));\
+		D = ADD(D, t1);\
+		H = ADD(t1, t2);\
+	} while (0)
+
+# define ROUNDS8(I, W)\
+	do {\
+		ROUND(a, b, c, d, e, f, g, h, (I) + 0, W((I) + 0));\
+		ROUND(h, a, b, c, d, e, f, g, (I) + 1, W((I) + 1));\
+		ROUND(g, h, a, b, c, d, e, f, (I) + 2, W((I) + 2));\
+		ROUND(f, g, h, a, b, c, d, e, (I) + 3, W((I) + 3));\
+		ROUND(e, f, g, h, a, b, c, d, (I) + 4, W((I) + 4));\
+		ROUND(d, e, f, g, h, a, b, c, (I) + 5, W((I) + 5));\
+		ROUND(c, d, e, f, g, h, a, b, (I) + 6, W((I) + 6));\
+		ROUND(b, c, d, e, f, g, h, a, (I) + 7, W((I) + 7));\
+	} while (0)
+
+# define SCHEDULE(I)\
+	(w[(I) & 15] = ADD(ADD(w[(I) & 15], SSIG0(w[((I) + 1) & 15])),\
+	                   ADD(w[((I) + 9) & 15], SSIG1(w[((I) + 14) & 15]))))
+
+# define LOADED(I) w[I]
+
+
+/**
+ * Transpose a 16-by-16 matrix of 32-bit words
+ * 
+ * @param  r  The rows of the matrix
+ */
+TARGET static inline void
+transpose32(__m512i r[16])
+{
+	__m512i t[16], v0, v1, v2, v3;
+	size_t i;
+
+	for (i = 0; i < 16; i += 2) {
+		t[i + 0] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+		t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+	}
+	for (i = 0; i < 16; i += 4) {
+		r[i + 0] = _mm512_unpacklo_epi64(t[i + 0], t[i + 2]);
+		r[i + 1] = _mm512_unpackhi_epi64(t[i + 0], t[i + 2]);
+		r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+		r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+	}
+	for (i = 0; i < 4; i++) {
+		v0 = _mm512_shuffle_i32x4(r[i + 0], r[i + 4], 0x44);
+		v1 = _mm512_shuffle_i32x4(r[i + 0], r[i + 4], 0xEE);
+		v2 = _mm512_shuffle_i32x4(r[i + 8], r[i + 12], 0x44);
+		v3 = _mm512_shuffle_i32x4(r[i + 8], r[i + 12], 0xEE);
+		t[i + 0]  = _mm512_shuffle_i32x4(v0, v2, 0x88);
+		t[i + 4]  = _mm512_shuffle_i32x4(v0, v2, 0xDD);
+		t[i + 8]  = _mm512_shuffle_i32x4(v1, v3, 0x88);
+		t[i + 12] = _mm512_shuffle_i32x4(v1, v3, 0xDD);
+	}
+	for (i = 0; i < 16; i++)
+		r[i] = t[i];
+}
+
+
+/**
+ * Transpose an 8-by-8 matrix of 64-bit words
+ * 
+ * @param  r  The rows of the matrix
+ */
+TARGET static inline void
+transpose64(__m512i r[8])
+{
+	__m512i t[8];
+	size_t i;
+
+	for (i = 0; i < 8; i += 2) {
+		t[i + 0] = _mm512_unpacklo_epi64(r[i], r[i + 1]);
+		t[i + 1] = _mm512_unpackhi_epi64(r[i], r[i + 1]);
+	}
+	for (i = 0; i < 8; i += 4) {
+		r[i + 0] = _mm512_shuffle_i64x2(t[i + 0], t[i + 2], 0x88);
+		r[i + 1] = _mm512_shuffle_i64x2(t[i + 1], t[i + 3], 0x88);
+		r[i + 2] = _mm512_shuffle_i64x2(t[i + 0], t[i + 2], 0xDD);
+		r[i + 3] = _mm512_shuffle_i64x2(t[i + 1], t[i + 3], 0xDD);
+	}
+	for (i = 0; i < 4; i++) {
+		t[i + 0] = _mm512_shuffle_i64x2(r[i], r[i + 4], 0x88);
+		t[i + 4] = _mm512_shuffle_i64x2(r[i], r[i + 4], 0xDD);
+	}
+	for (i = 0; i < 8; i++)
+		r[i] = t[i];
+}
+
+
+# define ADD(A, B) _mm512_add_epi32(A, B)
+# define ROTR(X, N) _mm512_ror_epi32(X, N)
+# define SHR(X, N) _mm512_srli_epi32(X, N)
+# define K(I) _mm512_set1_epi32((int)libsha2_k32[I])
+# define BSIG0(X) XOR3(ROTR(X, 2), ROTR(X, 13), ROTR(X, 22))
+# define BSIG1(X) XOR3(ROTR(X, 6), ROTR(X, 11), ROTR(X, 25))
+# define SSIG0(X) XOR3(ROTR(X, 7), ROTR(X, 18), SHR(X, 3))
+# define SSIG1(X) XOR3(ROTR(X, 17), ROTR(X, 19), SHR(X, 10))
+
+TARGET void
+libsha2_process_avx512_sha256_x16(void *const *hs, const unsigned char *const *data, size_t chunks)
+{
+	const __m512i SHUFFLE_MASK = _mm512_set_epi64(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                              0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                              0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                              0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+	__m512i a, b, c, d, e, f, g, h, t1, t2, w[16], s[16];
+	size_t i, off, lane;
+
+	for (lane = 0; lane < 16; lane++)
+		s[lane] = _mm512_zextsi256_si512(_mm256_loadu_si256((const __m256i *)hs[lane]));
+	transpose32(s);
+
+	for (off = 0; chunks--; off += 64) {
+		for (lane = 0; lane < 16; lane++)
+			w[lane] = _mm512_shuffle_epi8(_mm512_loadu_si512(&data[lane][off]), SHUFFLE_MASK);
+		transpose32(w);
+
+		a = s[0], b = s[1], c = s[2], d = s[3];
+		e = s[4], f = s[5], g = s[6], h = s[7];
+
+		ROUNDS8(0, LOADED);
+		ROUNDS8(8, LOADED);
+		for (i = 16; i < 64; i += 8)
+			ROUNDS8(i, SCHEDULE);
+
+		s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+	}
+
+	for (i = 8; i < 16; i++)
+		s[i] = _mm512_setzero_si512();
+	transpose32(s);
+	for (lane = 0; lane < 16; lane++)
+		_mm256_storeu_si256((__m256i *)hs[lane], _mm512_castsi512_si256(s[lane]));
+}
+
+# define PADDED(I) _mm512_set1_epi32((int)libsha2_sha256_pad64_w[I])
+
+TARGET void
+libsha2_fixed_avx512_sha256_x16(unsigned char *restrict out, const unsigned char *restrict data, int twice)
+{
+	const __m512i SHUFFLE_MASK = _mm512_set_epi64(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                              0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                              0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL,
+	                                              0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+	__m512i a, b, c, d, e, f, g, h, t1, t2, w[16], s[16];
+	size_t i, lane;
+
+	for (lane = 0; lane < 16; lane++)
+		w[lane] = _mm512_shuffle_epi8(_mm512_loadu_si512(&data[64 * lane]), SHUFFLE_MASK);
+	transpose32(w);
+
+	for (i = 0; i < 8; i++)
+		s[i] = _mm512_set1_epi32((int)libsha2_h256[i]);
+	a = s[0], b = s[1], c = s[2], d = s[3];
+	e = s[4], f = s[5], g = s[6], h = s[7];
+	ROUNDS8(0, LOADED);
+	ROUNDS8(8, LOADED);
+	for (i = 16; i < 64; i += 8)
+		ROUNDS8(i, SCHEDULE);
+	s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+	s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+
+	a = s[0], b = s[1], c = s[2], d = s[3];
+	e = s[4], f = s[5], g = s[6], h = s[7];
+	for (i = 0; i < 64; i += 8)
+		ROUNDS8(i, PADDED);
+	s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+	s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+
+	if (twice) {
+		/* The hashes are already laid out as message words */
+		for (i = 0; i < 8; i++)
+			w[i] = s[i];
+		w[8] = _mm512_set1_epi32((int)0x80000000L);
+		for (i = 9; i < 15; i++)
+			w[i] = _mm512_setzero_si512();
+		w[15] = _mm512_set1_epi32(256);
+
+		for (i = 0; i < 8; i++)
+			s[i] = _mm512_set1_epi32((int)libsha2_h256[i]);
+		a = s[0], b = s[1], c = s[2], d = s[3];
+		e = s[4], f = s[5], g = s[6], h = s[7];
+		ROUNDS8(0, LOADED);
+		ROUNDS8(8, LOADED);
+		for (i = 16; i < 64; i += 8)
+			ROUNDS8(i, SCHEDULE);
+		s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+	}
+
+	for (i = 8; i < 16; i++)
+		s[i] = _mm512_setzero_si512();
+	transpose32(s);
+	for (lane = 0; lane < 16; lane++)
+		_mm256_storeu_si256((__m256i *)&out[32 * lane],
+		                    _mm512_castsi512_si256(_mm512_shuffle_epi8(s[lane], SHUFFLE_MASK)));
+}
+
+# undef PADDED
+
+# undef ADD
+# undef ROTR
+# undef SHR
+# undef K
+# undef BSIG0
+# undef BSIG1
+# undef SSIG0
+# undef SSIG1
+
+
+# define ADD(A, B) _mm512_add_epi64(A, B)
+# define ROTR(X, N) _mm512_ror_epi64(X, N)
+# define SHR(X, N) _mm512_srli_epi64(X, N)
+# define K(I) _mm512_set1_epi64((long long int)libsha2_k64[I])
+# define BSIG0(X) XOR3(ROTR(X, 28), ROTR(X, 34), ROTR(X, 39))
+# define BSIG1(X) XOR3(ROTR(X, 14), ROTR(X, 18), ROTR(X, 41))
+# define SSIG0(X) XOR3(ROTR(X, 1), ROTR(X, 8), SHR(X, 7))
+# define SSIG1(X) XOR3(ROTR(X, 19), ROTR(X, 61), SHR(X, 6))
+
+TARGET void
+libsha2_process_avx512_sha512_x8(void *const *hs, const unsigned char *const *data, size_t chunks)
+{
+	const __m512i SHUFFLE_MASK = _mm512_set_epi64(0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL,
+	                                              0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL,
+	                                              0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL,
+	                                              0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL);
+	__m512i a, b, c, d, e, f, g, h, t1, t2, w[16], s[8];
+	size_t i, off, lane;
+
+	for (lane = 0; lane < 8; lane++)
+		s[lane] = _mm512_loadu_si512(hs[lane]);
+	transpose64(s);
+
+	for (off = 0; chunks--; off += 128) {
+		for (i = 0; i < 2; i++) {
+			for (lane = 0; lane < 8; lane++) {
+				w[8 * i + lane] = _mm512_loadu_si512(&data[lane][off + 64 * i]);
+				w[8 * i + lane] = _mm512_shuffle_epi8(w[8 * i + lane], SHUFFLE_MASK);
+			}
+			transpose64(&w[8 * i]);
+		}
+
+		a = s[0], b = s[1], c = s[2], d = s[3];
+		e = s[4], f = s[5], g = s[6], h = s[7];
+
+		ROUNDS8(0, LOADED);
+		ROUNDS8(8, LOADED);
+		for (i = 16; i < 80; i += 8)
+			ROUNDS8(i, SCHEDULE);
+
+		s[0] = ADD(s[0], a), s[1] = ADD(s[1], b), s[2] = ADD(s[2], c), s[3] = ADD(s[3], d);
+		s[4] = ADD(s[4], e), s[5] = ADD(s[5], f), s[6] = ADD(s[6], g), s[7] = ADD(s[7], h);
+	}
+
+	transpose64(s);
+	for (lane = 0; lane < 8; lane++)
+		_mm512_storeu_si512(hs[lane], s[lane]);
+}
+
+
+#endif
@@ -0,0 +1,86 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+size_t
+libsha2_multi_lanes(enum libsha2_algorithm algorithm)
+{
+	libsha2_resolve_dispatch();
+	return algorithm <= LIBSHA2_256 ? libsha2_dispatch.lanes32 : libsha2_dispatch.lanes64;
+}
+
+
+void
+libsha2_process_multi(struct libsha2_job *restrict jobs, size_t n, enum libsha2_algorithm algorithm)
+{
+	void (*kernel)(void *const *, const unsigned char *const *, size_t);
+	struct libsha2_job *lane_job[16];
+	void *h[16];
+	const unsigned char *data[16];
+	uint_least64_t unused_h[8];
+	size_t part[16], lanes, chunk_size, i, min, active, first, next = 0;
+
+	libsha2_resolve_dispatch();
+	if (algorithm <= LIBSHA2_256) {
+		kernel = libsha2_dispatch.multi32;
+		lanes = libsha2_dispatch.lanes32;
+		chunk_size = 64;
+	} else {
+		kernel = libsha2_dispatch.multi64;
+		lanes = libsha2_dispatch.lanes64;
+		chunk_size = 128;
+	}
+	if (!lanes)
+		return;
+
+	for (i = 0; i < lanes; i++)
+		lane_job[i] = NULL;
+
+	for (;;) {
+		/* Fill empty lanes and find the number of chunks all lanes can process */
+		active = 0;
+		min = SIZE_MAX;
+		for (i = 0; i < lanes; i++) {
+			while (!lane_job[i]) {
+				if (next == n)
+					break;
+				lane_job[i] = &jobs[next++];
+				for (part[i] = 0; part[i] < 3 && !lane_job[i]->chunks[part[i]]; part[i]++);
+				if (part[i] == 3)
+					lane_job[i] = NULL;
+			}
+			if (!lane_job[i])
+				continue;
+			if (lane_job[i]->chunks[part[i]] < min)
+				min = lane_job[i]->chunks[part[i]];
+			h[i] = lane_job[i]->h;
+			data[i] = lane_job[i]->data[part[i]];
+			active += 1;
+		}
+		if (!active)
+			break;
+
+		/* Let idle lanes shadow an active lane, discarding the result */
+		for (first = 0; !lane_job[first]; first++);
+		for (i = 0; i < lanes; i++) {
+			if (!lane_job[i]) {
+				h[i] = unused_h;
+				data[i] = data[first];
+			}
+		}
+
+		kernel(h, data, min);
+
+		/* Advance the lanes and retire finished messages */
+		for (i = 0; i < lanes; i++) {
+			if (!lane_job[i])
+				continue;
+			lane_job[i]->data[part[i]] += min * chunk_size;
+			lane_job[i]->chunks[part[i]] -= min;
+			while (part[i] < 3 && !lane_job[i]->chunks[part[i]])
+				part[i]++;
+			if (part[i] == 3)
+				lane_job[i] = NULL;
+		}
+	}
+}
@@ -0,0 +1,226 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+/**
+ * Read a big-endian 32-bit word
+ * 
+ * @param   p  The bytes to read
+ * @return     The word
+ */
+static inline uint_least32_t
+load_be32(const unsigned char *p)
+{
+	return ((uint_least32_t)p[0] << 24) | ((uint_least32_t)p[1] << 16) |
+	       ((uint_least32_t)p[2] << 8) | (uint_least32_t)p[3];
+}
+
+
+/**
+ * Read a big-endian 64-bit word
+ * 
+ * @param   p  The bytes to read
+ * @return     The word
+ */
+static inline uint_least64_t
+load_be64(const unsigned char *p)
+{
+	return ((uint_least64_t)load_be32(p) << 32) | (uint_least64_t)load_be32(&p[4]);
+}
+
+
+/* The following macros are shared by the SHA-256 and SHA-512 cores,
+ * which define WORD_SIZE, TRUNC, LOAD, K, BSIG0, BSIG1, SSIG0, and SSIG1
+ * before use. The working variables are never moved, instead the
+ * argument list is rotated by one step for each round. */
+
+#define CH(E, F, G) ((G) ^ ((E) & ((F) ^ (G))))
+#define MAJ(A, B, C) (((A) & (B)) | ((C) & ((A) | (B))))
+
+#define LOAD_W(I) (w[I] = LOAD(&data[(I) * WORD_SIZE]))
+#define SCHEDULE_W(I)\
+	(w[(I) & 15] = TRUNC(w[(I) & 15] + SSIG0(w[((I) + 1) & 15]) + w[((I) + 9) & 15] + SSIG1(w[((I) + 14) & 15])))
+
+#define ROUND(A, B, C, D, E, F, G, H, I, GET_W)\
+	do {\
+		t1 = H + BSIG1(E) + CH(E, F, G) + K[I] + GET_W(I);\
+		t2 = BSIG0(A) + MAJ(A, B, C);\
+		D = TRUNC(D + t1);\
+		H = TRUNC(t1 + t2);\
+	} while (0)
+
+#define ROUNDS8(I, GET_W)\
+	do {\
+		ROUND(a, b, c, d, e, f, g, h, (I) + 0, GET_W);\
+		ROUND(h, a, b, c, d, e, f, g, (I) + 1, GET_W);\
+		ROUND(g, h, a, b, c, d, e, f, (I) + 2, GET_W);\
+		ROUND(f, g, h, a, b, c, d, e, (I) + 3, GET_W);\
+		ROUND(e, f, g, h, a, b, c, d, (I) + 4, GET_W);\
+		ROUND(d, e, f, g, h, a, b, c, (I) + 5, GET_W);\
+		ROUND(c, d, e, f, g, h, a, b, (I) + 6, GET_W);\
+		ROUND(b, c, d, e, f, g, h, a, (I) + 7, GET_W);\
+	} while (0)
+
+#define LOAD_STATE()\
+	(a = hash[0], b = hash[1], c = hash[2], d = hash[3],\
+	 e = hash[4], f = hash[5], g = hash[6], h = hash[7])
+
+#define ADD_STATE()\
+	(hash[0] = TRUNC(hash[0] + a), hash[1] = TRUNC(hash[1] + b),\
+	 hash[2] = TRUNC(hash[2] + c), hash[3] = TRUNC(hash[3] + d),\
+	 hash[4] = TRUNC(hash[4] + e), hash[5] = TRUNC(hash[5] + f),\
+	 hash[6] = TRUNC(hash[6] + g), hash[7] = TRUNC(hash[7] + h))
+
+
+#define WORD_SIZE 4
+#define TRUNC(X) TRUNC32(X)
+#define LOAD(P) load_be32(P)
+#define K libsha2_k32
+#define ROTR(X, N) TRUNC32(((X) >> (N)) | ((X) << (32 - (N))))
+#define BSIG0(X) (ROTR(X, 2) ^ ROTR(X, 13) ^ ROTR(X, 22))
+#define BSIG1(X) (ROTR(X, 6) ^ ROTR(X, 11) ^ ROTR(X, 25))
+#define SSIG0(X) (ROTR(X, 7) ^ ROTR(X, 18) ^ ((X) >> 3))
+#define SSIG1(X) (ROTR(X, 17) ^ ROTR(X, 19) ^ ((X) >> 10))
+
+void
+libsha2_process_portable_sha256(uint_least32_t *restrict hash, const unsigned char *restrict data, size_t chunks)
+{
+	uint_least32_t a, b, c, d, e, f, g, h, t1, t2, w[16];
+
+	for (; chunks--; data += 64) {
+		LOAD_STATE();
+		ROUNDS8(0, LOAD_W);
+		ROUNDS8(8, LOAD_W);
+		ROUNDS8(16, SCHEDULE_W);
+		ROUNDS8(24, SCHEDULE_W);
+		ROUNDS8(32, SCHEDULE_W);
+		ROUNDS8(40, SCHEDULE_W);
+		ROUNDS8(48, SCHEDULE_W);
+		ROUNDS8(56, SCHEDULE_W);
+		ADD_STATE();
+	}
+}
+
+#define PAD_W(I) libsha2_sha256_pad64_w[I]
+#define HASH_W(I) w[I]
+
+void
+libsha2_fixed_portable_sha256(unsigned char *restrict out, const unsigned char *restrict data, size_t n, int twice)
+{
+	uint_least32_t a, b, c, d, e, f, g, h, t1, t2, w[16], hash[8];
+	int i;
+
+	for (; n--; data += 64, out += 32) {
+		memcpy(hash, libsha2_h256, sizeof(hash));
+		LOAD_STATE();
+		ROUNDS8(0, LOAD_W);
+		ROUNDS8(8, LOAD_W);
+		ROUNDS8(16, SCHEDULE_W);
+		ROUNDS8(24, SCHEDULE_W);
+		ROUNDS8(32, SCHEDULE_W);
+		ROUNDS8(40, SCHEDULE_W);
+		ROUNDS8(48, SCHEDULE_W);
+		ROUNDS8(56, SCHEDULE_W);
+		ADD_STATE();
+
+		/* The padding chunk is the same for every message,
+		 * so its message schedule is precomputed */
+		LOAD_STATE();
+		ROUNDS8(0, PAD_W);
+		ROUNDS8(8, PAD_W);
+		ROUNDS8(16, PAD_W);
+		ROUNDS8(24, PAD_W);
+		ROUNDS8(32, PAD_W);
+		ROUNDS8(40, PAD_W);
+		ROUNDS8(48, PAD_W);
+		ROUNDS8(56, PAD_W);
+		ADD_STATE();
+
+		if (twice) {
+			/* The hash is hashed again, it fills the first half
+			 * of the only chunk and the rest is constant padding */
+			for (i = 0; i < 8; i++)
+				w[i] = hash[i];
+			w[8] = UINT32_C(0x80000000);
+			w[9] = w[10] = w[11] = w[12] = w[13] = w[14] = 0;
+			w[15] = 256;
+			memcpy(hash, libsha2_h256, sizeof(hash));
+			LOAD_STATE();
+			ROUNDS8(0, HASH_W);
+			ROUNDS8(8, HASH_W);
+			ROUNDS8(16, SCHEDULE_W);
+			ROUNDS8(24, SCHEDULE_W);
+			ROUNDS8(32, SCHEDULE_W);
+			ROUNDS8(40, SCHEDULE_W);
+			ROUNDS8(48, SCHEDULE_W);
+			ROUNDS8(56, SCHEDULE_W);
+			ADD_STATE();
+		}
+
+		libsha2_store_hash(out, hash, LIBSHA2_256);
+	}
+}
+
+#undef PAD_W
+#undef HASH_W
+
+#undef WORD_SIZE
+#undef TRUNC
+#undef LOAD
+#undef K
+#undef ROTR
+#undef BSIG0
+#undef BSIG1
+#undef SSIG0
+#undef SSIG1
+
+
+#define WORD_SIZE 8
+#define TRUNC(X) TRUNC64(X)
+#define LOAD(P) load_be64(P)
+#define K libsha2_k64
+#define ROTR(X, N) TRUNC64(((X) >> (N)) | ((X) << (64 - (N))))
+#define BSIG0(X) (ROTR(X, 28) ^ ROTR(X, 34) ^ ROTR(X, 39))
+#define BSIG1(X) (ROTR(X, 14) ^ ROTR(X, 18) ^ ROTR(X, 41))
+#define SSIG0(X) (ROTR(X, 1) ^ ROTR(X, 8) ^ ((X) >> 7))
+#define SSIG1(X) (ROTR(X, 19) ^ ROTR(X, 61) ^ ((X) >> 6))
+
+void
+libsha2_process_portable_sha512(uint_least64_t *restrict hash, const unsigned char *restrict data, size_t chunks)
+{
+	uint_least64_t a, b, c, d, e, f, g, h, t1, t2, w[16];
+
+	for (; chunks--; data += 128) {
+		LOAD_STATE();
+		ROUNDS8(0, LOAD_W);
+		ROUNDS8(8, LOAD_W);
+		ROUNDS8(16, SCHEDULE_W);
+		ROUNDS8(24, SCHEDULE_W);
+		ROUNDS8(32, SCHEDULE_W);
+		ROUNDS8(40, SCHEDULE_W);
+		ROUNDS8(48, SCHEDULE_W);
+		ROUNDS8(56, SCHEDULE_W);
+		ROUNDS8(64, SCHEDULE_W);
+		ROUNDS8(72, SCHEDULE_W);
+		ADD_STATE();
+	}
+}
+
+#undef WORD_SIZE
+#undef TRUNC
+#undef LOAD
+#undef K
+#undef ROTR
+#undef BSIG0
+#undef BSIG1
+#undef SSIG0
+#undef SSIG1
+
+#undef CH
+#undef MAJ
+#undef LOAD_W
+#undef SCHEDULE_W
+#undef ROUND
+#undef ROUNDS8
+#undef LOAD_STATE
+#undef ADD_STATE
@@ -0,0 +1,341 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+#ifdef HAVE_X86_SHA_NI_INTRINSICS
+# include <immintrin.h>
+
+
+# define TARGET __attribute__((__target__("sha,sse4.1")))
+
+/* Add the round constants for rounds 4I to 4I + 3 to the message words */
+# define ADD_K(M, I) _mm_add_epi32(M[(I) & 3], _mm_loadu_si128((const __m128i *)&libsha2_k32[4 * (I)]))
+
+/* Compute the message words for rounds 4I + 4 to 4I + 7 */
+# define MSG2(M, I)\
+	(M[((I) + 1) & 3] = _mm_add_epi32(M[((I) + 1) & 3], _mm_alignr_epi8(M[(I) & 3], M[((I) + 3) & 3], 4)),\
+	 M[((I) + 1) & 3] = _mm_sha256msg2_epu32(M[((I) + 1) & 3], M[(I) & 3]))
+
+/* Start the computation of the message words for rounds 4I + 12 to 4I + 15 */
+# define MSG1(M, I)\
+	(M[((I) + 3) & 3] = _mm_sha256msg1_epu32(M[((I) + 3) & 3], M[(I) & 3]))
+
+/* Run rounds 4I to 4I + 3 for both streams, with the instructions
+ * for the two independent dependency chains interleaved, and compute
+ * what can be computed of the message schedule at the same time */
+# define QUAD2(I)\
+	do {\
+		ka = ADD_K(ma, I);\
+		kb = ADD_K(mb, I);\
+		s1a = _mm_sha256rnds2_epu32(s1a, s0a, ka);\
+		s1b = _mm_sha256rnds2_epu32(s1b, s0b, kb);\
+		if ((I) >= 3 && (I) <= 14)\
+			MSG2(ma, I), MSG2(mb, I);\
+		ka = _mm_shuffle_epi32(ka, 0x0E);\
+		kb = _mm_shuffle_epi32(kb, 0x0E);\
+		s0a = _mm_sha256rnds2_epu32(s0a, s1a, ka);\
+		s0b = _mm_sha256rnds2_epu32(s0b, s1b, kb);\
+		if ((I) >= 1 && (I) <= 12)\
+			MSG1(ma, I), MSG1(mb, I);\
+	} while (0)
+
+# define LOAD_MSG(M, P)\
+	do {\
+		M[0] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&(P)[0]), SHUFFLE_MASK);\
+		M[1] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&(P)[16]), SHUFFLE_MASK);\
+		M[2] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&(P)[32]), SHUFFLE_MASK);\
+		M[3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&(P)[48]), SHUFFLE_MASK);\
+	} while (0)
+
+
+/**
+ * Convert hash values from the order used by SHA-256
+ * to the order used by the SHA-NI instructions
+ * 
+ * @param  h   The hash values
+ * @param  s0  Output parameter for the ABEF words
+ * @param  s1  Output parameter for the CDGH words
+ */
+TARGET static inline void
+load_state(const void *h, __m128i *s0, __m128i *s1)
+{
+	__m128i temp;
+
+	temp = _mm_loadu_si128((const __m128i *)h);
+	*s1 = _mm_loadu_si128((const __m128i *)&((const uint_least32_t *)h)[4]);
+
+	temp = _mm_shuffle_epi32(temp, 0xB1);
+	*s1  = _mm_shuffle_epi32(*s1, 0x1B);
+	*s0  = _mm_alignr_epi8(temp, *s1, 8);
+	*s1  = _mm_blend_epi16(*s1, temp, 0xF0);
+}
+
+
+/**
+ * Convert hash values from the order used by the
+ * SHA-NI instructions to the order used by SHA-256
+ * 
+ * @param  h   Output parameter for the hash values
+ * @param  s0  The ABEF words
+ * @param  s1  The CDGH words
+ */
+TARGET static inline void
+store_state(void *h, __m128i s0, __m128i s1)
+{
+	__m128i temp;
+
+	temp = _mm_shuffle_epi32(s0, 0x1B);
+	s1   = _mm_shuffle_epi32(s1, 0xB1);
+	s0   = _mm_blend_epi16(temp, s1, 0xF0);
+	s1   = _mm_alignr_epi8(s1, temp, 8);
+
+	_mm_storeu_si128((__m128i *)h, s0);
+	_mm_storeu_si128((__m128i *)&((uint_least32_t *)h)[4], s1);
+}
+
+
+TARGET void
+libsha2_process_shani_sha256(uint_least32_t *restrict hash, const unsigned char *restrict data, size_t chunks)
+{
+	const __m128i SHUFFLE_MASK = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+	__m128i temp, s0, s1, msg, msg0, msg1, msg2, msg3;
+	__m128i abef_orig, cdgh_orig;
+	const unsigned char *restrict chunk;
+
+	load_state(hash, &s0, &s1);
+
+	for (chunk = data; chunks--; chunk += 64) {
+		abef_orig = s0;
+		cdgh_orig = s1;
+
+# if defined(__GNUC__)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wsign-conversion"
+# endif
+
+		msg = _mm_loadu_si128((const __m128i *)&chunk[0]);
+		msg0 = _mm_shuffle_epi8(msg, SHUFFLE_MASK);
+		msg = _mm_add_epi32(msg0, _mm_set_epi64x(0xE9B5DBA5B5C0FBCFULL, 0x71374491428A2F98ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+
+	        msg1 = _mm_loadu_si128((const __m128i *)&chunk[16]);
+		msg1 = _mm_shuffle_epi8(msg1, SHUFFLE_MASK);
+		msg = _mm_add_epi32(msg1, _mm_set_epi64x(0xAB1C5ED5923F82A4ULL, 0x59F111F13956C25BULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+
+	        msg2 = _mm_loadu_si128((const __m128i *)&chunk[32]);
+		msg2 = _mm_shuffle_epi8(msg2, SHUFFLE_MASK);
+		msg = _mm_add_epi32(msg2, _mm_set_epi64x(0x550C7DC3243185BEULL, 0x12835B01D807AA98ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+		msg3 = _mm_loadu_si128((const __m128i *)&chunk[48]);
+		msg3 = _mm_shuffle_epi8(msg3, SHUFFLE_MASK);
+		msg = _mm_add_epi32(msg3, _mm_set_epi64x(0xC19BF1749BDC06A7ULL, 0x80DEB1FE72BE5D74ULL));
+		temp = _mm_alignr_epi8(msg3, msg2, 4);
+		msg0 = _mm_add_epi32(msg0, temp);
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+	        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0x240CA1CC0FC19DC6ULL, 0xEFBE4786E49B69C1ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg0, msg3, 4);
+		msg1 = _mm_add_epi32(msg1, temp);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+	        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0x76F988DA5CB0A9DCULL, 0x4A7484AA2DE92C6FULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg1, msg0, 4);
+		msg2 = _mm_add_epi32(msg2, temp);
+		msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+	        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0xBF597FC7B00327C8ULL, 0xA831C66D983E5152ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg2, msg1, 4);
+		msg3 = _mm_add_epi32(msg3, temp);
+		msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+	        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0x1429296706CA6351ULL,  0xD5A79147C6E00BF3ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg3, msg2, 4);
+		msg0 = _mm_add_epi32(msg0, temp);
+		msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+	        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0x53380D134D2C6DFCULL, 0x2E1B213827B70A85ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg0, msg3, 4);
+		msg1 = _mm_add_epi32(msg1, temp);
+		msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+	        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0x92722C8581C2C92EULL, 0x766A0ABB650A7354ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg1, msg0, 4);
+		msg2 = _mm_add_epi32(msg2, temp);
+		msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+	        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0xC76C51A3C24B8B70ULL, 0xA81A664BA2BFE8A1ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg2, msg1, 4);
+		msg3 = _mm_add_epi32(msg3, temp);
+		msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+	        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0x106AA070F40E3585ULL, 0xD6990624D192E819ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg3, msg2, 4);
+		msg0 = _mm_add_epi32(msg0, temp);
+		msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+	        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0x34B0BCB52748774CULL, 0x1E376C0819A4C116ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg0, msg3, 4);
+		msg1 = _mm_add_epi32(msg1, temp);
+		msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+		msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+	        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0x682E6FF35B9CCA4FULL, 0x4ED8AA4A391C0CB3ULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg1, msg0, 4);
+		msg2 = _mm_add_epi32(msg2, temp);
+		msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+
+	        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0x8CC7020884C87814ULL, 0x78A5636F748F82EEULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		temp = _mm_alignr_epi8(msg2, msg1, 4);
+		msg3 = _mm_add_epi32(msg3, temp);
+		msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+
+	        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0xC67178F2BEF9A3F7ULL, 0xA4506CEB90BEFFFAULL));
+		s1 = _mm_sha256rnds2_epu32(s1, s0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		s0 = _mm_sha256rnds2_epu32(s0, s1, msg);
+
+# if defined(__GNUC__)
+#  pragma GCC diagnostic pop
+# endif
+
+	        s0 = _mm_add_epi32(s0, abef_orig);
+		s1 = _mm_add_epi32(s1, cdgh_orig);
+	}
+
+	store_state(hash, s0, s1);
+}
+
+
+TARGET void
+libsha2_process_shani_sha256_x2(void *const *h, const unsigned char *const *data, size_t chunks)
+{
+	const __m128i SHUFFLE_MASK = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+	__m128i s0a, s1a, s0b, s1b, ka, kb, ma[4], mb[4];
+	__m128i abef_a, cdgh_a, abef_b, cdgh_b;
+	const unsigned char *pa = data[0];
+	const unsigned char *pb = data[1];
+
+	load_state(h[0], &s0a, &s1a);
+	load_state(h[1], &s0b, &s1b);
+
+	for (; chunks--; pa += 64, pb += 64) {
+		abef_a = s0a, cdgh_a = s1a;
+		abef_b = s0b, cdgh_b = s1b;
+
+		LOAD_MSG(ma, pa);
+		LOAD_MSG(mb, pb);
+
+		QUAD2(0);  QUAD2(1);  QUAD2(2);  QUAD2(3);
+		QUAD2(4);  QUAD2(5);  QUAD2(6);  QUAD2(7);
+		QUAD2(8);  QUAD2(9);  QUAD2(10); QUAD2(11);
+		QUAD2(12); QUAD2(13); QUAD2(14); QUAD2(15);
+
+		s0a = _mm_add_epi32(s0a, abef_a), s1a = _mm_add_epi32(s1a, cdgh_a);
+		s0b = _mm_add_epi32(s0b, abef_b), s1b = _mm_add_epi32(s1b, cdgh_b);
+	}
+
+	store_state(h[0], s0a, s1a);
+	store_state(h[1], s0b, s1b);
+}
+
+
+
+TARGET void
+libsha2_fixed_shani_sha256(unsigned char *restrict out, const unsigned char *restrict data, size_t n, int twice)
+{
+	__m128i s0, s1, abef_orig, cdgh_orig, wk;
+	uint_least32_t hash[8];
+	unsigned char buf[64];
+	size_t i;
+
+	/* Only the first half of the chunk for the second hash varies */
+	memset(&buf[32], 0, 32);
+	buf[32] = 0x80;
+	buf[62] = 0x01;
+
+	for (; n--; data += 64, out += 32) {
+		memcpy(hash, libsha2_h256, sizeof(hash));
+		libsha2_process_shani_sha256(hash, data, 1);
+
+		/* The padding chunk is the same for every message,
+		 * so its message schedule is precomputed */
+		load_state(hash, &s0, &s1);
+		abef_orig = s0;
+		cdgh_orig = s1;
+		for (i = 0; i < 64; i += 4) {
+			wk = _mm_add_epi32(_mm_loadu_si128((const __m128i *)&libsha2_sha256_pad64_w[i]),
+			                   _mm_loadu_si128((const __m128i *)&libsha2_k32[i]));
+			s1 = _mm_sha256rnds2_epu32(s1, s0, wk);
+			wk = _mm_shuffle_epi32(wk, 0x0E);
+			s0 = _mm_sha256rnds2_epu32(s0, s1, wk);
+		}
+		s0 = _mm_add_epi32(s0, abef_orig);
+		s1 = _mm_add_epi32(s1, cdgh_orig);
+		store_state(hash, s0, s1);
+
+		if (twice) {
+			libsha2_store_hash(buf, hash, LIBSHA2_256);
+			memcpy(hash, libsha2_h256, sizeof(hash));
+			libsha2_process_shani_sha256(hash, buf, 1);
+		}
+
+		libsha2_store_hash(out, hash, LIBSHA2_256);
+	}
+}
+
+
+#endif
@@ -0,0 +1,28 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <pthread.h>
+
+
+void
+libsha2_run_workers(void *(*worker)(void *), void *arg, size_t threads, size_t max)
+{
+	pthread_t *tids = NULL;
+	size_t i, started = 0;
+
+	threads = libsha2_thread_count(threads);
+	if (threads > max)
+		threads = max;
+
+	/* The calling thread is one of the workers, and
+	 * if threads cannot be created, it does all work */
+	if (threads > 1)
+		tids = malloc((threads - 1) * sizeof(*tids));
+	if (tids)
+		for (; started < threads - 1; started++)
+			if (pthread_create(&tids[started], NULL, worker, arg))
+				break;
+	worker(arg);
+	for (i = 0; i < started; i++)
+		pthread_join(tids[i], NULL);
+	free(tids);
+}
@@ -0,0 +1,9 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_set_backend(const char *backend)
+{
+	return libsha2_set_dispatch(backend);
+}
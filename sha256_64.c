@@ -0,0 +1,10 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_sha256_64(const void *restrict message, void *restrict hashsum)
+{
+	libsha2_resolve_dispatch();
+	libsha2_dispatch.fixed32(hashsum, message, 1, 0);
+}
@@ -0,0 +1,9 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_sha256_64_many(const void *restrict messages, size_t n, void *restrict hashsums)
+{
+	libsha2_fixed_many(hashsums, messages, n, 0);
+}
@@ -0,0 +1,27 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_sha256d(const void *restrict message, size_t msglen, void *restrict hashsum)
+{
+	uint_least32_t h[8];
+	unsigned char buf[64];
+
+	libsha2_resolve_dispatch();
+
+	if (msglen == 512) {
+		libsha2_dispatch.fixed32(hashsum, message, 1, 1);
+		return;
+	}
+
+	/* The second hash is always of a 32-byte message,
+	 * so it is a single chunk with constant padding */
+	libsha2_hash(LIBSHA2_256, message, msglen, buf);
+	memset(&buf[32], 0, 32);
+	buf[32] = 0x80;
+	buf[62] = 0x01;
+	memcpy(h, libsha2_h256, sizeof(h));
+	libsha2_dispatch.process32(h, buf, 1);
+	libsha2_store_hash(hashsum, h, LIBSHA2_256);
+}
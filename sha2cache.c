@@ -0,0 +1,106 @@
+/* See LICENSE file for copyright and license details. */
+#include "libsha2.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static const struct {
+	const char *name;
+	enum libsha2_algorithm algorithm;
+} algorithms[] = {
+	{"224", LIBSHA2_224},
+	{"256", LIBSHA2_256},
+	{"384", LIBSHA2_384},
+	{"512", LIBSHA2_512},
+	{"512/224", LIBSHA2_512_224},
+	{"512/256", LIBSHA2_512_256}
+};
+
+static const char *argv0 = "sha2cache";
+
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: %s [-a algorithm] cache-file file ...\n"
+	                "       %s -C cache-file\n", argv0, argv0);
+	exit(2);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	enum libsha2_algorithm algorithm = LIBSHA2_256;
+	struct libsha2_cache cache;
+	unsigned char hashsum[64];
+	char hex[129];
+	size_t i;
+	int c, fd, ret = 0, compact = 0;
+
+	if (argc && *argv)
+		argv0 = *argv;
+
+	while ((c = getopt(argc, argv, "a:C")) != -1) {
+		switch (c) {
+		case 'a':
+			for (i = 0; i < sizeof(algorithms) / sizeof(*algorithms); i++)
+				if (!strcmp(optarg, algorithms[i].name))
+					break;
+			if (i == sizeof(algorithms) / sizeof(*algorithms))
+				usage();
+			algorithm = algorithms[i].algorithm;
+			break;
+		case 'C':
+			compact = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	argv += optind;
+	argc -= optind;
+
+	if (compact) {
+		if (argc != 1)
+			usage();
+		if (libsha2_cache_compact(*argv)) {
+			fprintf(stderr, "%s: %s: %s\n", argv0, *argv, strerror(errno));
+			return 1;
+		}
+		return 0;
+	}
+
+	if (argc < 2)
+		usage();
+	if (libsha2_cache_open(&cache, *argv)) {
+		fprintf(stderr, "%s: %s: %s\n", argv0, *argv, strerror(errno));
+		return 1;
+	}
+
+	for (argv++; *argv; argv++) {
+		fd = open(*argv, O_RDONLY | O_CLOEXEC);
+		if (fd < 0 || libsha2_cache_sum_fd(&cache, fd, algorithm, hashsum)) {
+			fprintf(stderr, "%s: %s: %s\n", argv0, *argv, strerror(errno));
+			if (fd >= 0)
+				close(fd);
+			ret = 1;
+			continue;
+		}
+		close(fd);
+		libsha2_behex_lower(hex, hashsum, libsha2_algorithm_output_size(algorithm));
+		printf("%s  %s\n", hex, *argv);
+	}
+	libsha2_cache_close(&cache);
+
+	if (fflush(stdout) || ferror(stdout)) {
+		fprintf(stderr, "%s: <stdout>: %s\n", argv0, strerror(errno));
+		return 1;
+	}
+	return ret;
+}
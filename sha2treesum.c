@@ -0,0 +1,87 @@
+/* See LICENSE file for copyright and license details. */
+#include "libsha2.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static const struct {
+	const char *name;
+	enum libsha2_algorithm algorithm;
+} algorithms[] = {
+	{"224", LIBSHA2_224},
+	{"256", LIBSHA2_256},
+	{"384", LIBSHA2_384},
+	{"512", LIBSHA2_512},
+	{"512/224", LIBSHA2_512_224},
+	{"512/256", LIBSHA2_512_256}
+};
+
+static const char *argv0 = "sha2treesum";
+
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: %s [-a algorithm] [-j threads] directory ...\n", argv0);
+	exit(2);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+	enum libsha2_algorithm algorithm = LIBSHA2_256;
+	unsigned char hashsum[64];
+	char hex[129];
+	size_t i, threads = 0;
+	char *end;
+	int c, ret = 0;
+
+	if (argc && *argv)
+		argv0 = *argv;
+
+	while ((c = getopt(argc, argv, "a:j:")) != -1) {
+		switch (c) {
+		case 'a':
+			for (i = 0; i < sizeof(algorithms) / sizeof(*algorithms); i++)
+				if (!strcmp(optarg, algorithms[i].name))
+					break;
+			if (i == sizeof(algorithms) / sizeof(*algorithms))
+				usage();
+			algorithm = algorithms[i].algorithm;
+			break;
+		case 'j':
+			errno = 0;
+			threads = (size_t)strtoul(optarg, &end, 10);
+			if (errno || !*optarg || *end || !threads)
+				usage();
+			break;
+		default:
+			usage();
+		}
+	}
+	argv += optind;
+	argc -= optind;
+	if (!argc)
+		usage();
+
+	for (; *argv; argv++) {
+		if (libsha2_sum_tree(*argv, algorithm, hashsum, threads)) {
+			fprintf(stderr, "%s: %s: %s\n", argv0, *argv, strerror(errno));
+			ret = 1;
+			continue;
+		}
+		libsha2_behex_lower(hex, hashsum, libsha2_algorithm_output_size(algorithm));
+		printf("%s  %s\n", hex, *argv);
+	}
+
+	if (fflush(stdout) || ferror(stdout)) {
+		fprintf(stderr, "%s: <stdout>: %s\n", argv0, strerror(errno));
+		return 1;
+	}
+	return ret;
+}
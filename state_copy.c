@@ -0,0 +1,13 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_state_copy(struct libsha2_state *restrict dest, const struct libsha2_state *restrict src)
+{
+	dest->h = src->h;
+	dest->message_size = src->message_size;
+	dest->chunk_size = src->chunk_size;
+	dest->algorithm = src->algorithm;
+	memcpy(dest->chunk, src->chunk, (src->message_size / 8) % src->chunk_size);
+}
@@ -0,0 +1,40 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_store_hash(void *output_, const void *h, enum libsha2_algorithm algorithm)
+{
+	unsigned char *output = output_;
+	const uint_least32_t *h32 = h;
+	const uint_least64_t *h64 = h;
+	size_t i, n;
+
+	n = libsha2_algorithm_output_size(algorithm);
+	if (algorithm <= LIBSHA2_256) {
+		for (i = 0; i < n / 4; i++, output += 4) {
+			output[0] = (unsigned char)(h32[i] >> 24);
+			output[1] = (unsigned char)(h32[i] >> 16);
+			output[2] = (unsigned char)(h32[i] >>  8);
+			output[3] = (unsigned char)(h32[i] >>  0);
+		}
+	} else {
+		for (i = 0; i < n / 8; i++, output += 8) {
+			output[0] = (unsigned char)(h64[i] >> 56);
+			output[1] = (unsigned char)(h64[i] >> 48);
+			output[2] = (unsigned char)(h64[i] >> 40);
+			output[3] = (unsigned char)(h64[i] >> 32);
+			output[4] = (unsigned char)(h64[i] >> 24);
+			output[5] = (unsigned char)(h64[i] >> 16);
+			output[6] = (unsigned char)(h64[i] >>  8);
+			output[7] = (unsigned char)(h64[i] >>  0);
+		}
+		/* SHA-512/224 ends with half a word */
+		if (n % 8) {
+			output[0] = (unsigned char)(h64[i] >> 56);
+			output[1] = (unsigned char)(h64[i] >> 48);
+			output[2] = (unsigned char)(h64[i] >> 40);
+			output[3] = (unsigned char)(h64[i] >> 32);
+		}
+	}
+}
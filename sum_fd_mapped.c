@@ -0,0 +1,20 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_sum_fd_mapped(int fd, enum libsha2_algorithm algorithm, void *restrict hashsum, int flags)
+{
+	struct libsha2_state state;
+
+	if (flags & ~(LIBSHA2_MAP_POPULATE | LIBSHA2_MAP_HUGEPAGE)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (libsha2_init(&state, algorithm) < 0)
+		return -1;
+	if (libsha2_update_fd(&state, fd, flags | LIBSHA2_MAP))
+		return -1;
+	libsha2_digest(&state, NULL, 0, hashsum);
+	return 0;
+}
@@ -0,0 +1,187 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/mman.h>
+
+
+/**
+ * The maximum number of bytes read into memory at a time
+ */
+#define WINDOW_MAX ((size_t)256 << 20)
+
+
+/**
+ * Hash pieces that have been read, after checking
+ * that there is room for their hashes
+ * 
+ * @param   data        The pieces
+ * @param   len         The length of `data`
+ * @param   piece_size  The size of each piece
+ * @param   algorithm   The hashing algorithm
+ * @param   hashsums    Output buffer for the hashes of all pieces
+ * @param   count       The number of pieces hashed so far, will be updated
+ * @param   max         The number of pieces `hashsums` has room for
+ * @param   whole       The hashing state for the whole file, or `NULL`
+ * @param   threads     The number of threads
+ * @return              Zero on success, -1 on error
+ */
+static int
+hash_window(const void *data, size_t len, size_t piece_size, enum libsha2_algorithm algorithm,
+            unsigned char *hashsums, size_t *count, size_t max, struct libsha2_state *whole, size_t threads)
+{
+	size_t n = len / piece_size + !!(len % piece_size);
+
+	if (n > max - *count) {
+		errno = ERANGE;
+		return -1;
+	}
+	libsha2_hash_pieces(data, len, piece_size, algorithm,
+	                    &hashsums[*count * libsha2_algorithm_output_size(algorithm)], whole, threads);
+	*count += n;
+	return 0;
+}
+
+
+/**
+ * Hash the rest of a regular file, mapping it into
+ * memory a window at a time, rather than reading it
+ * 
+ * If a window cannot be mapped, hashing stops at the
+ * beginning of the window, and the rest of the file
+ * is left to be read instead
+ * 
+ * @param   fd          The file descriptor of the file
+ * @param   size        The size of the file
+ * @param   window      The size of each window, a multiple of the piece size
+ * @param   piece_size  The size of each piece
+ * @param   algorithm   The hashing algorithm
+ * @param   hashsums    Output buffer for the hashes of all pieces
+ * @param   count       The number of pieces hashed so far, will be updated
+ * @param   max         The number of pieces `hashsums` has room for
+ * @param   whole       The hashing state for the whole file, or `NULL`
+ * @param   threads     The number of threads
+ * @param   flags       Bitwise OR of `LIBSHA2_MAP_POPULATE`
+ *                      and `LIBSHA2_MAP_HUGEPAGE`, or 0
+ * @return              1 if the whole file was hashed, 0 if the
+ *                      rest shall be read, -1 on error
+ */
+static int
+sum_mapped(int fd, off_t size, size_t window, size_t piece_size, enum libsha2_algorithm algorithm,
+           unsigned char *hashsums, size_t *count, size_t max, struct libsha2_state *whole, size_t threads, int flags)
+{
+	off_t pos, start;
+	size_t len, skip, page;
+	long int r;
+	char *map;
+
+	pos = lseek(fd, 0, SEEK_CUR);
+	if (pos < 0)
+		return 0;
+
+	r = sysconf(_SC_PAGESIZE);
+	page = r > 0 ? (size_t)r : 4096;
+
+	while (pos < size) {
+		skip = (size_t)(pos % (off_t)page);
+		start = pos - (off_t)skip;
+		len = (uintmax_t)(size - pos) < window ? (size_t)(size - pos) : window;
+#ifdef MAP_POPULATE
+		map = mmap(NULL, len + skip, PROT_READ, MAP_PRIVATE | ((flags & LIBSHA2_MAP_POPULATE) ? MAP_POPULATE : 0),
+		           fd, start);
+#else
+		map = mmap(NULL, len + skip, PROT_READ, MAP_PRIVATE, fd, start);
+#endif
+		if (map == MAP_FAILED)
+			return lseek(fd, pos, SEEK_SET) < 0 ? -1 : 0;
+		madvise(map, len + skip, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+		if (flags & LIBSHA2_MAP_HUGEPAGE)
+			madvise(map, len + skip, MADV_HUGEPAGE);
+#endif
+		r = hash_window(&map[skip], len, piece_size, algorithm, hashsums, count, max, whole, threads);
+		munmap(map, len + skip);
+		if (r)
+			return -1;
+		pos += (off_t)len;
+	}
+
+	/* Anything appended since fstat(3) is not hashed, as the
+	 * last piece has already been hashed if it is partial */
+	return lseek(fd, pos, SEEK_SET) < 0 ? -1 : 1;
+}
+
+
+int
+libsha2_sum_fd_pieces(int fd, enum libsha2_algorithm algorithm, size_t piece_size, void *hashsums,
+                      size_t *npieces, void *hashsum, size_t threads, int flags)
+{
+	struct libsha2_state whole, *wholep;
+	struct stat attr;
+	size_t window, len, max = *npieces, count = 0;
+	unsigned char *buf;
+	ssize_t r;
+	int ret, saved_errno;
+
+	if (libsha2_init(&whole, algorithm))
+		return -1;
+	if (!piece_size || piece_size > SIZE_MAX / 8 ||
+	    (flags & ~(LIBSHA2_MAP | LIBSHA2_MAP_POPULATE | LIBSHA2_MAP_HUGEPAGE))) {
+		errno = EINVAL;
+		return -1;
+	}
+	wholep = hashsum ? &whole : NULL;
+
+	threads = libsha2_thread_count(threads);
+
+	/* Each window has enough pieces to keep every lane of every
+	 * thread busy, but no more than fits in `WINDOW_MAX` bytes */
+	window = threads * libsha2_pieces_group(algorithm);
+	if (window > WINDOW_MAX / piece_size)
+		window = WINDOW_MAX / piece_size;
+	window = (window ? window : 1) * piece_size;
+
+	if (fstat(fd, &attr))
+		return -1;
+	if ((flags & LIBSHA2_MAP) && S_ISREG(attr.st_mode)) {
+		ret = sum_mapped(fd, attr.st_size, window, piece_size, algorithm,
+		                 hashsums, &count, max, wholep, threads, flags);
+		if (ret < 0)
+			return -1;
+		if (ret)
+			goto done;
+	}
+
+	buf = malloc(window);
+	if (!buf)
+		return -1;
+	for (;;) {
+		for (len = 0; len < window; len += (size_t)r) {
+			r = read(fd, &buf[len], window - len);
+			if (r <= 0) {
+				if (!r)
+					break;
+				if (errno == EINTR) {
+					r = 0;
+					continue;
+				}
+				goto fail;
+			}
+		}
+		if (len && hash_window(buf, len, piece_size, algorithm, hashsums, &count, max, wholep, threads))
+			goto fail;
+		if (len < window)
+			break;
+	}
+	free(buf);
+
+done:
+	if (hashsum)
+		libsha2_digest(&whole, NULL, 0, hashsum);
+	*npieces = count;
+	return 0;
+
+fail:
+	saved_errno = errno;
+	free(buf);
+	errno = saved_errno;
+	return -1;
+}
@@ -0,0 +1,497 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#ifdef HAVE_LINUX_IO_URING
+# include <sys/syscall.h>
+# include <sys/uio.h>
+# include <linux/io_uring.h>
+#endif
+
+
+/**
+ * The default number of buffers
+ */
+#define DEFAULT_DEPTH 4
+
+/**
+ * The default size of each buffer
+ */
+#define DEFAULT_BUFSIZE ((size_t)1 << 20)
+
+/**
+ * The alignment of the buffers, their sizes and the
+ * file offsets, enough for files opened with `O_DIRECT`
+ */
+#define ALIGNMENT ((size_t)4096)
+
+
+/**
+ * A pipelined read of a file
+ */
+struct reader {
+	/**
+	 * The file descriptor of the file
+	 */
+	int fd;
+
+	/**
+	 * Whether the file is a regular file
+	 */
+	int regular;
+
+	/**
+	 * The size of the file, if it is a regular file
+	 */
+	off_t size;
+
+	/**
+	 * The number of buffers
+	 */
+	size_t depth;
+
+	/**
+	 * The size of each buffer
+	 */
+	size_t bufsize;
+
+	/**
+	 * The buffers, one after another
+	 */
+	unsigned char *buffers;
+
+	/**
+	 * The file offset each buffer is read from
+	 */
+	off_t *offsets;
+
+	/**
+	 * The number of bytes read into each buffer so far
+	 */
+	size_t *got;
+
+	/**
+	 * Whether each buffer is ready to be hashed
+	 */
+	unsigned char *done;
+
+	/**
+	 * Whether reads into the buffers may still be pending,
+	 * in which case the buffers must never be freed
+	 */
+	int pinned;
+};
+
+
+#ifdef HAVE_LINUX_IO_URING
+/**
+ * An io_uring instance
+ */
+struct ring {
+	int fd;
+	unsigned int *sq_tail, *sq_mask, *sq_array;
+	unsigned int *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_map, *cq_map;
+	size_t sq_len, cq_len, sqes_len;
+
+	/**
+	 * The number of queued requests that have not been submitted
+	 */
+	unsigned int unsubmitted;
+
+	/**
+	 * The number of submitted requests that have not completed
+	 */
+	size_t inflight;
+
+	/**
+	 * Whether completions shall only be collected,
+	 * not acted upon
+	 */
+	int draining;
+
+	/**
+	 * The I/O vector for each buffer
+	 */
+	struct iovec *iov;
+};
+
+
+/**
+ * Create an io_uring instance
+ * 
+ * @param   ring     Output parameter for the instance
+ * @param   entries  The number of submission queue entries
+ * @return           Zero on success, -1 on error
+ */
+static int
+ring_setup(struct ring *ring, unsigned int entries)
+{
+	struct io_uring_params p;
+	char *sq, *cq;
+
+	memset(&p, 0, sizeof(p));
+	ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+	if (ring->fd < 0)
+		return -1;
+
+	ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_len > ring->sq_len)
+			ring->sq_len = ring->cq_len;
+		ring->cq_len = ring->sq_len;
+	}
+	ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	ring->sq_map = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                    ring->fd, (off_t)IORING_OFF_SQ_RING);
+	if (ring->sq_map == MAP_FAILED)
+		goto fail_fd;
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_map = ring->sq_map;
+	} else {
+		ring->cq_map = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		                    ring->fd, (off_t)IORING_OFF_CQ_RING);
+		if (ring->cq_map == MAP_FAILED)
+			goto fail_sq;
+	}
+	ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                  ring->fd, (off_t)IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+		goto fail_cq;
+
+	sq = ring->sq_map;
+	cq = ring->cq_map;
+	ring->sq_tail  = (unsigned int *)&sq[p.sq_off.tail];
+	ring->sq_mask  = (unsigned int *)&sq[p.sq_off.ring_mask];
+	ring->sq_array = (unsigned int *)&sq[p.sq_off.array];
+	ring->cq_head  = (unsigned int *)&cq[p.cq_off.head];
+	ring->cq_tail  = (unsigned int *)&cq[p.cq_off.tail];
+	ring->cq_mask  = (unsigned int *)&cq[p.cq_off.ring_mask];
+	ring->cqes     = (struct io_uring_cqe *)&cq[p.cq_off.cqes];
+	ring->unsubmitted = 0;
+	ring->inflight = 0;
+	ring->draining = 0;
+	return 0;
+
+fail_cq:
+	if (ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_len);
+fail_sq:
+	munmap(ring->sq_map, ring->sq_len);
+fail_fd:
+	close(ring->fd);
+	return -1;
+}
+
+
+/**
+ * Destroy an io_uring instance
+ * 
+ * @param  ring  The instance, with no requests in flight
+ */
+static void
+ring_destroy(struct ring *ring)
+{
+	munmap(ring->sqes, ring->sqes_len);
+	if (ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_len);
+	munmap(ring->sq_map, ring->sq_len);
+	close(ring->fd);
+}
+
+
+/**
+ * Submit queued requests, and optionally wait for a completion
+ * 
+ * @param   ring  The io_uring instance
+ * @param   wait  Whether to wait for a completion
+ * @return        Zero on success, -1 on error
+ */
+static int
+ring_enter(struct ring *ring, int wait)
+{
+	long int r;
+
+	for (;;) {
+		r = syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted, wait ? 1U : 0U,
+		            wait ? IORING_ENTER_GETEVENTS : 0U, NULL, 0);
+		if (r >= 0) {
+			ring->unsubmitted -= (unsigned int)r;
+			ring->inflight += (size_t)r;
+			return 0;
+		}
+		if (errno != EINTR)
+			return -1;
+	}
+}
+
+
+/**
+ * Queue a read of the rest of a buffer
+ * 
+ * @param  ring    The io_uring instance
+ * @param  reader  The pipelined read
+ * @param  i       The index of the buffer
+ */
+static void
+ring_queue_read(struct ring *ring, struct reader *reader, size_t i)
+{
+	unsigned int tail = *ring->sq_tail;
+	unsigned int index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+
+	ring->iov[i].iov_base = &reader->buffers[i * reader->bufsize + reader->got[i]];
+	ring->iov[i].iov_len = reader->bufsize - reader->got[i];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = reader->fd;
+	sqe->off = (uint64_t)reader->offsets[i] + reader->got[i];
+	sqe->addr = (uint64_t)(uintptr_t)&ring->iov[i];
+	sqe->len = 1;
+	sqe->user_data = (uint64_t)i;
+
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->unsubmitted += 1;
+}
+
+
+/**
+ * Wait for a completion, and record it
+ * 
+ * @param   ring    The io_uring instance
+ * @param   reader  The pipelined read
+ * @return          Zero on success, -1 on error
+ */
+static int
+ring_reap(struct ring *ring, struct reader *reader)
+{
+	unsigned int head = *ring->cq_head;
+	struct io_uring_cqe *cqe;
+	size_t i;
+	int res;
+
+	while (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE))
+		if (ring_enter(ring, 1))
+			return -1;
+
+	cqe = &ring->cqes[head & *ring->cq_mask];
+	i = (size_t)cqe->user_data;
+	res = cqe->res;
+	__atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+	ring->inflight -= 1;
+
+	if (ring->draining)
+		return 0;
+	if (res < 0) {
+		if (res == -EINTR || res == -EAGAIN) {
+			ring_queue_read(ring, reader, i);
+			return ring_enter(ring, 0);
+		}
+		errno = -res;
+		return -1;
+	}
+
+	/* A short read is only the end of the file if nothing
+	 * more is available, for O_DIRECT it has to be the end
+	 * of the file as the remainder would be misaligned */
+	reader->got[i] += (size_t)res;
+	if (!res || reader->got[i] == reader->bufsize ||
+	    (reader->regular && reader->offsets[i] + (off_t)reader->got[i] >= reader->size)) {
+		reader->done[i] = 1;
+		return 0;
+	}
+	ring_queue_read(ring, reader, i);
+	return ring_enter(ring, 0);
+}
+
+
+/**
+ * Hash a file, with all buffers being read while one is hashed
+ * 
+ * @param   state   The hashing state
+ * @param   reader  The pipelined read, with `.offsets[0]` set
+ *                  to the current file offset
+ * @param   end     Output parameter for the file offset the
+ *                  hashing ended at
+ * @return          1 on success, 0 if io_uring is unavailable,
+ *                  -1 on error
+ */
+static int
+sum_ring(struct libsha2_state *restrict state, struct reader *reader, off_t *end)
+{
+	struct ring ring;
+	size_t i, cur;
+	int ret = 1, saved_errno;
+
+	if (ring_setup(&ring, (unsigned int)reader->depth))
+		return 0;
+	ring.iov = malloc(reader->depth * sizeof(*ring.iov));
+	if (!ring.iov) {
+		ring_destroy(&ring);
+		return -1;
+	}
+
+	for (i = 0; i < reader->depth; i++) {
+		reader->offsets[i] = reader->offsets[0] + (off_t)(i * reader->bufsize);
+		reader->got[i] = 0;
+		reader->done[i] = 0;
+		ring_queue_read(&ring, reader, i);
+	}
+	if (ring_enter(&ring, 0))
+		goto fail;
+
+	for (cur = 0;; cur = (cur + 1) % reader->depth) {
+		while (!reader->done[cur])
+			if (ring_reap(&ring, reader))
+				goto fail;
+		libsha2_update(state, &reader->buffers[cur * reader->bufsize], reader->got[cur] * 8);
+		if (reader->got[cur] < reader->bufsize) {
+			*end = reader->offsets[cur] + (off_t)reader->got[cur];
+			break;
+		}
+		reader->offsets[cur] += (off_t)(reader->depth * reader->bufsize);
+		reader->got[cur] = 0;
+		reader->done[cur] = 0;
+		ring_queue_read(&ring, reader, cur);
+		if (ring_enter(&ring, 0))
+			goto fail;
+	}
+
+	/* The buffers must not be freed while the kernel may write to
+	 * them, so if the pending reads cannot be waited for, the
+	 * buffers and the I/O vectors pointing to them are leaked */
+out:
+	saved_errno = errno;
+	ring.draining = 1;
+	while (ring.inflight || ring.unsubmitted) {
+		if (ring_reap(&ring, reader)) {
+			if (errno == EINTR)
+				continue;
+			reader->pinned = 1;
+			break;
+		}
+	}
+	errno = saved_errno;
+	if (!reader->pinned)
+		free(ring.iov);
+	ring_destroy(&ring);
+	return ret;
+
+fail:
+	ret = -1;
+	goto out;
+}
+#endif
+
+
+/**
+ * Hash a file with pread(3), asking the kernel
+ * to read ahead while the buffer is hashed
+ * 
+ * @param   state   The hashing state
+ * @param   reader  The pipelined read, with `.offsets[0]` set
+ *                  to the current file offset
+ * @param   end     Output parameter for the file offset the
+ *                  hashing ended at
+ * @return          Zero on success, -1 on error
+ */
+static int
+sum_pread(struct libsha2_state *restrict state, struct reader *reader, off_t *end)
+{
+	off_t off = reader->offsets[0];
+	size_t ahead = reader->depth * reader->bufsize;
+	ssize_t r;
+
+	for (;;) {
+#ifdef POSIX_FADV_WILLNEED
+		posix_fadvise(reader->fd, off + (off_t)reader->bufsize, (off_t)ahead, POSIX_FADV_WILLNEED);
+#endif
+		r = pread(reader->fd, reader->buffers, reader->bufsize, off);
+		if (r <= 0) {
+			if (!r)
+				break;
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			return -1;
+		}
+		libsha2_update(state, reader->buffers, (size_t)r * 8);
+		off += (off_t)r;
+	}
+
+	*end = off;
+	return 0;
+}
+
+
+int
+libsha2_sum_fd_queued(int fd, enum libsha2_algorithm algorithm, void *restrict hashsum, size_t depth, size_t bufsize)
+{
+	struct libsha2_state state;
+	struct reader reader;
+	struct stat attr;
+	off_t pos, end;
+	int r = 0;
+
+	if (!depth)
+		depth = DEFAULT_DEPTH;
+	if (!bufsize)
+		bufsize = DEFAULT_BUFSIZE;
+	if (depth > 4096 || bufsize > SIZE_MAX / 8 / depth) {
+		errno = EINVAL;
+		return -1;
+	}
+	bufsize += (ALIGNMENT - bufsize % ALIGNMENT) % ALIGNMENT;
+
+	if (libsha2_init(&state, algorithm))
+		return -1;
+
+	/* The reads are made at explicit offsets, which pipes,
+	 * sockets, and terminals do not support */
+	pos = lseek(fd, 0, SEEK_CUR);
+	if (pos < 0 || fstat(fd, &attr))
+		return libsha2_sum_fd(fd, algorithm, hashsum);
+
+	memset(&reader, 0, sizeof(reader));
+	reader.fd = fd;
+	reader.regular = S_ISREG(attr.st_mode);
+	reader.size = attr.st_size;
+	reader.depth = depth;
+	reader.bufsize = bufsize;
+	reader.offsets = malloc(depth * (sizeof(*reader.offsets) + sizeof(*reader.got) + 1));
+	if (!reader.offsets)
+		return -1;
+	reader.got = (size_t *)&reader.offsets[depth];
+	reader.done = (unsigned char *)&reader.got[depth];
+	if ((errno = posix_memalign((void **)&reader.buffers, ALIGNMENT, depth * bufsize))) {
+		free(reader.offsets);
+		return -1;
+	}
+	reader.offsets[0] = pos;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, pos, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+#ifdef HAVE_LINUX_IO_URING
+	r = sum_ring(&state, &reader, &end);
+#endif
+	if (!r)
+		r = sum_pread(&state, &reader, &end) ? -1 : 1;
+
+	if (!reader.pinned)
+		free(reader.buffers);
+	free(reader.offsets);
+	if (r < 0)
+		return -1;
+
+	if (lseek(fd, end, SEEK_SET) < 0)
+		return -1;
+	libsha2_digest(&state, NULL, 0, hashsum);
+	return 0;
+}
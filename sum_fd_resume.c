@@ -0,0 +1,51 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_sum_fd_resume(int fd, enum libsha2_algorithm algorithm, void *restrict hashsum,
+                      void *restrict checkpoint, size_t *restrict checkpoint_size, off_t *restrict offset)
+{
+	struct libsha2_state state;
+	struct stat attr;
+	off_t end;
+
+	/* The checkpoint must cover exactly the bytes before
+	 * *offset, otherwise the digest would be of some other
+	 * content than the file's */
+	if (!*checkpoint_size) {
+		if (*offset) {
+			errno = EINVAL;
+			return -1;
+		}
+		if (libsha2_init(&state, algorithm) < 0)
+			return -1;
+	} else if (!libsha2_unmarshal(&state, checkpoint, *checkpoint_size)) {
+		return -1;
+	} else if (state.algorithm != algorithm || state.message_size != (size_t)*offset * 8) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* If the file has been truncated, it has been rewritten
+	 * rather than appended to, and the checkpoint is useless */
+	if (fstat(fd, &attr))
+		return -1;
+	if (S_ISREG(attr.st_mode) && attr.st_size < *offset) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (lseek(fd, *offset, SEEK_SET) < 0 || libsha2_update_fd(&state, fd, 0))
+		return -1;
+	end = lseek(fd, 0, SEEK_CUR);
+	if (end < 0)
+		return -1;
+
+	/* libsha2_digest(3) finalises the state, so the
+	 * checkpoint must be taken before the digest */
+	*checkpoint_size = libsha2_marshal(&state, checkpoint);
+	*offset = end;
+	libsha2_digest(&state, NULL, 0, hashsum);
+	return 0;
+}
@@ -0,0 +1,9 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_sum_fds(const int *fds, size_t n, enum libsha2_algorithm algorithm, void *hashsums, int *errors, size_t threads)
+{
+	return libsha2_sum_files(fds, NULL, n, algorithm, hashsums, errors, threads, 0);
+}
@@ -0,0 +1,353 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+
+/**
+ * Files with at most this many bytes left are read
+ * whole and hashed in batches with other small files
+ */
+#define SMALL_MAX ((size_t)16 << 10)
+
+/**
+ * The number of small files each worker hashes at a time
+ */
+#define BATCH 16
+
+
+/**
+ * The work shared by the workers
+ */
+struct pool {
+	/**
+	 * The file descriptors of the files, or `NULL`
+	 */
+	const int *fds;
+
+	/**
+	 * The paths of the files, used if `.fds` is `NULL`
+	 */
+	const char *const *paths;
+
+	/**
+	 * Additional flags to open the files in `.paths` with
+	 */
+	int oflags;
+
+	/**
+	 * The number of files
+	 */
+	size_t n;
+
+	/**
+	 * The hashing algorithm
+	 */
+	enum libsha2_algorithm algorithm;
+
+	/**
+	 * The size of each hash
+	 */
+	size_t outsize;
+
+	/**
+	 * Output buffer for the hashes
+	 */
+	unsigned char *hashsums;
+
+	/**
+	 * Output buffer for the error of each file, or `NULL`
+	 */
+	int *errors;
+
+	/**
+	 * The index of the next file to claim
+	 */
+	atomic_size_t next;
+
+	/**
+	 * Lock for `.error` and `.error_index`
+	 */
+	pthread_mutex_t lock;
+
+	/**
+	 * The error of the file with the lowest index that failed
+	 */
+	int error;
+
+	/**
+	 * The lowest index of a file that failed, or `.n`
+	 */
+	size_t error_index;
+};
+
+/**
+ * Small files read by a worker and not yet hashed
+ */
+struct batch {
+	/**
+	 * The number of files in the batch
+	 */
+	size_t n;
+
+	/**
+	 * The index of each file
+	 */
+	size_t index[BATCH];
+
+	/**
+	 * The messages, as pointers into `.data`
+	 */
+	const void *messages[BATCH];
+
+	/**
+	 * The length of each message, in bits
+	 */
+	size_t msglens[BATCH];
+
+	/**
+	 * The hashes of the messages
+	 */
+	unsigned char outputs[BATCH * 64];
+
+	/**
+	 * The content of the files
+	 */
+	unsigned char data[BATCH][SMALL_MAX];
+};
+
+
+/**
+ * Record the error of a file
+ * 
+ * @param  pool   The work
+ * @param  i      The index of the file
+ * @param  error  The error, `errno` value
+ */
+static void
+fail(struct pool *pool, size_t i, int error)
+{
+	if (pool->errors)
+		pool->errors[i] = error;
+	pthread_mutex_lock(&pool->lock);
+	if (i < pool->error_index) {
+		pool->error_index = i;
+		pool->error = error;
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+
+/**
+ * Hash the small files in a batch and empty the batch
+ * 
+ * @param  pool   The work
+ * @param  batch  The batch
+ */
+static void
+flush(struct pool *pool, struct batch *batch)
+{
+	size_t j;
+
+	if (!batch->n)
+		return;
+	libsha2_digest_many(pool->algorithm, batch->messages, batch->msglens, batch->n, batch->outputs);
+	for (j = 0; j < batch->n; j++)
+		memcpy(&pool->hashsums[batch->index[j] * pool->outsize], &batch->outputs[j * pool->outsize], pool->outsize);
+	batch->n = 0;
+}
+
+
+/**
+ * Read the rest of a file into a buffer, unless
+ * the file is larger than the buffer
+ * 
+ * @param   fd   The file descriptor of the file
+ * @param   buf  Output buffer, `SMALL_MAX` bytes large
+ * @param   len  Output parameter for the number of bytes read
+ * @return       1 if the rest of the file was read, 0 if it
+ *               did not fit, -1 on error
+ */
+static int
+read_small(int fd, unsigned char *buf, size_t *len)
+{
+	ssize_t r;
+
+	for (*len = 0; *len < SMALL_MAX; *len += (size_t)r) {
+		r = read(fd, &buf[*len], SMALL_MAX - *len);
+		if (r <= 0) {
+			if (!r)
+				return 1;
+			if (errno == EINTR) {
+				r = 0;
+				continue;
+			}
+			return -1;
+		}
+	}
+
+	/* The file has grown since fstat(3) */
+	return 0;
+}
+
+
+/**
+ * Hash the rest of a file, of which the first part has been read
+ * 
+ * @param   pool  The work
+ * @param   fd    The file descriptor of the file
+ * @param   buf   The part that has already been read, used as
+ *                a buffer, `SMALL_MAX` bytes large
+ * @param   len   The length of the part that has been read
+ * @param   out   Output buffer for the hash
+ * @return        Zero on success, -1 on error
+ */
+static int
+sum_rest(struct pool *pool, int fd, unsigned char *buf, size_t len, unsigned char *out)
+{
+	struct libsha2_state state;
+	ssize_t r;
+
+	libsha2_init(&state, pool->algorithm);
+	libsha2_update(&state, buf, len * 8);
+	for (;;) {
+		r = read(fd, buf, SMALL_MAX);
+		if (r <= 0) {
+			if (!r)
+				break;
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		libsha2_update(&state, buf, (size_t)r * 8);
+	}
+	libsha2_digest(&state, NULL, 0, out);
+	return 0;
+}
+
+
+/**
+ * Hash a file, or add it to the batch of small files
+ * 
+ * @param   pool   The work
+ * @param   batch  The worker's batch of small files
+ * @param   i      The index of the file
+ * @param   fd     The file descriptor of the file
+ * @return         Zero on success, -1 on error
+ */
+static int
+sum_one(struct pool *pool, struct batch *batch, size_t i, int fd)
+{
+	unsigned char *out = &pool->hashsums[i * pool->outsize];
+	unsigned char *buf;
+	struct stat attr;
+	off_t pos;
+	size_t len;
+	int r;
+
+	if (fstat(fd, &attr))
+		return -1;
+	if (!S_ISREG(attr.st_mode))
+		return libsha2_sum_fd(fd, pool->algorithm, out);
+	pos = pool->paths ? 0 : lseek(fd, 0, SEEK_CUR);
+	if (pos < 0 || attr.st_size - pos > (off_t)SMALL_MAX)
+		return libsha2_sum_fd(fd, pool->algorithm, out);
+
+	buf = batch->data[batch->n];
+	r = read_small(fd, buf, &len);
+	if (r < 0)
+		return -1;
+	if (!r)
+		return sum_rest(pool, fd, buf, len, out);
+
+	batch->index[batch->n] = i;
+	batch->messages[batch->n] = buf;
+	batch->msglens[batch->n] = len * 8;
+	if (++batch->n == BATCH)
+		flush(pool, batch);
+	return 0;
+}
+
+
+/**
+ * Claim and hash files until there are none left
+ * 
+ * @param   pool_  The work, `struct pool *`
+ * @return         `NULL`
+ */
+static void *
+worker(void *pool_)
+{
+	struct pool *pool = pool_;
+	struct batch *batch;
+	size_t i;
+	int fd, r, saved_errno;
+
+	batch = malloc(sizeof(*batch));
+	if (batch)
+		batch->n = 0;
+
+	while ((i = atomic_fetch_add(&pool->next, 1)) < pool->n) {
+		if (!pool->paths) {
+			fd = pool->fds[i];
+		} else {
+			fd = open(pool->paths[i], O_RDONLY | O_CLOEXEC | pool->oflags);
+			if (fd < 0) {
+				fail(pool, i, errno);
+				continue;
+			}
+		}
+		if (batch)
+			r = sum_one(pool, batch, i, fd);
+		else
+			r = libsha2_sum_fd(fd, pool->algorithm, &pool->hashsums[i * pool->outsize]);
+		saved_errno = errno;
+		if (pool->paths)
+			close(fd);
+		if (r)
+			fail(pool, i, saved_errno);
+		else if (pool->errors)
+			pool->errors[i] = 0;
+	}
+
+	if (batch) {
+		flush(pool, batch);
+		free(batch);
+	}
+	return NULL;
+}
+
+
+int
+libsha2_sum_files(const int *fds, const char *const *paths, size_t n, enum libsha2_algorithm algorithm,
+                  void *hashsums, int *errors, size_t threads, int oflags)
+{
+	struct pool pool;
+
+	pool.outsize = libsha2_algorithm_output_size(algorithm);
+	if (!pool.outsize)
+		return -1;
+
+	pool.fds = fds;
+	pool.paths = paths;
+	pool.oflags = oflags;
+	pool.n = n;
+	pool.algorithm = algorithm;
+	pool.hashsums = hashsums;
+	pool.errors = errors;
+	atomic_init(&pool.next, 0);
+	pool.error = 0;
+	pool.error_index = n;
+	if ((errno = pthread_mutex_init(&pool.lock, NULL)))
+		return -1;
+
+	libsha2_run_workers(&worker, &pool, threads, n);
+	pthread_mutex_destroy(&pool.lock);
+
+	if (pool.error_index < n) {
+		errno = pool.error;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,10 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_sum_paths(const char *const *paths, size_t n, enum libsha2_algorithm algorithm, void *hashsums,
+                  int *errors, size_t threads)
+{
+	return libsha2_sum_files(NULL, paths, n, algorithm, hashsums, errors, threads, 0);
+}
@@ -0,0 +1,321 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <dirent.h>
+#include <fcntl.h>
+
+
+/**
+ * An entry in the tree
+ */
+struct entry {
+	/**
+	 * The path of the entry, starting with the root's path
+	 */
+	char *path;
+
+	/**
+	 * The target of the entry if it is a symbolic link, otherwise `NULL`
+	 */
+	char *target;
+
+	/**
+	 * The length of `.target`
+	 */
+	size_t target_len;
+
+	/**
+	 * The index of the entry among the regular
+	 * files, if it is a regular file
+	 */
+	size_t file;
+
+	/**
+	 * The entry's permission bits
+	 */
+	uint_least32_t mode;
+
+	/**
+	 * The type of the entry: 'd', 'f', 'l', 'b',
+	 * 'c', 'p', or 's'
+	 */
+	char type;
+};
+
+/**
+ * The entries found so far, in the order they are hashed
+ */
+struct walk {
+	/**
+	 * The entries
+	 */
+	struct entry *entries;
+
+	/**
+	 * The number of entries
+	 */
+	size_t n;
+
+	/**
+	 * The allocated size of `.entries`
+	 */
+	size_t size;
+
+	/**
+	 * The number of regular files
+	 */
+	size_t files;
+};
+
+
+/**
+ * Compare two strings, for qsort(3)
+ * 
+ * @param   a  Pointer to one of the strings
+ * @param   b  Pointer to the other string
+ * @return     Negative if `a` sorts first, positive if `b` does
+ */
+static int
+cmpstrp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+
+/**
+ * Read the target of a symbolic link
+ * 
+ * @param   path  The path of the symbolic link
+ * @param   size  The size of the link, as reported by lstat(3)
+ * @param   lenp  Output parameter for the length of the target
+ * @return        The target, `NULL` on error
+ */
+static char *
+read_link(const char *path, size_t size, size_t *lenp)
+{
+	char *target = NULL, *new;
+	ssize_t r;
+
+	for (size = size ? size + 1 : 256;; size *= 2) {
+		new = realloc(target, size);
+		if (!new) {
+			free(target);
+			return NULL;
+		}
+		target = new;
+		r = readlink(path, target, size);
+		if (r < 0) {
+			free(target);
+			return NULL;
+		}
+		if ((size_t)r < size) {
+			*lenp = (size_t)r;
+			return target;
+		}
+	}
+}
+
+
+/**
+ * Add an entry and, if it is a directory, its descendants
+ * 
+ * @param   walk  The entries found so far
+ * @param   path  The path of the entry, will be freed
+ * @return        Zero on success, -1 on error
+ */
+static int
+add(struct walk *walk, char *path)
+{
+	struct stat attr;
+	struct entry *e;
+	DIR *dir;
+	struct dirent *f;
+	char **names = NULL, **new_names;
+	size_t i, n = 0, size = 0, len;
+	int saved_errno;
+
+	if (lstat(path, &attr))
+		goto fail;
+
+	if (walk->n == walk->size) {
+		size = walk->size ? walk->size * 2 : 64;
+		e = realloc(walk->entries, size * sizeof(*walk->entries));
+		if (!e)
+			goto fail;
+		walk->entries = e;
+		walk->size = size;
+		size = 0;
+	}
+	e = &walk->entries[walk->n];
+	e->path = path;
+	e->target = NULL;
+	e->mode = (uint_least32_t)(attr.st_mode & 07777);
+
+	if (S_ISREG(attr.st_mode)) {
+		e->type = 'f';
+		e->file = walk->files++;
+	} else if (S_ISLNK(attr.st_mode)) {
+		e->type = 'l';
+		e->target = read_link(path, (size_t)attr.st_size, &e->target_len);
+		if (!e->target)
+			goto fail;
+	} else if (S_ISDIR(attr.st_mode)) {
+		e->type = 'd';
+	} else if (S_ISBLK(attr.st_mode)) {
+		e->type = 'b';
+	} else if (S_ISCHR(attr.st_mode)) {
+		e->type = 'c';
+	} else if (S_ISFIFO(attr.st_mode)) {
+		e->type = 'p';
+	} else {
+		e->type = 's';
+	}
+	walk->n++;
+
+	if (e->type != 'd')
+		return 0;
+
+	dir = opendir(path);
+	if (!dir)
+		return -1;
+	len = strlen(path);
+	while ((errno = 0, f = readdir(dir))) {
+		if (f->d_name[0] == '.' && (!f->d_name[1] || (f->d_name[1] == '.' && !f->d_name[2])))
+			continue;
+		if (n == size) {
+			size = size ? size * 2 : 16;
+			new_names = realloc(names, size * sizeof(*names));
+			if (!new_names)
+				goto fail_dir;
+			names = new_names;
+		}
+		names[n] = malloc(len + strlen(f->d_name) + 2);
+		if (!names[n])
+			goto fail_dir;
+		stpcpy(stpcpy(stpcpy(names[n], path), "/"), f->d_name);
+		n++;
+	}
+	if (errno)
+		goto fail_dir;
+	closedir(dir);
+
+	/* Every name has the same prefix, so the
+	 * paths sort in the order of the names */
+	if (n)
+		qsort(names, n, sizeof(*names), cmpstrp);
+	for (i = 0; i < n; i++) {
+		if (add(walk, names[i])) {
+			saved_errno = errno;
+			while (++i < n)
+				free(names[i]);
+			free(names);
+			errno = saved_errno;
+			return -1;
+		}
+	}
+	free(names);
+	return 0;
+
+fail_dir:
+	saved_errno = errno;
+	closedir(dir);
+	while (n--)
+		free(names[n]);
+	free(names);
+	errno = saved_errno;
+	return -1;
+
+fail:
+	saved_errno = errno;
+	free(path);
+	errno = saved_errno;
+	return -1;
+}
+
+
+/**
+ * Feed an integer into a hashing state, as 8 bytes, most significant first
+ * 
+ * @param  state  The hashing state
+ * @param  value  The integer
+ */
+static void
+add_number(struct libsha2_state *restrict state, uint_least64_t value)
+{
+	unsigned char buf[8];
+	int i;
+
+	for (i = 7; i >= 0; i--, value >>= 8)
+		buf[i] = (unsigned char)(value & 255);
+	libsha2_update(state, buf, sizeof(buf) * 8);
+}
+
+
+int
+libsha2_sum_tree(const char *path, enum libsha2_algorithm algorithm, void *hashsum, size_t threads)
+{
+	struct libsha2_state state;
+	struct walk walk = {NULL, 0, 0, 0};
+	const char **paths = NULL;
+	unsigned char *sums = NULL;
+	size_t i, j, outsize, rootlen, len;
+	char *root;
+	int ret = -1, saved_errno;
+
+	if (libsha2_init(&state, algorithm))
+		return -1;
+	outsize = libsha2_algorithm_output_size(algorithm);
+
+	rootlen = strlen(path);
+	root = malloc(rootlen + 1);
+	if (!root)
+		return -1;
+	memcpy(root, path, rootlen + 1);
+	if (add(&walk, root))
+		goto out;
+
+	/* Files are hashed in parallel, after the walk, so the
+	 * order they finish in does not affect the result; they
+	 * are reopened without following symbolic links, so an
+	 * entry replaced by a link since the walk is not followed */
+	if (walk.files) {
+		paths = malloc(walk.files * sizeof(*paths));
+		sums = malloc(walk.files * outsize);
+		if (!paths || !sums)
+			goto out;
+		for (i = 0; i < walk.n; i++)
+			if (walk.entries[i].type == 'f')
+				paths[walk.entries[i].file] = walk.entries[i].path;
+		if (libsha2_sum_files(NULL, paths, walk.files, algorithm, sums, NULL, threads, O_NOFOLLOW))
+			goto out;
+	}
+
+	libsha2_update(&state, "libsha2-tree-1", sizeof("libsha2-tree-1") * 8);
+	for (i = 0; i < walk.n; i++) {
+		len = strlen(walk.entries[i].path);
+		len = len > rootlen ? len - rootlen - 1 : 0;
+		libsha2_update(&state, &walk.entries[i].type, 8);
+		add_number(&state, walk.entries[i].mode);
+		add_number(&state, len);
+		libsha2_update(&state, &walk.entries[i].path[rootlen + !!len], len * 8);
+		if (walk.entries[i].type == 'f') {
+			libsha2_update(&state, &sums[walk.entries[i].file * outsize], outsize * 8);
+		} else if (walk.entries[i].type == 'l') {
+			add_number(&state, walk.entries[i].target_len);
+			libsha2_update(&state, walk.entries[i].target, walk.entries[i].target_len * 8);
+		}
+	}
+	libsha2_digest(&state, NULL, 0, hashsum);
+	ret = 0;
+
+out:
+	saved_errno = errno;
+	for (j = 0; j < walk.n; j++) {
+		free(walk.entries[j].path);
+		free(walk.entries[j].target);
+	}
+	free(walk.entries);
+	free(paths);
+	free(sums);
+	errno = saved_errno;
+	return ret;
+}
@@ -1,8 +1,10 @@
 /* See LICENSE file for copyright and license details. */
 #include "libsha2.h"
 
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -88,27 +90,126 @@
 		test_str(str, EXPECTED);\
 	} while (0)
 
+#define test_pbkdf2(ALGO, PASS, SALT, C, DK)\
+	do {\
+		test(!libsha2_pbkdf2(ALGO, PASS, sizeof(PASS) - 1, SALT, sizeof(SALT) - 1, C, buf, (sizeof(DK) - 1) / 2));\
+		libsha2_behex_lower(str, buf, (sizeof(DK) - 1) / 2);\
+		test_str(str, DK);\
+	} while (0)
+
+#define test_hkdf(ALGO, IKM, SALT, INFO, PRK, OKM)\
+	do {\
+		libsha2_unhex(buf, IKM);\
+		libsha2_unhex(&buf[1024], SALT);\
+		libsha2_unhex(&buf[2048], INFO);\
+		test(!libsha2_hkdf_extract(&hk, ALGO, &buf[1024], (sizeof(SALT) - 1) / 2,\
+		                           buf, (sizeof(IKM) - 1) / 2, &buf[3072]));\
+		libsha2_behex_lower(str, &buf[3072], (sizeof(PRK) - 1) / 2);\
+		test_str(str, PRK);\
+		test(!libsha2_hkdf_expand(&hk, &buf[2048], (sizeof(INFO) - 1) / 2, &buf[4096], (sizeof(OKM) - 1) / 2));\
+		libsha2_behex_lower(str, &buf[4096], (sizeof(OKM) - 1) / 2);\
+		test_str(str, OKM);\
+	} while (0)
+
+#define test_crypt(PHRASE, SETTING, EXPECTED)\
+	do {\
+		test(!libsha2_crypt(PHRASE, SETTING, str));\
+		test_str(str, EXPECTED);\
+		test(!libsha2_crypt(PHRASE, EXPECTED, str));\
+		test_str(str, EXPECTED);\
+	} while (0)
+
 #define test_hmac(ALGO, TEXT, KEY, MAC)\
 	do {\
 		libsha2_unhex(buf, KEY);\
 		test(!libsha2_hmac_init(&hs, ALGO, buf, (sizeof(KEY) - 1) << 2));\
+		test(!libsha2_hmac_key_init(&hk, ALGO, buf, (sizeof(KEY) - 1) << 2));\
 		libsha2_unhex(buf, TEXT);\
+		libsha2_hmac_digest(&hs, buf, (sizeof(TEXT) - 1) << 2, &buf[4096]);\
+		libsha2_behex_lower(str, &buf[4096], libsha2_hmac_state_output_size(&hs));\
+		test_str(str, MAC);\
+		libsha2_hmac_digest(&hs, buf, (sizeof(TEXT) - 1) << 2, &buf[4096]);\
+		libsha2_behex_lower(str, &buf[4096], libsha2_hmac_state_output_size(&hs));\
+		test_str(str, MAC);\
+		libsha2_hmac_key_digest(&hk, buf, (sizeof(TEXT) - 1) << 2, &buf[4096]);\
+		libsha2_behex_lower(str, &buf[4096], libsha2_hmac_state_output_size(&hs));\
+		test_str(str, MAC);\
+		memset(&hs, 0, sizeof(hs));\
+		libsha2_hmac_init_from_key(&hs, &hk);\
 		libsha2_hmac_digest(&hs, buf, (sizeof(TEXT) - 1) << 2, buf);\
 		libsha2_behex_lower(str, buf, libsha2_hmac_state_output_size(&hs));\
 		test_str(str, MAC);\
 	} while (0)
 
 
+static unsigned char cdc_data[300000];
+static struct libsha2_cdc_chunk cdc_chunks[2][200];
+static unsigned char verity_tree[2][45056];
+static const void *merkle_entries[5000];
+static size_t merkle_lens[5000];
+
+static const struct {
+	int consistency;
+	size_t m, n, nhashes;
+	const char *hash;
+} merkle_proofs[] = {
+	{0, 0, 1, 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+	{0, 5, 6, 2, "bf3b0462b945725298a663c0cf18549541bb89cf456a2a9a6bb5df3b3e8e1428"},
+	{0, 999, 1000, 8, "cab4a81175cc66ab2f48003d1cef6db55b6780401f6b5186e6a71aec5568b3d4"},
+	{0, 1234, 5000, 13, "732fc14a9e21a2206c971dc74e018b074a64d7837b57145bf7a359f13342e701"},
+	{0, 4095, 5000, 13, "793ac08c045c0b5f9d7d3d90c9ad842b6986210dd68ca3b3fc3df489e7c66b3b"},
+	{1, 1, 1, 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+	{1, 1, 2, 1, "b86a6c5f2ee7ee89b2eb09331a339f21363ef5d46ca6fcfd8fa51debbe57fcdc"},
+	{1, 3, 7, 4, "64b18e2f8856ccac463135b8e5e0c23bf28b004df007b6e562da74a825a1c9f0"},
+	{1, 4, 8, 1, "5099b1f3e526cdba94a2a5cf78e2d0a63bd056e69c98152de68dc3fada9f3da2"},
+	{1, 1000, 5000, 11, "d78fbd09d9563599abca5383c6713d2fdf68fd9f38187b283f11a29996164a6d"},
+	{1, 4096, 4999, 1, "f27f2deedc327c4ec3e8a7f3bfb554d1d92864c8b3892b08a0017e8ba5a70085"}
+};
+
+
+static const char *const crypt_settings[] = {
+	"$5$rounds=1000$a", "$6$rounds=1001$bb", "$5$rounds=1002$",
+	"$6$rounds=1000$cccccccccccccccccc", "*0", "$6$rounds=1003$d"
+};
+
+
 int
 main(int argc, char *argv[])
 {
 	char buf[8096], str[2048];
 	struct libsha2_state s;
 	struct libsha2_hmac_state hs;
+	struct libsha2_hmac_key hk, hks[3];
+	const struct libsha2_hmac_key *hkp[80];
+	unsigned char valid[80];
+	struct libsha2_state ms[40], *msp[40];
+	const void *msgs[80];
+	const char *phrases[40], *settings[40];
+	size_t msglens[80];
+	void *outs[40], *kouts[80];
+	size_t outlens[80];
+	char kout[80][200];
+	char mout[80][64];
 	int skip_huge, fds[2], status;
-	size_t i, j, n, len;
+	size_t i, j, k, m, n, len;
 	ssize_t r;
 	pid_t pid;
+	FILE *f;
+	char dir[] = "/tmp/libsha2-test-XXXXXX", paths_buf[41][64];
+	const char *paths[41];
+	int sfds[40], errs[41];
+	struct libsha2_cache cache;
+	struct stat attr;
+	unsigned char cache_data[15003], cache_copy[5000];
+	char checkpoint[LIBSHA2_MARSHAL_SIZE];
+	size_t checkpoint_size;
+	off_t off;
+	struct libsha2_cdc cdc;
+	uint_least64_t x;
+	struct libsha2_verity verity;
+	struct libsha2_merkle merkle;
+	unsigned char out64[40 * 32], out64d[40 * 32];
+	unsigned char verified[16];
 
 	skip_huge = (argc == 2 && !strcmp(argv[1], "skip-huge"));
 
@@ -333,28 +434,671 @@ main(int argc, char *argv[])
 				"3000c31a7ab8e9c760257073c4d3be370fab6d1d28eb027c6d874f29",
 				"6ad592c8991fa0fc0fc78b6c2e73f3b55db74afeb1027a5aeacb787fb531e64a",
 			})[j]);
+
+			memset(buf, 0x41, 1000);
+			test(!libsha2_init(&ms[0], (enum libsha2_algorithm)j));
+			for (n = 0, k = 0; n + i < 1000; n += i, k ^= 1) {
+				libsha2_update(&ms[k], buf, i * 8);
+				memset(&ms[k ^ 1], 0xFF, sizeof(ms[k ^ 1]));
+				libsha2_state_copy(&ms[k ^ 1], &ms[k]);
+				libsha2_update(&ms[k], buf, 8);
+			}
+			libsha2_digest(&ms[k], buf, (1000 - n) * 8, buf);
+			libsha2_behex_lower(&str[1024], buf, libsha2_state_output_size(&ms[k]));
+			test_str(&str[1024], str);
+		}
+	}
+
+	test(!errno);
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (char)(i * 13 + 5);
+	for (j = 0; j < 6; j++) {
+		for (n = 0; n < 300 * 8; n += (n < 140 * 8 ? 1 : 7)) {
+			test(!libsha2_init(&s, (enum libsha2_algorithm)j));
+			libsha2_digest(&s, buf, n, str);
+			test(!libsha2_hash((enum libsha2_algorithm)j, buf, n, &str[64]));
+			test(!memcmp(str, &str[64], libsha2_state_output_size(&s)));
+		}
+	}
+	test(!libsha2_hash(LIBSHA2_256, NULL, 0, buf));
+	libsha2_behex_lower(str, buf, libsha2_algorithm_output_size(LIBSHA2_256));
+	test_str(str, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	test(libsha2_hash((enum libsha2_algorithm)6, "", 0, buf) == -1 && errno == EINVAL);
+	errno = 0;
+
+	for (i = 0; i < 80; i++) {
+		msgs[i] = &buf[i];
+		msglens[i] = (i * 331 % 1100) * 8 + i % 8;
+	}
+	for (j = 0; j < 6; j++) {
+		for (n = 0; n < 5; n++) {
+			i = ((const size_t []){0, 1, 5, 33, 80})[n];
+			test(!libsha2_digest_many((enum libsha2_algorithm)j, msgs, msglens, i, mout));
+			for (k = 0; k < i; k++) {
+				test(!libsha2_hash((enum libsha2_algorithm)j, msgs[k], msglens[k], str));
+				test(!memcmp(str, &((char *)mout)[k * libsha2_algorithm_output_size((enum libsha2_algorithm)j)],
+				             libsha2_algorithm_output_size((enum libsha2_algorithm)j)));
+			}
+		}
+	}
+	test(libsha2_digest_many((enum libsha2_algorithm)6, msgs, msglens, 1, mout) == -1 && errno == EINVAL);
+	errno = 0;
+
+	for (j = 0; j < 6; j++) {
+		len = libsha2_algorithm_output_size((enum libsha2_algorithm)j);
+		for (k = 0; k < 3; k++) {
+			n = ((const size_t []){0, 20, 200})[k] * 8 + k;
+			test(!libsha2_hmac_key_init(&hks[k], (enum libsha2_algorithm)j, &buf[k * 100], n));
+		}
+		for (i = 0; i < 80; i++)
+			hkp[i] = &hks[i * 7 % 3];
+		for (n = 0; n < 5; n++) {
+			i = ((const size_t []){0, 1, 5, 33, 80})[n];
+			test(!libsha2_hmac_digest_many(hkp, msgs, msglens, i, mout));
+			for (k = 0; k < i; k++) {
+				libsha2_hmac_key_digest(hkp[k], msgs[k], msglens[k], str);
+				test(!memcmp(str, &((char *)mout)[k * len], len));
+			}
+			if (i)
+				((char *)mout)[(i - 1) * len] ^= 1;
+			test(!libsha2_hmac_verify_many(hkp, msgs, msglens, i, mout, valid));
+			for (k = 0; k < i; k++)
+				test(valid[k] == (k + 1 < i));
+		}
+	}
+	hks[1].algorithm = LIBSHA2_256;
+	test(libsha2_hmac_digest_many(hkp, msgs, msglens, 3, mout) == -1 && errno == EINVAL);
+	errno = 0;
+	test(libsha2_hmac_verify_many(hkp, msgs, msglens, 3, mout, valid) == -1 && errno == EINVAL);
+	errno = 0;
+
+	/* Version 1 of the marshalled format also stored the round constants */
+	test(!libsha2_init(&s, LIBSHA2_256));
+	libsha2_update(&s, "abc", 3 * 8);
+	len = libsha2_marshal(&s, buf);
+	n = sizeof(int) + sizeof(enum libsha2_algorithm) + sizeof(size_t);
+	memcpy(str, buf, n);
+	*(int *)str = 1;
+	memset(&str[n], 0, 64 * sizeof(uint_least32_t));
+	memcpy(&str[n + 64 * sizeof(uint_least32_t)], &buf[n], len - n);
+	len += 64 * sizeof(uint_least32_t);
+	memset(&s, 0, sizeof(s));
+	test(libsha2_unmarshal(&s, str, len) == len);
+	libsha2_digest(&s, NULL, 0, buf);
+	libsha2_behex_lower(str, buf, libsha2_state_output_size(&s));
+	test_str(str, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (char)(i * 31 + 7);
+	for (i = 0; i < 40; i++) {
+		test(!libsha2_init(&ms[i], (enum libsha2_algorithm)(i % 6)));
+		libsha2_update(&ms[i], buf, (i % 3) * 40 * 8);
+		msp[i] = &ms[i];
+		msgs[i] = &buf[i];
+		msglens[i] = (i * 97 % 700) * 8 + (i % 4 == 3 ? i % 8 : 0);
+		outs[i] = mout[i];
+	}
+	msglens[5] = 0;
+	msgs[5] = NULL;
+	for (n = 0; n < 7; n++) {
+		i = ((const size_t []){0, 1, 7, 8, 9, 33, 40})[n];
+		for (j = 0; j < i; j++) {
+			test(!libsha2_init(&ms[j], (enum libsha2_algorithm)(j % 6)));
+			libsha2_update(&ms[j], buf, (j % 3) * 40 * 8);
+		}
+		libsha2_digest_multi(msp, msgs, msglens, outs, i);
+		for (j = 0; j < i; j++) {
+			test(!libsha2_init(&s, (enum libsha2_algorithm)(j % 6)));
+			libsha2_update(&s, buf, (j % 3) * 40 * 8);
+			libsha2_digest(&s, msgs[j], msglens[j], str);
+			test(!memcmp(str, mout[j], libsha2_state_output_size(&s)));
 		}
 	}
 
 	test(!errno);
 
+	test(libsha2_set_backend("bogus") == -1 && errno == EINVAL);
+	test(libsha2_set_backend("portable,") == -1 && errno == EINVAL);
+	errno = 0;
+	test(!libsha2_set_backend("portable"));
+	test_str(libsha2_get_backend(LIBSHA2_256, 0), "portable");
+	test_str(libsha2_get_backend(LIBSHA2_512, 0), "portable");
+	test(!libsha2_get_backend(LIBSHA2_256, 1));
+	test(!libsha2_get_backend(LIBSHA2_512, 1));
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = (char)(i * 7 + 1);
+	for (n = 0; n < 5; n++) {
+		for (j = 0; j < 32; j++) {
+			msgs[j] = buf;
+			msglens[j] = (j * 193 % 2100) * 8 + j % 8;
+			outs[j] = &str[j * 64];
+			test(!libsha2_init(&ms[j], (enum libsha2_algorithm)(j % 6)));
+			libsha2_digest(&ms[j], buf, msglens[j], mout[j]);
+		}
+		if (libsha2_set_backend(((const char *[]){"sha-ni", "avx2", "avx512", "sha-ni,avx2", "auto"})[n])) {
+			test(errno == ENOTSUP);
+			errno = 0;
+			test(!libsha2_set_backend("portable"));
+			continue;
+		}
+		test(libsha2_get_backend(LIBSHA2_224, 0) && libsha2_get_backend(LIBSHA2_384, 0));
+		for (j = 0; j < 32; j++) {
+			test(!libsha2_init(&ms[j], (enum libsha2_algorithm)(j % 6)));
+			libsha2_digest(&ms[j], buf, msglens[j], outs[j]);
+			test(!memcmp(outs[j], mout[j], libsha2_state_output_size(&ms[j])));
+			test(!libsha2_init(&ms[j], (enum libsha2_algorithm)(j % 6)));
+		}
+		libsha2_digest_multi(msp, msgs, msglens, outs, 32);
+		for (j = 0; j < 32; j++)
+			test(!memcmp(outs[j], mout[j], libsha2_state_output_size(&ms[j])));
+		test(!libsha2_set_backend("portable"));
+	}
+	test(!libsha2_set_backend(NULL));
+
 #if TEST_SHA256
-	test(!pipe(fds));
-	test((pid = fork()) >= 0);
-	if (!pid) {
+	for (j = 0; j < 3; j++) {
+		test(!pipe(fds));
+		test((pid = fork()) >= 0);
+		if (!pid) {
+			close(fds[0]);
+			memset(buf, 0x41, 1000);
+			for (n = 1000; n; n -= (size_t)r)
+				test((r = write(fds[1], buf, n < 8 ? n : 8)) > 0);
+			exit(0);
+		}
+		close(fds[1]);
+		n = 10;
+		if (j == 2)
+			test(!libsha2_sum_fd_pieces(fds[0], LIBSHA2_256, 100, mout, &n, buf, 4, LIBSHA2_MAP));
+		else if (j)
+			test(!libsha2_sum_fd_queued(fds[0], LIBSHA2_256, buf, 0, 0));
+		else
+			test(!libsha2_sum_fd(fds[0], LIBSHA2_256, buf));
+		test(n == 10);
+		for (i = 0; j == 2 && i < n; i++) {
+			memset(str, 0x41, 100);
+			libsha2_hash(LIBSHA2_256, str, 100 * 8, &str[128]);
+			test(!memcmp(&((char *)mout)[i * 32], &str[128], 32));
+		}
+		test(waitpid(pid, &status, 0) == pid);
+		test(!status);
 		close(fds[0]);
-		memset(buf, 0x41, 1000);
-		for (n = 1000; n; n -= (size_t)r)
-			test((r = write(fds[1], buf, n < 8 ? n : 8)) > 0);
-		exit(0);
+		libsha2_behex_lower(str, buf, libsha2_algorithm_output_size(LIBSHA2_256));
+		test_str(str, "c2e686823489ced2017f6059b8b239318b6364f6dcd835d0a519105a1eadd6e4");
+	}
+
+	test((f = tmpfile()));
+	for (i = 0; i < 8000; i++)
+		buf[i] = (char)(i * 7 + i / 256);
+	for (i = 0; i < 1200; i++)
+		test(fwrite(buf, 1, 8000, f) == 8000);
+	test(!fflush(f));
+	test(!libsha2_init(&s, LIBSHA2_512));
+	libsha2_update(&s, &buf[3], 7997 * 8);
+	for (i = 1; i < 1200; i++)
+		libsha2_update(&s, buf, 8000 * 8);
+	libsha2_digest(&s, NULL, 0, &str[64]);
+	test(lseek(fileno(f), 3, SEEK_SET) == 3);
+	test(!libsha2_sum_fd(fileno(f), LIBSHA2_512, &str[0]));
+	test(lseek(fileno(f), 0, SEEK_CUR) == 1200 * 8000);
+	test(!memcmp(str, &str[64], 64));
+	test(lseek(fileno(f), 3, SEEK_SET) == 3);
+	test(!libsha2_sum_fd_mapped(fileno(f), LIBSHA2_512, &str[0], 0));
+	test(lseek(fileno(f), 0, SEEK_CUR) == 1200 * 8000);
+	test(!memcmp(str, &str[64], 64));
+	test(lseek(fileno(f), 3, SEEK_SET) == 3);
+	test(!libsha2_sum_fd_mapped(fileno(f), LIBSHA2_512, &str[0], LIBSHA2_MAP_POPULATE | LIBSHA2_MAP_HUGEPAGE));
+	test(lseek(fileno(f), 0, SEEK_CUR) == 1200 * 8000);
+	test(!memcmp(str, &str[64], 64));
+	test(libsha2_sum_fd_mapped(fileno(f), LIBSHA2_512, &str[0], LIBSHA2_MAP) == -1 && errno == EINVAL);
+	errno = 0;
+	test(lseek(fileno(f), 3, SEEK_SET) == 3);
+	test(!libsha2_sum_fd_queued(fileno(f), LIBSHA2_512, &str[128], 3, 5000));
+	test(lseek(fileno(f), 0, SEEK_CUR) == 1200 * 8000);
+	test(!memcmp(str, &str[128], 64));
+	test(lseek(fileno(f), 8000, SEEK_SET) == 8000);
+	test(!libsha2_sum_fd_queued(fileno(f), LIBSHA2_256, &str[128], 0, 0));
+	test(!libsha2_init(&s, LIBSHA2_256));
+	for (i = 1; i < 1200; i++)
+		libsha2_update(&s, buf, 8000 * 8);
+	libsha2_digest(&s, NULL, 0, &str[64]);
+	test(!memcmp(&str[64], &str[128], 32));
+	for (k = 0; k < 2; k++) {
+		test(lseek(fileno(f), (off_t)k * 8000, SEEK_SET) == (off_t)k * 8000);
+		n = 1200 * 8000 / 65536;
+		test(libsha2_sum_fd_pieces(fileno(f), LIBSHA2_256, 65536, kout, &n, NULL, 0, 0) == -1 && errno == ERANGE);
+		test(lseek(fileno(f), (off_t)k * 8000, SEEK_SET) == (off_t)k * 8000);
+		n = 1200 * 8000 / 65536 + 1;
+		test(libsha2_sum_fd_pieces(fileno(f), LIBSHA2_256, 65536, kout, &n, NULL, 0, 8) == -1 && errno == EINVAL);
+		errno = 0;
+		test(!libsha2_sum_fd_pieces(fileno(f), LIBSHA2_256, 65536, kout, &n, &str[64], k + 1,
+		                           k ? LIBSHA2_MAP | LIBSHA2_MAP_POPULATE : 0));
+		test(n == (1200 - k) * 8000 / 65536 + 1);
+		test(!libsha2_init(&s, LIBSHA2_256));
+		for (i = 0; i < (1200 - k) * 8000; i += len) {
+			len = 8000 - i % 8000;
+			if (i / 65536 != (i + len - 1) / 65536)
+				len = 65536 - i % 65536;
+			libsha2_update(&s, &buf[i % 8000], len * 8);
+			if ((i + len) % 65536 == 0 || i + len == (1200 - k) * 8000) {
+				libsha2_digest(&s, NULL, 0, str);
+				test(!memcmp(&((char *)kout)[i / 65536 * 32], str, 32));
+				test(!libsha2_init(&s, LIBSHA2_256));
+			}
+		}
+		test(lseek(fileno(f), (off_t)k * 8000, SEEK_SET) == (off_t)k * 8000);
+		test(!libsha2_sum_fd(fileno(f), LIBSHA2_256, &str[128]));
+		test(!memcmp(&str[64], &str[128], 32));
+	}
+	fclose(f);
+	test(!libsha2_digest_pieces(LIBSHA2_512, buf, 7999, 1000, mout, &str[64], 3));
+	for (i = 0; i < 8; i++) {
+		libsha2_hash(LIBSHA2_512, &buf[i * 1000], (i == 7 ? 999 : 1000) * 8, str);
+		test(!memcmp(mout[i], str, 64));
+	}
+	libsha2_hash(LIBSHA2_512, buf, 7999 * 8, str);
+	test(!memcmp(&str[64], str, 64));
+	test(libsha2_digest_pieces(LIBSHA2_512, buf, 7999, 0, mout, NULL, 3) == -1 && errno == EINVAL);
+	errno = 0;
+
+	for (x = 1, i = 0; i < sizeof(cdc_data); i++) {
+		x ^= x << 13;
+		x ^= (x & 0xFFFFFFFFFFFFFFFFULL) >> 7;
+		x ^= x << 17;
+		cdc_data[i] = (unsigned char)(x >> 24);
+	}
+	test(libsha2_cdc_init(&cdc, LIBSHA2_256, 0, 1000, 0) == -1 && errno == EINVAL);
+	test(libsha2_cdc_init(&cdc, LIBSHA2_256, 4096, 2048, 0) == -1 && errno == EINVAL);
+	errno = 0;
+	for (k = 0; k < 2; k++) {
+		test(!libsha2_cdc_init(&cdc, LIBSHA2_256, 0, 0, 0));
+		m = 0;
+		for (i = 0; i < sizeof(cdc_data); i += len) {
+			len = k ? (i * 7 + 1) % 9973 + 1 : sizeof(cdc_data);
+			len = len < sizeof(cdc_data) - i ? len : sizeof(cdc_data) - i;
+			n = k ? 3 : 200 - m;
+			len = libsha2_cdc_update(&cdc, &cdc_data[i], len, &cdc_chunks[k][m], &n);
+			m += n;
+		}
+		m += libsha2_cdc_finish(&cdc, &cdc_chunks[k][m]);
+		test(m > 20 && m < 100);
+		for (i = 0, off = 0; i < m; i++) {
+			test(cdc_chunks[k][i].offset == (uint_least64_t)off);
+			test(cdc_chunks[k][i].length <= 65536);
+			test(cdc_chunks[k][i].length >= 2048 || i == m - 1);
+			libsha2_hash(LIBSHA2_256, &cdc_data[off], cdc_chunks[k][i].length * 8, str);
+			test(!memcmp(cdc_chunks[k][i].digest, str, 32));
+			off += (off_t)cdc_chunks[k][i].length;
+		}
+		test(off == (off_t)sizeof(cdc_data));
 	}
-	close(fds[1]);
-	test(!libsha2_sum_fd(fds[0], LIBSHA2_256, buf));
-	test(waitpid(pid, &status, 0) == pid);
-	test(!status);
+	test(!memcmp(cdc_chunks[0], cdc_chunks[1], sizeof(cdc_chunks[0])));
+
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_FS, LIBSHA2_256, 4096, NULL, 0, 0, &x) && !x);
+	test(!libsha2_verity_build(&verity, "", verity_tree[0], str, 1));
+	test(!libsha2_fsverity_digest(&verity, str, &str[64]));
+	libsha2_behex_lower(buf, &str[64], 32);
+	test_str(buf, "3d248ca542a24fc62d1c43b916eae5016878e2533c88238480b26128a1f1af95");
+	for (i = 0; i < 100; i++)
+		cache_copy[i] = (unsigned char)i;
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_FS, LIBSHA2_256, 4096, NULL, 0, 100, &x) && !x);
+	test(!libsha2_verity_build(&verity, cache_copy, verity_tree[0], str, 1));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "bfc30f54b87dbd0fda7df4c910cb4c95307a7ecb9ac09d7f545830bd15ffea81");
+	test(!libsha2_fsverity_digest(&verity, str, &str[64]));
+	libsha2_behex_lower(buf, &str[64], 32);
+	test_str(buf, "9f37bd4e8c0d50d81d76ec71e6cccc6696f4a196e730c8b2019deaa103a6350a");
+	test((f = tmpfile()));
+	test(write(fileno(f), cache_copy, 100) == 100);
+	test(!libsha2_verity_build_fd(&verity, fileno(f), verity_tree[1], &str[64], 2));
+	test(!memcmp(str, &str[64], 32));
+	fclose(f);
+	memset(&cache_copy[100], 0, 4096 - 100);
+	test(!libsha2_verity_verify(&verity, str, verity_tree[0], NULL, 0, cache_copy));
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_FS, LIBSHA2_256, 4096, NULL, 0, 300000, &x) && x == 4096);
+	test(!libsha2_verity_build(&verity, cdc_data, verity_tree[0], str, 1));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "9b8a7b899b3c1cf0f786962edc6190c4f3edf6bc076ea41d49a7f411763f9cae");
+	test(!libsha2_fsverity_digest(&verity, str, &str[64]));
+	libsha2_behex_lower(buf, &str[64], 32);
+	test_str(buf, "92175f6cfce078474278fe97fa054d23a48272424ba63528bcee6479931f9aff");
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_FS, LIBSHA2_512, 1024, "salty", 5, 300000, &x) && x == 22528);
+	test(!libsha2_verity_build(&verity, cdc_data, verity_tree[0], str, 0));
+	libsha2_behex_lower(buf, str, 64);
+	test_str(buf, "7366609f34dacaa91769380eddd28e90c87230d7cbfd335a6b973fff49fdf0e2"
+	              "73ace38020bd248ed7663e5c091cc98323a154cc48b0ed13709b36e143d1678d");
+	test(!libsha2_fsverity_digest(&verity, str, &str[64]));
+	libsha2_behex_lower(buf, &str[64], 64);
+	test_str(buf, "d549c24697c56543e96af95e97edb8efd6f71ccef593ef5f1e04f6d8c7c2eadf"
+	              "a775b52141497b9940280a923f077ad4e8b3a178acf776e3b9c7e9fb987e5d2f");
+	test((f = tmpfile()));
+	for (i = 0; i < sizeof(cdc_data); i += (size_t)r)
+		test((r = write(fileno(f), &cdc_data[i], sizeof(cdc_data) - i)) > 0);
+	test(!libsha2_verity_build_fd(&verity, fileno(f), verity_tree[1], &str[64], 3));
+	test(!memcmp(verity_tree[0], verity_tree[1], (size_t)x) && !memcmp(str, &str[64], 64));
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_DM, LIBSHA2_256, 4096, kout[0], 32, 300001, &x));
+	test(libsha2_verity_build_fd(&verity, fileno(f), verity_tree[1], str, 1) == -1 && errno == EIO);
+	fclose(f);
+	for (i = 0; i < 32; i++)
+		kout[0][i] = (char)i;
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_DM, LIBSHA2_256, 4096, kout[0], 32, 300000, &x) && x == 4096);
+	test(!libsha2_verity_build(&verity, cdc_data, verity_tree[0], str, 2));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "f676f80abcae36924ec6e00254bb9c1b9f85ca18ef3cb870b7210a19ab268647");
+	test(libsha2_fsverity_digest(&verity, str, &str[64]) == -1 && errno == EINVAL);
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_DM, LIBSHA2_256, 4096, "x", 1, 100, &x) && !x);
+	test(!libsha2_verity_build(&verity, cdc_data, verity_tree[0], str, 1));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "34150db9c9afcfa572fc6f2ff2e246966ec59644f937d6bfd8d2bef5f87978aa");
+	memset(buf, 0, 4096);
+	memcpy(buf, cdc_data, 100);
+	test(!libsha2_verity_verify(&verity, str, verity_tree[0], NULL, 0, buf));
+	test(libsha2_verity_verify(&verity, str, verity_tree[0], NULL, 1, buf) == -1 && errno == EINVAL);
+	test(!libsha2_verity_init(&verity, LIBSHA2_VERITY_DM, LIBSHA2_384, 512, "ab", 2, 300000, &x) && x == 44544);
+	test(!libsha2_verity_build(&verity, cdc_data, verity_tree[0], str, 0));
+	libsha2_behex_lower(buf, str, 48);
+	test_str(buf, "6f15e1c6c129535878a7ef3b54dd216dbac24e94f73ae07ef5cc584cb1e0a518"
+	              "29ffb84a6f019ff59c9ec416cd8f30cd");
+	memset(verified, 0, sizeof(verified));
+	for (i = 0; i < 300000 / 512; i++)
+		test(!libsha2_verity_verify(&verity, str, verity_tree[0], verified, i, &cdc_data[i * 512]));
+	for (i = 0; i < 87; i++)
+		test((verified[i / 8] >> (i % 8)) & 1);
+	test(!(verified[87 / 8] >> (87 % 8)));
+	memset(buf, 0, 512);
+	memcpy(buf, &cdc_data[300000 / 512 * 512], 300000 % 512);
+	test(!libsha2_verity_verify(&verity, str, verity_tree[0], verified, 300000 / 512, buf));
+	buf[0] ^= 1;
+	test(libsha2_verity_verify(&verity, str, verity_tree[0], verified, 300000 / 512, buf) == -1 && errno == EBADMSG);
+	test(libsha2_verity_verify(&verity, str, verity_tree[0], verified, 300000 / 512 + 1, buf) == -1 && errno == EINVAL);
+	verity_tree[0][0] ^= 1;
+	test(!libsha2_verity_verify(&verity, str, verity_tree[0], verified, 0, cdc_data));
+	test(libsha2_verity_verify(&verity, str, verity_tree[0], NULL, 0, cdc_data) == -1 && errno == EBADMSG);
+	test(libsha2_verity_init(&verity, LIBSHA2_VERITY_DM, LIBSHA2_256, 4096, NULL, 0, 0, &x) == -1 && errno == EINVAL);
+	test(libsha2_verity_init(&verity, LIBSHA2_VERITY_FS, LIBSHA2_384, 4096, NULL, 0, 1, &x) == -1 && errno == EINVAL);
+	test(libsha2_verity_init(&verity, LIBSHA2_VERITY_FS, LIBSHA2_256, 512, NULL, 0, 1, &x) == -1 && errno == EINVAL);
+	test(libsha2_verity_init(&verity, LIBSHA2_VERITY_DM, LIBSHA2_256, 1000, NULL, 0, 1, &x) == -1 && errno == EINVAL);
+	errno = 0;
+
+	for (i = 0; i < 5000; i++) {
+		merkle_entries[i] = &cdc_data[i * 53 % (sizeof(cdc_data) - 260)];
+		merkle_lens[i] = i * 61 % 260;
+	}
+	test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, 0, str));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, 1, str));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d");
+	test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, 7, str));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "daf135b5b7369eb09745d8ec5d7f6cfa09e10ce14ed3e6c85bb385dc3dab8445");
+	test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, 1000, str));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "4964d4b99c4f284c67fe888552e22db893ffc3fee48c806861ad32c1f4cb3f46");
+	test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, 5000, str));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "716b4777bc184a20341e8b1eb2cd82c0ca3963860d7eccf92b13c2c793f1bbea");
+	test(!libsha2_merkle_tree_hash(LIBSHA2_512, merkle_entries, merkle_lens, 5000, str));
+	libsha2_behex_lower(buf, str, 64);
+	test_str(buf, "eaf9d332fce40bd6f39dd6c3cff0e59b8ebd0300211cc368446a393c349bbcb9"
+	              "709891fbdbb617fb8b88764ec9b66e46b4e34d805cc3c0981b42b1c0b0f5290e");
+	test(libsha2_merkle_tree_hash((enum libsha2_algorithm)~0, merkle_entries, merkle_lens, 1, str) == -1);
+	test(errno == EINVAL);
+	errno = 0;
+	test(!libsha2_merkle_init(&merkle, LIBSHA2_224));
+	test(!libsha2_merkle_append(&merkle, merkle_entries, merkle_lens, 777));
+	test(!libsha2_merkle_root(&merkle, 777, str));
+	libsha2_behex_lower(buf, str, 28);
+	test_str(buf, "35e6c304406bd43439f39143cade7178dc84decfa868e2e34073fd0f");
+	libsha2_merkle_destroy(&merkle);
+	test(!libsha2_merkle_init(&merkle, LIBSHA2_256));
+	for (i = 0; i < 5000; i += n) {
+		n = i % 7 * i % 300 + 1;
+		n = n < 5000 - i ? n : 5000 - i;
+		test(!libsha2_merkle_append(&merkle, &merkle_entries[i], &merkle_lens[i], n));
+		test(!libsha2_merkle_root(&merkle, i + n, str));
+		test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, i + n, &str[64]));
+		test(!memcmp(str, &str[64], 32));
+	}
+	test(!libsha2_merkle_root(&merkle, 0, str));
+	test(!libsha2_merkle_root(&merkle, 4096, &str[32]));
+	test(!libsha2_merkle_tree_hash(LIBSHA2_256, merkle_entries, merkle_lens, 4096, &str[64]));
+	test(!memcmp(&str[32], &str[64], 32));
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	for (i = 0; i < sizeof(merkle_proofs) / sizeof(*merkle_proofs); i++) {
+		if (merkle_proofs[i].consistency)
+			test(!libsha2_merkle_consistency_proof(&merkle, merkle_proofs[i].m, merkle_proofs[i].n, kout, &n));
+		else
+			test(!libsha2_merkle_inclusion_proof(&merkle, merkle_proofs[i].m, merkle_proofs[i].n, kout, &n));
+		test(n == merkle_proofs[i].nhashes);
+		libsha2_hash(LIBSHA2_256, kout, n * 32 * 8, str);
+		libsha2_behex_lower(buf, str, 32);
+		test_str(buf, merkle_proofs[i].hash);
+	}
+	test(libsha2_merkle_root(&merkle, 5001, str) == -1 && errno == EINVAL);
+	test(libsha2_merkle_inclusion_proof(&merkle, 7, 7, kout, &n) == -1 && errno == EINVAL);
+	test(libsha2_merkle_inclusion_proof(&merkle, 0, 5001, kout, &n) == -1 && errno == EINVAL);
+	test(libsha2_merkle_consistency_proof(&merkle, 0, 7, kout, &n) == -1 && errno == EINVAL);
+	test(libsha2_merkle_consistency_proof(&merkle, 8, 7, kout, &n) == -1 && errno == EINVAL);
+	errno = 0;
+	libsha2_merkle_destroy(&merkle);
+
+	memset(buf, 0, 64);
+	libsha2_sha256_64(buf, str);
+	libsha2_behex_lower(&buf[64], str, 32);
+	test_str(&buf[64], "f5a5fd42d16a20302798ef6ed309979b43003d2320d9f0e8ea9831a92759fb4b");
+	libsha2_unhex(buf, "0100000000000000000000000000000000000000000000000000000000000000"
+	                   "000000003ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa"
+	                   "4b1e5e4a29ab5f49ffff001d1dac2b7c");
+	libsha2_sha256d(buf, 80 * 8, str);
+	libsha2_behex_lower(buf, str, 32);
+	test_str(buf, "6fe28c0ab6f1b372c1a6a246ae63f74f931e8365e15a089c68d6190000000000");
+	for (m = 0; m < 5; m++) {
+		if (libsha2_set_backend(((const char *[]){"portable", "sha-ni", "avx2", "avx512", "auto"})[m])) {
+			test(errno == ENOTSUP);
+			errno = 0;
+			continue;
+		}
+		for (n = 0; n <= 40; n++) {
+			libsha2_sha256_64_many(&cdc_data[n], n, out64);
+			libsha2_sha256d_64_many(&cdc_data[n], n, out64d);
+			for (i = 0; i < n; i++) {
+				test(!libsha2_hash(LIBSHA2_256, &cdc_data[n + i * 64], 512, str));
+				test(!memcmp(&out64[i * 32], str, 32));
+				test(!libsha2_hash(LIBSHA2_256, str, 256, &str[32]));
+				test(!memcmp(&out64d[i * 32], &str[32], 32));
+			}
+			libsha2_sha256_64(&cdc_data[n], &str[64]);
+			test(!libsha2_hash(LIBSHA2_256, &cdc_data[n], 512, str));
+			test(!memcmp(&str[64], str, 32));
+			libsha2_sha256d(&cdc_data[n], n * 29, &str[64]);
+			test(!libsha2_hash(LIBSHA2_256, &cdc_data[n], n * 29, str));
+			test(!libsha2_hash(LIBSHA2_256, str, 256, &str[32]));
+			test(!memcmp(&str[64], &str[32], 32));
+			libsha2_sha256d(&cdc_data[n], 512, &str[64]);
+			test(!memcmp(&str[64], out64d, 32) || !n);
+		}
+	}
+	test(!libsha2_set_backend(NULL));
+
+	test((f = tmpfile()));
+	checkpoint_size = 0;
+	off = 0;
+	for (i = 0; i < 40; i++) {
+		test(lseek(fileno(f), 0, SEEK_END) >= 0);
+		test(write(fileno(f), &buf[i], i * 173) == (ssize_t)(i * 173));
+		test(!libsha2_sum_fd_resume(fileno(f), LIBSHA2_256, &str[0],
+		                            checkpoint, &checkpoint_size, &off));
+		test(off == lseek(fileno(f), 0, SEEK_END));
+		test(lseek(fileno(f), 0, SEEK_SET) == 0);
+		test(!libsha2_sum_fd(fileno(f), LIBSHA2_256, &str[64]));
+		test(!memcmp(str, &str[64], 32));
+	}
+	len = checkpoint_size;
+	test(libsha2_sum_fd_resume(fileno(f), LIBSHA2_512, &str[0], checkpoint, &checkpoint_size, &off) == -1);
+	test(errno == EINVAL && checkpoint_size == len);
+	off -= 1;
+	test(libsha2_sum_fd_resume(fileno(f), LIBSHA2_256, &str[0], checkpoint, &checkpoint_size, &off) == -1);
+	test(errno == EINVAL && checkpoint_size == len);
+	off += 1;
+	checkpoint_size = 0;
+	test(libsha2_sum_fd_resume(fileno(f), LIBSHA2_256, &str[0], checkpoint, &checkpoint_size, &off) == -1);
+	test(errno == EINVAL && !checkpoint_size);
+	checkpoint_size = len;
+	test(!ftruncate(fileno(f), off - 1));
+	test(libsha2_sum_fd_resume(fileno(f), LIBSHA2_256, &str[0], checkpoint, &checkpoint_size, &off) == -1);
+	test(errno == EINVAL && off == lseek(fileno(f), 0, SEEK_END) + 1);
+	errno = 0;
+	fclose(f);
+
+	test(mkdtemp(dir));
+	for (i = 0; i < 41; i++) {
+		sprintf(paths_buf[i], "%s/%zu", dir, i);
+		paths[i] = paths_buf[i];
+		if (i == 40)
+			break;
+		test((fds[0] = open(paths[i], O_WRONLY | O_CREAT | O_EXCL, 0600)) >= 0);
+		for (n = i == 39 ? 300000 : i * i * 13; n; n -= (size_t)r)
+			test((r = write(fds[0], buf, n < 8000 ? n : 8000)) > 0);
+		close(fds[0]);
+	}
+	test(libsha2_sum_paths(paths, 41, LIBSHA2_512, mout, errs, 3) == -1 && errno == ENOENT);
+	test(errs[40] == ENOENT);
+	errno = 0;
+	for (i = 0; i < 40; i++) {
+		test(!errs[i]);
+		test((sfds[i] = open(paths[i], O_RDONLY)) >= 0);
+	}
+	test(!libsha2_sum_fds(sfds, 40, LIBSHA2_256, kout, NULL, 0));
+	for (i = 0; i < 40; i++) {
+		close(sfds[i]);
+		test(!libsha2_init(&s, LIBSHA2_512));
+		for (n = i == 39 ? 300000 : i * i * 13; n; n -= len) {
+			len = n < 8000 ? n : 8000;
+			libsha2_update(&s, buf, len * 8);
+		}
+		libsha2_digest(&s, NULL, 0, str);
+		test(!memcmp(str, mout[i], 64));
+		test(!libsha2_init(&s, LIBSHA2_256));
+		for (n = i == 39 ? 300000 : i * i * 13; n; n -= len) {
+			len = n < 8000 ? n : 8000;
+			libsha2_update(&s, buf, len * 8);
+		}
+		libsha2_digest(&s, NULL, 0, str);
+		test(!memcmp(str, &((char *)kout)[i * 32], 32));
+		test(!unlink(paths[i]));
+	}
+	test(!rmdir(dir));
+
+	memcpy(&dir[sizeof(dir) - 7], "XXXXXX", 6);
+	test(mkdtemp(dir));
+	sprintf(paths_buf[0], "%s/a", dir);
+	sprintf(paths_buf[1], "%s/b", dir);
+	sprintf(paths_buf[2], "%s/b/c", dir);
+	sprintf(paths_buf[3], "%s/l", dir);
+	test((fds[0] = open(paths_buf[0], O_WRONLY | O_CREAT | O_EXCL, 0600)) >= 0);
+	test(write(fds[0], "a", 1) == 1);
 	close(fds[0]);
-	libsha2_behex_lower(str, buf, libsha2_algorithm_output_size(LIBSHA2_256));
-	test_str(str, "c2e686823489ced2017f6059b8b239318b6364f6dcd835d0a519105a1eadd6e4");
+	test(!mkdir(paths_buf[1], 0700));
+	test((fds[0] = open(paths_buf[2], O_WRONLY | O_CREAT | O_EXCL, 0600)) >= 0);
+	close(fds[0]);
+	test(!symlink("a", paths_buf[3]));
+	test(!chmod(dir, 0755));
+	test(!chmod(paths_buf[0], 0644));
+	test(!chmod(paths_buf[1], 0700));
+	test(!libsha2_sum_tree(dir, LIBSHA2_256, buf, 1));
+	libsha2_behex_lower(str, buf, 32);
+	test_str(str, "bd25220c4761873a47ca8f17f03400a7fd8b7a0a1f31a7873000fc17425f5d1b");
+	test(!libsha2_sum_tree(dir, LIBSHA2_256, buf, 0));
+	libsha2_behex_lower(str, buf, 32);
+	test_str(str, "bd25220c4761873a47ca8f17f03400a7fd8b7a0a1f31a7873000fc17425f5d1b");
+	test(!chmod(paths_buf[0], 0600));
+	test(!libsha2_sum_tree(dir, LIBSHA2_256, buf, 0));
+	libsha2_behex_lower(str, buf, 32);
+	test(strcmp(str, "bd25220c4761873a47ca8f17f03400a7fd8b7a0a1f31a7873000fc17425f5d1b"));
+	test(!unlink(paths_buf[3]));
+	test(!unlink(paths_buf[2]));
+	test(!rmdir(paths_buf[1]));
+	test(!unlink(paths_buf[0]));
+	test(!rmdir(dir));
+	test(libsha2_sum_tree(dir, LIBSHA2_256, buf, 0) == -1 && errno == ENOENT);
+	errno = 0;
+
+	memcpy(&dir[sizeof(dir) - 7], "XXXXXX", 6);
+	test(mkdtemp(dir));
+	sprintf(paths_buf[0], "%s/cache", dir);
+	sprintf(paths_buf[1], "%s/f", dir);
+	sprintf(paths_buf[2], "%s/g", dir);
+	sprintf(paths_buf[3], "%s/bad", dir);
+	for (i = 0; i < sizeof(cache_data); i++)
+		cache_data[i] = (unsigned char)(i * 7 + 1);
+	for (i = 1; i < 4; i++) {
+		test((fds[0] = open(paths_buf[i], O_WRONLY | O_CREAT | O_EXCL, 0600)) >= 0);
+		test(write(fds[0], &cache_data[i], 5000 * i) == (ssize_t)(5000 * i));
+		close(fds[0]);
+	}
+	libsha2_hash(LIBSHA2_256, &cache_data[1], 5000 * 8, mout[0]);
+	libsha2_hash(LIBSHA2_512, &cache_data[1], 5000 * 8, mout[1]);
+	libsha2_hash(LIBSHA2_256, &cache_data[2], 10000 * 8, mout[2]);
+	libsha2_hash(LIBSHA2_512, &cache_data[2], 10000 * 8, mout[3]);
+	test(libsha2_cache_open(&cache, paths_buf[3]) == -1 && errno == EINVAL);
+	errno = 0;
+	test(!libsha2_cache_open(&cache, paths_buf[0]));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64);
+	/* The test build stores files however recently
+	 * they were modified, see the Makefile */
+	test((sfds[0] = open(paths_buf[1], O_RDWR)) >= 0);
+	test((sfds[1] = open(paths_buf[2], O_RDONLY)) >= 0);
+	test(lseek(sfds[0], 100, SEEK_SET) == 100);
+	test(!libsha2_cache_sum_fd(&cache, sfds[0], LIBSHA2_256, mout[4]));
+	test(!memcmp(mout[4], mout[0], 32));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 128);
+	test(!libsha2_cache_sum_fd(&cache, sfds[0], LIBSHA2_256, mout[4]));
+	test(!memcmp(mout[4], mout[0], 32));
+	test(!libsha2_cache_sum_fd(&cache, sfds[0], LIBSHA2_512, mout[4]));
+	test(!memcmp(mout[4], mout[1], 64));
+	test(!libsha2_cache_sum_fd(&cache, sfds[1], LIBSHA2_256, mout[4]));
+	test(!memcmp(mout[4], mout[2], 32));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 3 * 128);
+	/* A modified file is hashed again */
+	test(pwrite(sfds[0], "x", 1, 0) == 1);
+	memcpy(cache_copy, &cache_data[1], 5000);
+	cache_copy[0] = 'x';
+	libsha2_hash(LIBSHA2_256, cache_copy, 5000 * 8, mout[0]);
+	test(!libsha2_cache_sum_fd(&cache, sfds[0], LIBSHA2_256, mout[4]));
+	test(!memcmp(mout[4], mout[0], 32));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 4 * 128);
+	/* Records after damage are found again by compaction,
+	 * which also removes all but the latest for each file */
+	test((fds[0] = open(paths_buf[0], O_WRONLY | O_APPEND)) >= 0);
+	test(write(fds[0], "damage", 6) == 6);
+	close(fds[0]);
+	test(!libsha2_cache_sum_fd(&cache, sfds[1], LIBSHA2_512, mout[4]));
+	test(!memcmp(mout[4], mout[3], 64));
+	test(!libsha2_cache_sum_fd(&cache, sfds[1], LIBSHA2_512, mout[4]));
+	test(!memcmp(mout[4], mout[3], 64));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 6 * 128 + 6);
+	test(!libsha2_cache_compact(paths_buf[0]));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 4 * 128);
+	test(!libsha2_cache_sum_fd(&cache, sfds[1], LIBSHA2_512, mout[4]));
+	test(!memcmp(mout[4], mout[3], 64));
+	test(!libsha2_cache_sum_fd(&cache, sfds[0], LIBSHA2_512, mout[4]));
+	test(memcmp(mout[4], mout[1], 64));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 5 * 128);
+	libsha2_cache_close(&cache);
+	test(!libsha2_cache_open(&cache, paths_buf[0]));
+	test(!libsha2_cache_sum_fd(&cache, sfds[1], LIBSHA2_256, mout[4]));
+	test(!memcmp(mout[4], mout[2], 32));
+	test(!stat(paths_buf[0], &attr) && attr.st_size == 64 + 5 * 128);
+	libsha2_cache_close(&cache);
+	close(sfds[0]);
+	close(sfds[1]);
+	for (i = 0; i < 4; i++)
+		test(!unlink(paths_buf[i]));
+	test(!rmdir(dir));
 
 	test_bits("01", 1, LIBSHA2_224, "0d05096bca2a4a77a2b47a05a59618d01174b37892376135c1b6e957");
 	test_bits("02", 2, LIBSHA2_224, "ef9c947a47bb9311a0f2b8939cfc12090554868b3b64d8f71e6442f3");
@@ -393,6 +1137,36 @@ main(int argc, char *argv[])
 		test_str(str, "f7bc83f430538424b13298e6aa6fb143ef4d59a14946175997479dbc2d1a3cd8");
 	}
 
+	/* Version 0 of the marshalled HMAC format stored the pads, and
+	 * left the hash function uninitialised until data was fed */
+	for (i = 0; i < 2; i++) {
+		memset(str, 0x36, 64);
+		memset(&str[64], 0x5C, 64);
+		for (j = 0; j < 3; j++) {
+			str[j] ^= "key"[j];
+			str[64 + j] ^= "key"[j];
+		}
+		test(!libsha2_init(&s, LIBSHA2_256));
+		if (i) {
+			libsha2_update(&s, str, 64 * 8);
+			libsha2_update(&s, "The quick brown fox ", 20 * 8);
+		}
+		*(int *)buf = 0;
+		len = sizeof(int);
+		len += libsha2_marshal(&s, &buf[len]);
+		*(size_t *)&buf[len] = 256;
+		len += sizeof(size_t);
+		buf[len++] = (char)i;
+		memcpy(&buf[len], str, 128);
+		len += 128;
+		memset(&hs, 0, sizeof(hs));
+		test(libsha2_hmac_unmarshal(&hs, buf, len) == len);
+		libsha2_hmac_digest(&hs, &"The quick brown fox jumps over the lazy dog"[i ? 20 : 0],
+		                    (i ? 23 : 43) << 3, buf);
+		libsha2_behex_lower(str, buf, libsha2_hmac_state_output_size(&hs));
+		test_str(str, "f7bc83f430538424b13298e6aa6fb143ef4d59a14946175997479dbc2d1a3cd8");
+	}
+
 	test(!errno);
 
 	test_hmac(LIBSHA2_224,
@@ -458,5 +1232,169 @@ main(int argc, char *argv[])
 	          "d93ec8d2de1ad2a9957cb9b83f14e76ad6b5e0cce285079a127d3b14bccb7aa7286d4ac0d4ce64215f2bc9e6870b33d97438be4aaa20cda5c5a912b48b8e27f3");
 #endif
 
+#if TEST_SHA256
+	test_pbkdf2(LIBSHA2_256, "password", "salt", 1,
+	            "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+	test_pbkdf2(LIBSHA2_256, "password", "salt", 2,
+	            "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43");
+	test_pbkdf2(LIBSHA2_256, "password", "salt", 4096,
+	            "c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a");
+	test_pbkdf2(LIBSHA2_256, "passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096,
+	            "348c89dbcbd32b2f32d814b8116e84cf2b17347ebc1800181c4e2a1fb8dd53e1c635518c7dac47e9");
+	test_pbkdf2(LIBSHA2_256, "pass\0word", "sa\0lt", 4096,
+	            "89b69d0516f829893c696226650a8687");
+	test_pbkdf2(LIBSHA2_256, "passwd", "salt", 1,
+	            "55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc"
+	            "49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783");
+#endif
+
+#if TEST_SHA512
+	test_pbkdf2(LIBSHA2_512, "password", "salt", 1,
+	            "867f70cf1ade02cff3752599a3a53dc4af34c7a669815ae5d513554e1c8cf252"
+	            "c02d470a285a0501bad999bfe943c08f050235d7d68b1da55e63f73b60a57fce");
+	test_pbkdf2(LIBSHA2_512, "password", "salt", 2,
+	            "e1d9c16aa681708a45f5c7c4e215ceb66e011a2e9f0040713f18aefdb866d53c"
+	            "f76cab2868a39b9f7840edce4fef5a82be67335c77a6068e04112754f27ccf4e");
+#endif
+
+	for (j = 0; j < 6; j++) {
+		for (i = 0; i < 20; i++) {
+			msgs[i] = &"0123456789abcdefghijklmnopqrstuvwxyz"[i];
+			msglens[i] = i % 7 * 3;
+			msgs[40 + i] = &"zyxwvutsrqponmlkjihgfedcba9876543210"[i];
+			msglens[40 + i] = i % 5 * 4;
+		}
+		for (n = 0; n < 4; n++) {
+			i = ((const size_t []){0, 1, 3, 20})[n];
+			test(!libsha2_pbkdf2_many((enum libsha2_algorithm)j, msgs, msglens, &msgs[40], &msglens[40], 3, mout, 100, i));
+			for (k = 0; k < i; k++) {
+				test(!libsha2_pbkdf2((enum libsha2_algorithm)j, msgs[k], msglens[k], msgs[40 + k], msglens[40 + k],
+				                     3, str, 100));
+				test(!memcmp(str, &((char *)mout)[k * 100], 100));
+			}
+		}
+	}
+	test(libsha2_pbkdf2(LIBSHA2_256, "", 0, "", 0, 0, buf, 32) == -1 && errno == EINVAL);
+	errno = 0;
+	test(libsha2_pbkdf2((enum libsha2_algorithm)6, "", 0, "", 0, 1, buf, 32) == -1 && errno == EINVAL);
+	errno = 0;
+
+#if TEST_SHA256
+	test_hkdf(LIBSHA2_256,
+	          "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+	          "000102030405060708090a0b0c",
+	          "f0f1f2f3f4f5f6f7f8f9",
+	          "077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5",
+	          "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865");
+	test_hkdf(LIBSHA2_256,
+	          "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+	          "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+	          "404142434445464748494a4b4c4d4e4f",
+	          "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+	          "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+	          "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf",
+	          "b0b1b2b3b4b5b6b7b8b9babbbcbdbebfc0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+	          "d0d1d2d3d4d5d6d7d8d9dadbdcdddedfe0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+	          "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",
+	          "06a6b88c5853361a06104c9ceb35b45cef760014904671014a193f40c15fc244",
+	          "b11e398dc80327a1c8e7f78c596a49344f012eda2d4efad8a050cc4c19afa97c"
+	          "59045a99cac7827271cb41c65e590e09da3275600c2f09b8367793a9aca3db71"
+	          "cc30c58179ec3e87c14c01d5c1f3434f1d87");
+	test_hkdf(LIBSHA2_256,
+	          "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b",
+	          "",
+	          "",
+	          "19ef24a32c717b167f33a91d6f648bdf96596776afdb6377ac434c1c293ccb04",
+	          "8da4e775a563c18f715f802a063c5a31b8a11f5c5ee1879ec3454e5f3c738d2d9d201395faa4b61a96c8");
+	test(libsha2_hkdf_expand(&hk, "", 0, buf, 255 * 32 + 1) == -1 && errno == EINVAL);
+	errno = 0;
+#endif
+
+#if TEST_SHA512
+	test_hkdf(LIBSHA2_512, "696b6d", "73616c74", "696e666f",
+	          "56cc15664b2dcaa57ae910751a1c03a80768a7abb0d4bf491d99d7949bc2c3a7"
+	          "7d423e8b8c91379f35b9966744d12fbb4440f42bbaa0159fc78cd635983cb506",
+	          "f8666bd3fdd88840c947614272dd065c71c541b0de03ff738644dffc3facec64"
+	          "6317f3819f453c7f0c4b4fb70680b07f020c3e26ce190895b104a4f8d4770f07"
+	          "6ab726fd6ad78fc6cfd7a5faa507fb5f45a3b0594b286d665b4d31fe8b1325a2"
+	          "010263e3");
+#endif
+
+	for (j = 0; j < 6; j++) {
+		test(!libsha2_hkdf_extract(&hk, (enum libsha2_algorithm)j, "salt", 4, "ikm", 3, NULL));
+		for (i = 0; i < 80; i++) {
+			msgs[i] = &buf[i * 7];
+			msglens[i] = i == 7 ? 300 : i * 13 % 70;
+			kouts[i] = kout[i];
+			outlens[i] = i % 3 ? i * 37 % 40 : i * 37 % 200 + 1;
+		}
+		test(!libsha2_hkdf_expand_many(&hk, msgs, msglens, kouts, outlens, 80));
+		for (i = 0; i < 80; i++) {
+			test(!libsha2_hkdf_expand(&hk, msgs[i], msglens[i], str, outlens[i]));
+			test(!memcmp(str, kout[i], outlens[i]));
+		}
+	}
+
+#if TEST_SHA256
+	test_crypt("Hello world!", "$5$saltstring",
+	           "$5$saltstring$5B8vYYiY.CVt1RlTTf8KbXBH3hsxY/GNooZaBBGWEc5");
+	test_crypt("Hello world!", "$5$rounds=10000$saltstringsaltstring",
+	           "$5$rounds=10000$saltstringsaltst$3xv.VbSHBb41AL9AvLeujZkZRBAwqFMz2.opqey6IcA");
+	test_crypt("This is just a test", "$5$rounds=5000$toolongsaltstring",
+	           "$5$rounds=5000$toolongsaltstrin$Un/5jzAHMgOGZ5.mWJpuVolil07guHPvOW8mGRcvxa5");
+	test_crypt("we have a short salt string but not a short password", "$5$rounds=77777$short",
+	           "$5$rounds=77777$short$JiO1O3ZpDAxGJeaDIuqCoEFysAe1mZNJRs3pw0KQRd/");
+	test(!libsha2_crypt("the minimum number is still observed", "$5$rounds=10$roundstoolow", str));
+	test_str(str, "$5$rounds=1000$roundstoolow$yfvwcWrQ8l/K0DAWyuPMDNHpIVlTQebY9l/gL972bIC");
+	memset(buf, 'x', 256);
+	buf[256] = '\0';
+	test_crypt(buf, "$5$rounds=1000$",
+	           "$5$rounds=1000$$NXUzZCFCbqA2PgLSTe09G3igO0.wC5W3EMT2MwLK7N1");
+#endif
+
+#if TEST_SHA512
+	test_crypt("Hello world!", "$6$saltstring",
+	           "$6$saltstring$svn8UoSVapNtMuq1ukKS4tPQd8iKwSMHWjl/O817G3uBnIFNjnQJuesI68u4OTLiBFdcbYEdFCoEOfaS35inz1");
+	test_crypt("Hello world!", "$6$rounds=10000$saltstringsaltstring",
+	           "$6$rounds=10000$saltstringsaltst$OW1/O6BYHV6BcXZu8QVeXbDWra3Oeqh0sbHbbMCVNSnCM/UrjmM0Dp8vOuZeHBy/"
+	           "YTBmSK6H9qs/y3RnOaw5v.");
+	test_crypt("a very much longer text to encrypt.  This one even stretches over morethan one line.",
+	           "$6$rounds=1400$anotherlongsaltstring",
+	           "$6$rounds=1400$anotherlongsalts$POfYwTEok97VWcjxIiSOjiykti.o/pQs.wPvMxQ6Fm7I6IoYN3CmLs66x9t0oSwbtEW"
+	           "7o7UmJEiDwGqd8p4ur1");
+	test(!libsha2_crypt("the minimum number is still observed", "$6$rounds=10$roundstoolow", str));
+	test_str(str, "$6$rounds=1000$roundstoolow$kUMsbe306n21p9R.FRkW3IGn.S9NPN0x50YhH1xhLsPuWGsUSklZt58jaTfF4ZEQpyUNGc0dq"
+	              "bpBYYBaHHrsX.");
+	test_crypt("", "$6$salt$",
+	           "$6$salt$r6qPcj2UeIkfklWHvleGJk8OKTInFYR/fxyuwcC656IWiZBpIFZ9.hMRG2ZQnnyMFrKOe461f9iT9Ljn0wJ5l.");
+	memset(buf, 'x', 256);
+	buf[256] = '\0';
+	test_crypt(buf, "$6$rounds=1000$",
+	           "$6$rounds=1000$$gPEVq7U6vTxxIClLam5W/iVIKCDB439oUpbM8rfWrLvVVk4K7KlnOVYFeICaHzfGrfmG71BVQWC196xoLG9rD.");
+#endif
+
+	test(libsha2_crypt("", "$1$salt", str) == -1 && errno == EINVAL);
+	errno = 0;
+	memset(buf, 'x', 257);
+	buf[257] = '\0';
+	test(libsha2_crypt(buf, "$5$salt", str) == -1 && errno == EINVAL);
+	errno = 0;
+
+	for (i = 0; i < 40; i++) {
+		memset(kout[i], 'a' + (int)i % 26, i * 7 % 40);
+		kout[i][i * 7 % 40] = '\0';
+		phrases[i] = kout[i];
+		settings[i] = crypt_settings[i % 6];
+	}
+	test(!libsha2_crypt_many(phrases, settings, buf, 40));
+	for (i = 0; i < 40; i++) {
+		if (i % 6 == 4) {
+			test_str(&buf[i * LIBSHA2_CRYPT_SIZE], "*1");
+			continue;
+		}
+		test(!libsha2_crypt(phrases[i], settings[i], str));
+		test_str(&buf[i * LIBSHA2_CRYPT_SIZE], str);
+	}
+
 	return 0;
 }
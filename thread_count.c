@@ -0,0 +1,14 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+size_t
+libsha2_thread_count(size_t threads)
+{
+	long int cpus;
+
+	if (threads)
+		return threads;
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return cpus > 0 ? (size_t)cpus : 1;
+}
@@ -6,7 +6,7 @@ size_t
 libsha2_unmarshal(struct libsha2_state *restrict state, const void *restrict buf_, size_t bufsize)
 {
 	const char *restrict buf = buf_;
-	size_t off = 0;
+	size_t off = 0, skip;
 	int version;
 
 	if (bufsize < sizeof(int) + sizeof(enum libsha2_algorithm) + sizeof(size_t)) {
@@ -15,7 +15,7 @@ libsha2_unmarshal(struct libsha2_state *restrict state, const void *restrict buf
 	}
 
 	version = *(const int *)buf;
-	if (version < 0 || version > 1) { /* version */
+	if (version < 0 || version > 2) { /* version */
 		errno = EINVAL;
 		return 0;
 	}
@@ -29,15 +29,13 @@ libsha2_unmarshal(struct libsha2_state *restrict state, const void *restrict buf
 	switch (state->algorithm) {
 	case LIBSHA2_224:
 	case LIBSHA2_256:
-		if (bufsize - off < sizeof(state->k.b32) + sizeof(state->w.b32) + sizeof(state->h.b32)) {
+		/* Versions before 2 stored the round constants, and version 0 also stored the words */
+		skip = (size_t)(2 - version) * 64 * sizeof(*state->h.b32);
+		if (bufsize - off < skip + sizeof(state->h.b32)) {
 			errno = EINVAL;
 			return 0;
 		}
-		memcpy(state->k.b32, &buf[off], sizeof(state->k.b32));
-		off += sizeof(state->k.b32);
-		memset(state->w.b32, 0, sizeof(state->w.b32));
-		if (version == 0)
-			off += sizeof(state->w.b32);
+		off += skip;
 		memcpy(state->h.b32, &buf[off], sizeof(state->h.b32));
 		off += sizeof(state->h.b32);
 		break;
@@ -46,15 +44,13 @@ libsha2_unmarshal(struct libsha2_state *restrict state, const void *restrict buf
 	case LIBSHA2_512:
 	case LIBSHA2_512_224:
 	case LIBSHA2_512_256:
-		if (bufsize - off < sizeof(state->k.b64) + sizeof(state->w.b64) + sizeof(state->h.b64)) {
+		/* Versions before 2 stored the round constants, and version 0 also stored the words */
+		skip = (size_t)(2 - version) * 80 * sizeof(*state->h.b64);
+		if (bufsize - off < skip + sizeof(state->h.b64)) {
 			errno = EINVAL;
 			return 0;
 		}
-		memcpy(state->k.b64, &buf[off], sizeof(state->k.b64));
-		off += sizeof(state->k.b64);
-		memset(state->w.b64, 0, sizeof(state->w.b64));
-		if (version == 0)
-			off += sizeof(state->w.b64);
+		off += skip;
 		memcpy(state->h.b64, &buf[off], sizeof(state->h.b64));
 		off += sizeof(state->h.b64);
 		break;
@@ -70,6 +66,10 @@ libsha2_unmarshal(struct libsha2_state *restrict state, const void *restrict buf
 	}
 	state->chunk_size = *(const size_t *)&buf[off];
 	off += sizeof(size_t);
+	if (state->chunk_size != (state->algorithm <= LIBSHA2_256 ? 64U : 128U)) {
+		errno = EINVAL;
+		return 0;
+	}
 
 	if (bufsize - off < (state->message_size / 8) % state->chunk_size) {
 		errno = EINVAL;
@@ -0,0 +1,146 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#ifndef _WIN32
+# include <sys/mman.h>
+#endif
+
+
+#ifndef _WIN32
+/**
+ * The number of bytes that are mapped into memory at a time
+ * when hashing a regular file, a multiple of the page size
+ */
+# define MMAP_WINDOW ((size_t)8 << 20)
+
+/**
+ * Files with fewer bytes left than this are read
+ * rather than mapped, as the mapping costs more than
+ * the copying saves
+ */
+# define MMAP_MIN ((off_t)256 << 10)
+
+
+/**
+ * Hash the rest of a regular file from the page cache,
+ * mapping it into memory a window at a time, rather
+ * than reading it
+ * 
+ * If the file cannot be mapped, nothing is hashed,
+ * and the file is left to be read instead
+ * 
+ * @param   state  The hashing state
+ * @param   fd     The file descriptor of the file
+ * @param   size   The size of the file
+ * @param   flags  Bitwise OR of `LIBSHA2_MAP_POPULATE`
+ *                 and `LIBSHA2_MAP_HUGEPAGE`, or 0
+ * @return         Zero on success, -1 on error
+ */
+static int
+sum_mapped(struct libsha2_state *restrict state, int fd, off_t size, int flags)
+{
+	off_t pos, start;
+	size_t len, skip, page;
+	long int r;
+	char *map;
+
+	pos = lseek(fd, 0, SEEK_CUR);
+	if (pos < 0 || size - pos < MMAP_MIN)
+		return 0;
+
+	r = sysconf(_SC_PAGESIZE);
+	page = r > 0 ? (size_t)r : 4096;
+
+	while (pos < size) {
+		skip = (size_t)(pos % (off_t)page);
+		start = pos - (off_t)skip;
+		len = (uintmax_t)(size - start) < MMAP_WINDOW ? (size_t)(size - start) : MMAP_WINDOW;
+# ifdef MAP_POPULATE
+		map = mmap(NULL, len, PROT_READ, MAP_PRIVATE | ((flags & LIBSHA2_MAP_POPULATE) ? MAP_POPULATE : 0), fd, start);
+# else
+		map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, start);
+# endif
+		if (map == MAP_FAILED)
+			break;
+# ifdef MADV_SEQUENTIAL
+		madvise(map, len, MADV_SEQUENTIAL);
+# endif
+# ifdef MADV_HUGEPAGE
+		if (flags & LIBSHA2_MAP_HUGEPAGE)
+			madvise(map, len, MADV_HUGEPAGE);
+# endif
+		libsha2_update(state, &map[skip], (len - skip) * 8);
+		munmap(map, len);
+		pos = start + (off_t)len;
+	}
+
+	/* Leave the file offset where a read(3) loop would have,
+	 * so that anything appended since fstat(3) is read */
+	return lseek(fd, pos, SEEK_SET) < 0 ? -1 : 0;
+}
+#endif
+
+
+int
+libsha2_update_fd(struct libsha2_state *restrict state, int fd, int flags)
+{
+	ssize_t r;
+#ifndef _WIN32
+	struct stat attr;
+#endif
+	size_t blksize = 4096;
+	char *restrict chunk;
+
+#ifndef _WIN32
+	if (fstat(fd, &attr) == 0) {
+		if (attr.st_blksize > 0)
+			blksize = (size_t)(attr.st_blksize);
+		if ((flags & LIBSHA2_MAP) && S_ISREG(attr.st_mode) && sum_mapped(state, fd, attr.st_size, flags))
+			return -1;
+	}
+#else
+	(void) flags;
+#endif
+
+#if ALLOCA_LIMIT > 0
+	if (blksize > (size_t)ALLOCA_LIMIT) {
+		blksize = (size_t)ALLOCA_LIMIT;
+		blksize -= blksize % sizeof(((struct libsha2_state)NULL)->chunk);
+		if (!blksize)
+			blksize = sizeof(((struct libsha2_state)NULL)->chunk);
+	}
+# if defined(__clang__)
+	/* We are using a limit so it's just like declaring an array
+	 * in a function, except we might use less of the stack. */
+#  pragma clang diagnostic push
+#  pragma clang diagnostic ignored "-Walloca"
+# endif
+	chunk = alloca(blksize);
+# if defined(__clang__)
+#  pragma clang diagnostic pop
+# endif
+#else
+	chunk = malloc(blksize);
+	if (!chunk)
+		return -1;
+#endif
+
+	for (;;) {
+		r = read(fd, chunk, blksize);
+		if (r <= 0) {
+			if (!r)
+				break;
+			if (errno == EINTR)
+				continue;
+#if ALLOCA_LIMIT <= 0
+			free(chunk);
+#endif
+			return -1;
+		}
+		libsha2_update(state, chunk, (size_t)r * 8);
+	}
+
+#if ALLOCA_LIMIT <= 0
+	free(chunk);
+#endif
+	return 0;
+}
@@ -0,0 +1,9 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_verity_build(const struct libsha2_verity *restrict verity, const void *data, void *tree, void *root, size_t threads)
+{
+	return libsha2_verity_tree(verity, data, -1, tree, root, threads);
+}
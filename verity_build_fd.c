@@ -0,0 +1,9 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_verity_build_fd(const struct libsha2_verity *restrict verity, int fd, void *tree, void *root, size_t threads)
+{
+	return libsha2_verity_tree(verity, NULL, fd, tree, root, threads);
+}
@@ -0,0 +1,35 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+void
+libsha2_verity_hash(const struct libsha2_verity *restrict verity, const void *const *blocks, size_t n, unsigned char *out)
+{
+	union libsha2_hash_values hs[LIBSHA2_BATCH_SIZE];
+	size_t msglens[LIBSHA2_BATCH_SIZE];
+	unsigned char outputs[LIBSHA2_BATCH_SIZE * 64];
+	struct libsha2_state state;
+	enum libsha2_algorithm algorithm = verity->salted.algorithm;
+	size_t i, outsize = libsha2_algorithm_output_size(algorithm);
+
+	/* The salted state can only be shared by the lanes
+	 * if the salt fills a whole number of chunks */
+	if (!((verity->salted.message_size / 8) % verity->salted.chunk_size) && libsha2_multi_lanes(algorithm) > 2) {
+		for (i = 0; i < n; i++) {
+			hs[i] = verity->salted.h;
+			msglens[i] = verity->block_size * 8;
+		}
+		libsha2_digest_batch(hs, verity->salted.message_size, algorithm, blocks, msglens, n, outputs);
+	} else {
+		for (i = 0; i < n; i++) {
+			state = verity->salted;
+			libsha2_update(&state, blocks[i], verity->block_size * 8);
+			libsha2_digest(&state, NULL, 0, &outputs[i * outsize]);
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		memcpy(&out[i * verity->digest_stride], &outputs[i * outsize], outsize);
+		memset(&out[i * verity->digest_stride + outsize], 0, verity->digest_stride - outsize);
+	}
+}
@@ -0,0 +1,82 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_verity_init(struct libsha2_verity *restrict verity, enum libsha2_verity_format format,
+                    enum libsha2_algorithm algorithm, size_t block_size, const void *salt, size_t salt_size,
+                    uint_least64_t data_size, uint_least64_t *tree_size)
+{
+	unsigned char padding[128];
+	uint_least64_t n, hashes_per_block;
+	size_t level, outsize, pad;
+
+	if (libsha2_init(&verity->salted, algorithm))
+		return -1;
+	outsize = libsha2_algorithm_output_size(algorithm);
+
+	if (block_size < (format == LIBSHA2_VERITY_FS ? 1024U : 512U) || block_size > 65536UL ||
+	    (block_size & (block_size - 1)))
+		goto einval;
+	if (format == LIBSHA2_VERITY_FS) {
+		if ((algorithm != LIBSHA2_256 && algorithm != LIBSHA2_512) || salt_size > sizeof(verity->salt))
+			goto einval;
+	} else if (format == LIBSHA2_VERITY_DM) {
+		if (!data_size || salt_size > 256)
+			goto einval;
+	} else {
+		goto einval;
+	}
+
+	/* fs-verity pads the salt to a whole chunk, so the salted state
+	 * can be shared by the hashes in a batch; dm-verity does not */
+	if (salt_size)
+		libsha2_update(&verity->salted, salt, salt_size * 8);
+	memset(verity->salt, 0, sizeof(verity->salt));
+	if (format == LIBSHA2_VERITY_FS && salt_size) {
+		memcpy(verity->salt, salt, salt_size);
+		pad = verity->salted.chunk_size - salt_size % verity->salted.chunk_size;
+		memset(padding, 0, pad);
+		libsha2_update(&verity->salted, padding, pad * 8);
+	}
+
+	/* Hashes are padded to a power of 2, so that a whole
+	 * number of them fit in a block (dm-verity) */
+	for (verity->digest_stride = 1; verity->digest_stride < outsize; verity->digest_stride <<= 1);
+	hashes_per_block = block_size / verity->digest_stride;
+
+	verity->format = format;
+	verity->block_size = block_size;
+	verity->salt_size = salt_size;
+	verity->data_size = data_size;
+	verity->data_blocks = data_size / block_size + !!(data_size % block_size);
+
+	/* Levels are added until one block holds all hashes of the
+	 * level below, so there is no tree for a single data block */
+	verity->levels = 0;
+	for (n = verity->data_blocks; n > 1;) {
+		if (verity->levels == LIBSHA2_VERITY_MAX_LEVELS) {
+			errno = EFBIG;
+			return -1;
+		}
+		n = n / hashes_per_block + !!(n % hashes_per_block);
+		verity->level_blocks[verity->levels++] = n;
+	}
+
+	/* The tree is stored with the top level first */
+	verity->tree_blocks = 0;
+	for (level = verity->levels; level--;) {
+		verity->level_start[level] = verity->tree_blocks;
+		verity->tree_blocks += verity->level_blocks[level];
+	}
+	if (verity->tree_blocks > SIZE_MAX / block_size) {
+		errno = EFBIG;
+		return -1;
+	}
+	*tree_size = verity->tree_blocks * block_size;
+	return 0;
+
+einval:
+	errno = EINVAL;
+	return -1;
+}
@@ -0,0 +1,213 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#include <stdatomic.h>
+
+
+/**
+ * The work shared by the workers while a level is hashed
+ */
+struct pool {
+	/**
+	 * The parameters of the tree
+	 */
+	const struct libsha2_verity *verity;
+
+	/**
+	 * The blocks to hash, if in memory
+	 */
+	const unsigned char *source;
+
+	/**
+	 * The file descriptor of the data, if the data
+	 * blocks are hashed and `.source` is `NULL`
+	 */
+	int fd;
+
+	/**
+	 * Whether the data blocks are hashed, rather
+	 * than the blocks of a level of the tree
+	 */
+	int is_data;
+
+	/**
+	 * The number of blocks to hash
+	 */
+	uint_least64_t n;
+
+	/**
+	 * Output buffer for the hashes
+	 */
+	unsigned char *out;
+
+	/**
+	 * The index of the next group of blocks to claim
+	 */
+	atomic_uint_least64_t next;
+
+	/**
+	 * The error of the first worker that failed, 0 if none has
+	 */
+	atomic_int error;
+};
+
+
+/**
+ * Read data blocks from the file, padding the last block
+ * 
+ * @param   pool   The work
+ * @param   buf    Output buffer for the blocks
+ * @param   first  The index of the first block
+ * @param   n      The number of blocks
+ * @return         Zero on success, -1 on error
+ */
+static int
+read_blocks(struct pool *pool, unsigned char *buf, uint_least64_t first, size_t n)
+{
+	const struct libsha2_verity *verity = pool->verity;
+	uint_least64_t off = first * verity->block_size;
+	size_t len = n * verity->block_size, got = 0;
+	ssize_t r;
+
+	if (verity->data_size - off < len) {
+		memset(&buf[verity->data_size - off], 0, len - (size_t)(verity->data_size - off));
+		len = (size_t)(verity->data_size - off);
+	}
+	while (got < len) {
+		r = pread(pool->fd, &buf[got], len - got, (off_t)(off + got));
+		if (r <= 0) {
+			if (!r)
+				errno = EIO;
+			else if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		got += (size_t)r;
+	}
+	return 0;
+}
+
+
+/**
+ * Claim and hash groups of blocks until there are none left
+ * 
+ * @param   pool_  The work, `struct pool *`
+ * @return         `NULL`
+ */
+static void *
+worker(void *pool_)
+{
+	struct pool *pool = pool_;
+	const struct libsha2_verity *verity = pool->verity;
+	const void *blocks[LIBSHA2_BATCH_SIZE];
+	unsigned char *buf = NULL;
+	uint_least64_t first, tail;
+	size_t i, n, bs = verity->block_size;
+	int expected = 0;
+
+	if (pool->is_data) {
+		buf = malloc(pool->source ? bs : LIBSHA2_BATCH_SIZE * bs);
+		if (!buf) {
+			atomic_compare_exchange_strong(&pool->error, &expected, errno);
+			return NULL;
+		}
+	}
+
+	while (!atomic_load(&pool->error)) {
+		first = atomic_fetch_add(&pool->next, 1) * LIBSHA2_BATCH_SIZE;
+		if (first >= pool->n)
+			break;
+		n = pool->n - first < LIBSHA2_BATCH_SIZE ? (size_t)(pool->n - first) : LIBSHA2_BATCH_SIZE;
+
+		if (pool->source) {
+			for (i = 0; i < n; i++)
+				blocks[i] = &pool->source[(first + i) * bs];
+			/* The last data block is padded with zeroes */
+			if (pool->is_data && first + n == pool->n && (tail = verity->data_size % bs)) {
+				memcpy(buf, blocks[n - 1], (size_t)tail);
+				memset(&buf[tail], 0, bs - (size_t)tail);
+				blocks[n - 1] = buf;
+			}
+		} else {
+			if (read_blocks(pool, buf, first, n)) {
+				atomic_compare_exchange_strong(&pool->error, &expected, errno);
+				break;
+			}
+			for (i = 0; i < n; i++)
+				blocks[i] = &buf[i * bs];
+		}
+
+		libsha2_verity_hash(verity, blocks, n, &pool->out[first * verity->digest_stride]);
+	}
+
+	free(buf);
+	return NULL;
+}
+
+
+int
+libsha2_verity_tree(const struct libsha2_verity *restrict verity, const void *data, int fd,
+                    void *tree_, void *root, size_t threads)
+{
+	unsigned char *tree = tree_, hash[64], *block = NULL;
+	struct pool pool;
+	size_t level, bs = verity->block_size;
+	uint_least64_t end, batches;
+	const void *top;
+	ssize_t r;
+	int saved_errno;
+
+	pool.verity = verity;
+	pool.fd = fd;
+	atomic_init(&pool.error, 0);
+
+	/* Each level is hashed in parallel, but
+	 * only once the level below is complete */
+	for (level = 0; level < verity->levels; level++) {
+		pool.is_data = !level;
+		pool.source = level ? &tree[verity->level_start[level - 1] * bs] : data;
+		pool.n = level ? verity->level_blocks[level - 1] : verity->data_blocks;
+		pool.out = &tree[verity->level_start[level] * bs];
+		atomic_init(&pool.next, 0);
+
+		batches = pool.n / LIBSHA2_BATCH_SIZE + 1;
+		libsha2_run_workers(&worker, &pool, threads, batches < SIZE_MAX ? (size_t)batches : SIZE_MAX);
+		if (atomic_load(&pool.error))
+			goto fail;
+
+		end = pool.n * verity->digest_stride;
+		memset(&pool.out[end], 0, (size_t)(verity->level_blocks[level] * bs - end));
+	}
+
+	/* The root hash is the hash of the top block of the tree,
+	 * or of the data block if there is only one */
+	if (verity->levels) {
+		top = &tree[verity->level_start[verity->levels - 1] * bs];
+	} else if (!verity->data_blocks) {
+		memset(root, 0, libsha2_algorithm_output_size(verity->salted.algorithm));
+		return 0;
+	} else {
+		block = calloc(1, bs);
+		if (!block)
+			goto fail_errno;
+		if (data) {
+			memcpy(block, data, (size_t)verity->data_size);
+		} else if ((r = pread(fd, block, (size_t)verity->data_size, 0)) != (ssize_t)verity->data_size) {
+			if (r >= 0)
+				errno = EIO;
+			goto fail_errno;
+		}
+		top = block;
+	}
+	libsha2_verity_hash(verity, &top, 1, hash);
+	memcpy(root, hash, libsha2_algorithm_output_size(verity->salted.algorithm));
+	free(block);
+	return 0;
+
+fail:
+	errno = atomic_load(&pool.error);
+fail_errno:
+	saved_errno = errno;
+	free(block);
+	errno = saved_errno;
+	return -1;
+}
@@ -0,0 +1,51 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+
+
+int
+libsha2_verity_verify(const struct libsha2_verity *restrict verity, const void *root, const void *tree_,
+                      unsigned char *verified, uint_least64_t index, const void *block)
+{
+	const unsigned char *tree = tree_;
+	unsigned char hash[64];
+	uint_least64_t path[LIBSHA2_VERITY_MAX_LEVELS], node;
+	size_t level, i, stride = verity->digest_stride, bs = verity->block_size;
+	size_t hashes_per_block = bs / stride;
+	const void *data = block;
+
+	if (index >= verity->data_blocks) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Each hash is checked against the slot for it in the
+	 * block above, until a block that has already been
+	 * verified, or the root, is reached */
+	for (level = 0;; level++) {
+		libsha2_verity_hash(verity, &data, 1, hash);
+		if (level == verity->levels) {
+			if (memcmp(hash, root, libsha2_algorithm_output_size(verity->salted.algorithm)))
+				goto mismatch;
+			break;
+		}
+		node = verity->level_start[level] + index / hashes_per_block;
+		if (memcmp(&tree[node * bs + (size_t)(index % hashes_per_block) * stride], hash, stride))
+			goto mismatch;
+		if (verified && ((verified[node / 8] >> (node % 8)) & 1))
+			break;
+		path[level] = node;
+		index /= hashes_per_block;
+		data = &tree[node * bs];
+	}
+
+	/* Only blocks whose hash matched are marked,
+	 * so nothing is marked unless the path is authentic */
+	if (verified)
+		for (i = 0; i < level; i++)
+			verified[path[i] / 8] |= (unsigned char)(1 << (path[i] % 8));
+	return 0;
+
+mismatch:
+	errno = EBADMSG;
+	return -1;
+}
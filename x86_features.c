@@ -0,0 +1,53 @@
+/* See LICENSE file for copyright and license details. */
+#include "common.h"
+#ifdef HAVE_X86_AVX2_INTRINSICS
+# include <stdatomic.h>
+
+
+# if defined(__GNUC__)
+__attribute__((__constructor__))
+# endif
+int
+libsha2_x86_features(void)
+{
+	static volatile int ret = -1;
+	static volatile atomic_flag spinlock = ATOMIC_FLAG_INIT;
+	int a, b, c, d, xcr0, have_sse41, have_avx;
+
+	if (ret != -1)
+		return ret;
+
+	while (atomic_flag_test_and_set(&spinlock));
+
+	if (ret != -1)
+		goto out;
+
+	a = 1;
+	c = 0;
+	__asm__ volatile("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(a), "c"(c));
+	have_sse41 = (c & (1 << 19)) && (c & (1 << 9));
+	have_avx = (c & (1 << 27)) && (c & (1 << 28));
+	xcr0 = 0;
+	if (have_avx)
+		__asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(d) : "c"(0));
+	a = 7;
+	c = 0;
+	__asm__ volatile("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(a), "c"(c));
+
+	ret = 0;
+	if (have_sse41 && (b & (1 << 29)))
+		ret |= X86_FEATURE_SHA_NI;
+	if (b & (1 << 8))
+		ret |= X86_FEATURE_BMI2;
+	if ((xcr0 & 0x06) == 0x06 && (b & (1 << 5)))
+		ret |= X86_FEATURE_AVX2;
+	if ((xcr0 & 0xE6) == 0xE6 && (b & (1 << 16)) && (b & (1 << 30)))
+		ret |= X86_FEATURE_AVX512;
+
+out:
+	atomic_flag_clear(&spinlock);
+	return ret;
+}
+
+
+#endif